@@ -30,16 +30,39 @@ const ItemStateTable::ID ItemStateTable::sm_Invalid_Id = static_cast<ItemStateTa
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool ItemState::sOutputStats::operator==(const sOutputStats &other) const
+{
+  return (packets == other.packets && datagrams == other.datagrams && coalesced == other.coalesced && suppressed == other.suppressed && suppressedBytes == other.suppressedBytes &&
+          delayed == other.delayed && dropped == other.dropped && failed == other.failed && queueHighWater == other.queueHighWater);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ItemState::sOutputStats::add(const sOutputStats &other)
+{
+  packets += other.packets;
+  datagrams += other.datagrams;
+  coalesced += other.coalesced;
+  suppressed += other.suppressed;
+  suppressedBytes += other.suppressedBytes;
+  delayed += other.delayed;
+  dropped += other.dropped;
+  failed += other.failed;
+  queueHighWater = qMax(queueHighWater, other.queueHighWater);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool ItemState::operator==(const ItemState &other) const
 {
-  return (state == other.state && activity == other.activity);
+  return (state == other.state && activity == other.activity && output == other.output);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 bool ItemState::operator!=(const ItemState &other) const
 {
-  return (state != other.state || activity != other.activity);
+  return !((*this) == other);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -59,6 +82,38 @@ void ItemState::GetStateName(EnumState state, QString &name)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ItemState::GetStatsText(QString &text) const
+{
+  text.clear();
+
+  if (output.packets != 0)
+  {
+    text = qApp->tr("Sent: %1 packets in %2 datagrams").arg(output.packets).arg(output.datagrams);
+    if (output.datagrams != 0 && output.datagrams != output.packets)
+      text += qApp->tr(" (%1 per datagram)").arg(static_cast<double>(output.packets) / static_cast<double>(output.datagrams), 0, 'f', 1);
+  }
+
+  if (output.coalesced != 0)
+    text += qApp->tr("\nCoalesced: %1 packets").arg(output.coalesced);
+
+  if (output.suppressed != 0)
+    text += qApp->tr("\nUnchanged, not sent: %1 packets (%2 bytes)").arg(output.suppressed).arg(output.suppressedBytes);
+
+  if (output.delayed != 0)
+    text += qApp->tr("\nRate limited: %1 packets delayed").arg(output.delayed);
+
+  if (output.dropped != 0)
+    text += qApp->tr("\nQueue full: %1 packets dropped").arg(output.dropped);
+
+  if (output.failed != 0)
+    text += qApp->tr("\nSend failed: %1 packets lost").arg(output.failed);
+
+  if (output.queueHighWater != 0)
+    text += qApp->tr("\nQueue high water: %1 packets").arg(output.queueHighWater);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ItemState::GetStateColor(EnumState state, QColor &color)
 {
   switch (state)
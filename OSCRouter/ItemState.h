@@ -42,6 +42,23 @@ public:
     STATE_COUNT
   };
 
+  struct sOutputStats
+  {
+    bool operator==(const sOutputStats &other) const;
+    bool operator!=(const sOutputStats &other) const { return !((*this) == other); }
+    void add(const sOutputStats &other);
+
+    unsigned long long packets = 0;     // packets handed to the output
+    unsigned long long datagrams = 0;   // datagrams actually sent, less than packets when bundling
+    unsigned long long coalesced = 0;   // superseded by a newer message before they were sent
+    unsigned long long suppressed = 0;  // dropped by a change-only route because nothing changed
+    unsigned long long suppressedBytes = 0;
+    unsigned long long delayed = 0;         // held back by rate limiting before they were sent
+    unsigned long long dropped = 0;         // discarded because the output queue was full
+    unsigned long long failed = 0;          // lost because the connection could not send them
+    unsigned long long queueHighWater = 0;  // most packets waiting in the output queue at once, add() keeps the max
+  };
+
   ItemState()
     : state(STATE_UNINITIALIZED)
     , activity(false)
@@ -55,6 +72,9 @@ public:
   EnumState state;
   bool activity;
   bool dirty;
+  sOutputStats output;
+
+  void GetStatsText(QString &text) const;
 
   static void GetStateName(EnumState state, QString &name);
   static void GetStateColor(EnumState state, QColor &color);
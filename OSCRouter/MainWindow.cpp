@@ -516,6 +516,7 @@ QString TcpWidget::HeaderForCol(Col col)
     case Col::kFraming: return tr("Framing");
     case Col::kIP: return tr("IP");
     case Col::kPort: return tr("Port");
+    case Col::kOptions: return tr("Opt");
   }
 
   return QString();
@@ -593,6 +594,12 @@ void TcpWidget::AddRow(size_t id, bool remove, const Router::sConnection& connec
   row.port->setText((connection.addr.port == 0) ? QString() : QString::number(connection.addr.port));
   AddCol(col++, row.port);
 
+  row.options = new RoutingButton(QString(), id, m_Cols->widget(col));
+  row.outputOptions = connection.options;
+  connect(row.options, &RoutingButton::clickedWithId, this, &TcpWidget::onOptionsClicked);
+  UpdateOptionsButton(row);
+  AddCol(col++, row.options, row.options->sizeHint().height());
+
   row.addRemove = new RoutingButton(remove ? QLatin1String("-") : QLatin1String("+"), id, m_Cols->widget(col));
   row.addRemove->setToolTip(tr("Add/Remove this route"));
   connect(row.addRemove, &RoutingButton::clickedWithId, this, &TcpWidget::onAddRemoveClicked);
@@ -616,6 +623,12 @@ void TcpWidget::AddCol(int index, QWidget* w, int fixedW /*= -1*/)
   col->AddWidgets({w});
 }
 
+void TcpWidget::UpdateOptionsButton(Row& row)
+{
+  row.options->setText(row.outputOptions.isDefault() ? QLatin1String("...") : QLatin1String("*"));
+  row.options->setToolTip(OutputOptionsDialog::SummaryForOptions(row.outputOptions));
+}
+
 void TcpWidget::Load(const QStringList& lines)
 {
   Router::CONNECTIONS connections;
@@ -637,7 +650,7 @@ void TcpWidget::LoadLine(const QString& line, Router::CONNECTIONS& connections)
   QStringList items;
   FileUtils::GetItemsFromQuotedString(line, items);
 
-  if (items.size() == 5)
+  if (items.size() >= 5)
   {
     Router::sConnection connection;
 
@@ -653,6 +666,9 @@ void TcpWidget::LoadLine(const QString& line, Router::CONNECTIONS& connections)
     connection.addr.ip = items[3];
     connection.addr.port = items[4].toUShort();
 
+    if (items.size() > 5)
+      connection.options.fromString(items[5]);
+
     connections.push_back(connection);
   }
 }
@@ -671,6 +687,9 @@ void TcpWidget::Save(QTextStream& stream)
     stream << QStringLiteral(",%1").arg(static_cast<int>(connection.frameMode));
     stream << QStringLiteral(",%1").arg(FileUtils::QuotedString(connection.addr.ip));
     stream << QStringLiteral(",%1").arg(connection.addr.port);
+    QString optionsStr;
+    connection.options.toString(optionsStr);
+    stream << QStringLiteral(",%1").arg(FileUtils::QuotedString(optionsStr));
     stream << QLatin1Char('\n');
   }
 }
@@ -698,6 +717,8 @@ void TcpWidget::SaveConnections(Router::CONNECTIONS& connections, ItemStateTable
     if (connection.addr.ip == QLatin1String("0.0.0.0"))
       connection.addr.ip.clear();
 
+    connection.options = row.outputOptions;
+
     if (HasConnection(connections, connection.addr))
       continue;
 
@@ -721,7 +742,7 @@ void TcpWidget::UpdateItemState(const ItemStateTable& itemStateTable)
 
     const ItemState* itemState = itemStateTable.GetItemState(row.itemStateTableId);
     if (!(itemState && itemState->dirty))
-      return;
+      continue;
 
     QColor color;
     ItemState::GetStateColor(itemState->state, color);
@@ -729,6 +750,10 @@ void TcpWidget::UpdateItemState(const ItemStateTable& itemStateTable)
 
     QString name;
     ItemState::GetStateName(itemState->state, name);
+    QString stats;
+    itemState->GetStatsText(stats);
+    if (!stats.isEmpty())
+      name += QLatin1Char('\n') + stats;
     row.state->setToolTip(name);
 
     if (itemState->state != ItemState::STATE_UNINITIALIZED)
@@ -818,6 +843,20 @@ QRect TcpWidget::RectForCol(Col col) const
   return QRect(w->mapTo(this, QPoint(0, 0)), w->mapTo(this, QPoint(w->width() - 1, w->height() - 1)));
 }
 
+void TcpWidget::onOptionsClicked(size_t id)
+{
+  if (id >= m_Rows.size())
+    return;
+
+  Row& row = m_Rows[id];
+  OutputOptionsDialog dialog(row.outputOptions, OutputOptionsDialog::Scope::kTcp, this);
+  if (dialog.exec() == QDialog::Accepted)
+  {
+    dialog.GetOptions(row.outputOptions);
+    UpdateOptionsButton(row);
+  }
+}
+
 void TcpWidget::onAddRemoveClicked(size_t id)
 {
   if (id >= m_Rows.size())
@@ -894,6 +933,394 @@ Protocol ProtocolComboBox::SanitizedProtocol(int protocol)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+OutputOptionsDialog::OutputOptionsDialog(const EosOutputOptions& options, Scope scope, QWidget* parent /*= nullptr*/)
+  : QDialog(parent)
+  , m_Options(options)
+{
+  setWindowTitle(tr("Output Options"));
+
+  QFormLayout* layout = new QFormLayout(this);
+
+  if (scope == Scope::kRoute)
+  {
+    m_Bundle = new QCheckBox(tr("Pack messages into bundles"), this);
+    m_Bundle->setToolTip(tr("Send OSC messages queued for this destination as OSC bundles that fill the MTU, instead of one datagram per message"));
+    m_Bundle->setChecked(options.bundle);
+    connect(m_Bundle, &QCheckBox::toggled, this, &OutputOptionsDialog::onBundleToggled);
+    layout->addRow(tr("Bundle"), m_Bundle);
+
+    m_BundleWindow = new QSpinBox(this);
+    m_BundleWindow->setToolTip(tr("Collect messages for up to this long before sending\n\n0 sends whatever is queued each output cycle"));
+    m_BundleWindow->setRange(0, 1000);
+    m_BundleWindow->setSuffix(tr(" ms"));
+    m_BundleWindow->setValue(static_cast<int>(options.bundleWindowMS));
+    layout->addRow(tr("Bundle Window"), m_BundleWindow);
+
+    m_BundleMTU = new QSpinBox(this);
+    m_BundleMTU->setToolTip(tr("Largest bundle to send, in bytes"));
+    m_BundleMTU->setRange(64, 65507);
+    m_BundleMTU->setSuffix(tr(" bytes"));
+    m_BundleMTU->setValue(static_cast<int>(options.bundleMTU));
+    layout->addRow(tr("Bundle MTU"), m_BundleMTU);
+
+    m_Coalesce = new QCheckBox(tr("Send only the newest value per address"), this);
+    m_Coalesce->setToolTip(tr("Within each interval, a newer message replaces any queued message with the same OSC path\n\nMessages are sent in the order their path first arrived"));
+    m_Coalesce->setChecked(options.coalesce);
+    connect(m_Coalesce, &QCheckBox::toggled, this, &OutputOptionsDialog::onCoalesceToggled);
+    layout->addRow(tr("Coalesce"), m_Coalesce);
+
+    m_CoalesceInterval = new QSpinBox(this);
+    m_CoalesceInterval->setToolTip(tr("How long messages are held while newer values replace them"));
+    m_CoalesceInterval->setRange(1, 10000);
+    m_CoalesceInterval->setSuffix(tr(" ms"));
+    m_CoalesceInterval->setValue(static_cast<int>(options.coalesceIntervalMS));
+    layout->addRow(tr("Coalesce Interval"), m_CoalesceInterval);
+
+    m_CoalesceKeyArgs = new QSpinBox(this);
+    m_CoalesceKeyArgs->setToolTip(tr("Number of leading arguments that are part of the key along with the OSC path\n\nEx: 1 keeps the newest /eos/fader message for each fader number argument"));
+    m_CoalesceKeyArgs->setRange(0, 16);
+    m_CoalesceKeyArgs->setValue(static_cast<int>(options.coalesceKeyArgs));
+    layout->addRow(tr("Coalesce Key Args"), m_CoalesceKeyArgs);
+
+    m_ChangeOnly = new QCheckBox(tr("Send only changed values"), this);
+    m_ChangeOnly->setToolTip(tr("Messages from this route are not sent if their arguments are identical to the last ones sent to the same OSC path"));
+    m_ChangeOnly->setChecked(options.changeOnly);
+    connect(m_ChangeOnly, &QCheckBox::toggled, this, &OutputOptionsDialog::onChangeOnlyToggled);
+    layout->addRow(tr("Change Only"), m_ChangeOnly);
+
+    m_ChangeOnlyKeepAlive = new QSpinBox(this);
+    m_ChangeOnlyKeepAlive->setToolTip(tr("Resend an unchanged message once this long has passed since it was last sent\n\n0 never resends unchanged messages"));
+    m_ChangeOnlyKeepAlive->setRange(0, 600000);
+    m_ChangeOnlyKeepAlive->setSuffix(tr(" ms"));
+    m_ChangeOnlyKeepAlive->setValue(static_cast<int>(options.changeOnlyKeepAliveMS));
+    layout->addRow(tr("Keep Alive"), m_ChangeOnlyKeepAlive);
+
+    m_KeepBundles = new QCheckBox(tr("Forward incoming bundles as bundles"), this);
+    m_KeepBundles->setToolTip(tr("Messages from one incoming OSC bundle that go to the same destination are sent together as one bundle\n\nPaths and transforms are still applied to each message"));
+    m_KeepBundles->setChecked(options.keepBundles);
+    layout->addRow(tr("Keep Bundles"), m_KeepBundles);
+
+    m_Priority = new QComboBox(this);
+    m_Priority->setToolTip(tr("High priority routes are handled before all others and skip coalescing, bundling and rate limiting\n\nUse for time critical messages such as cue GOs"));
+    for (int i = 0; i < EosOutputOptions::PRIORITY_COUNT; ++i)
+      m_Priority->addItem(PriorityName(static_cast<EosOutputOptions::EnumPriority>(i)));
+    m_Priority->setCurrentIndex(static_cast<int>(options.priority));
+    layout->addRow(tr("Priority"), m_Priority);
+
+    QWidget* psnFields = new QWidget(this);
+    psnFields->setToolTip(tr("Tracker fields a PSN input turns into OSC for this route\n\nEach input makes the fields and messages that any of its routes ask for"));
+    QHBoxLayout* psnFieldsLayout = new QHBoxLayout(psnFields);
+    psnFieldsLayout->setContentsMargins(0, 0, 0, 0);
+    for (int i = 0; i < PSNTracker::FIELD_COUNT; ++i)
+    {
+      PSNTracker::EnumField field = static_cast<PSNTracker::EnumField>(i);
+      m_PSNFields[i] = new QCheckBox(QString::fromUtf8(PSNTracker::GetFieldName(field)), psnFields);
+      m_PSNFields[i]->setChecked((options.psnFields & PSNTracker::FieldBit(field)) != 0);
+      psnFieldsLayout->addWidget(m_PSNFields[i]);
+    }
+    layout->addRow(tr("PSN Fields"), psnFields);
+
+    m_PSNFormFields = new QCheckBox(tr("One message per field"), this);
+    m_PSNFormFields->setToolTip(tr("/psn/<id>/pos, /psn/<id>/speed, ..."));
+    m_PSNFormFields->setChecked((options.psnForms & EosOutputOptions::PSN_FORM_FIELDS) != 0);
+    connect(m_PSNFormFields, &QCheckBox::toggled, this, &OutputOptionsDialog::onPSNFormToggled);
+    layout->addRow(tr("PSN Messages"), m_PSNFormFields);
+
+    m_PSNFormCombined = new QCheckBox(tr("One message per tracker with all fields"), this);
+    m_PSNFormCombined->setToolTip(tr("/psn/<id>/pos/speed/..."));
+    m_PSNFormCombined->setChecked((options.psnForms & EosOutputOptions::PSN_FORM_COMBINED) != 0);
+    connect(m_PSNFormCombined, &QCheckBox::toggled, this, &OutputOptionsDialog::onPSNFormToggled);
+    layout->addRow(QString(), m_PSNFormCombined);
+
+    m_PSNFormBundle = new QCheckBox(tr("One bundle per frame"), this);
+    m_PSNFormBundle->setToolTip(tr("The messages made from each PSN frame go to each destination of this route as one OSC bundle\n\nNeeds messages per field or per tracker to carry"));
+    m_PSNFormBundle->setChecked((options.psnForms & EosOutputOptions::PSN_FORM_BUNDLE) != 0);
+    layout->addRow(QString(), m_PSNFormBundle);
+
+    QString psnMatrix;
+    if (options.hasPSNTransform())
+      options.psnMatrixToString(psnMatrix);
+    m_PSNMatrix = new QLineEdit(psnMatrix, this);
+    m_PSNMatrix->setPlaceholderText(tr("1,0,0,0, 0,1,0,0, 0,0,1,0"));
+    m_PSNMatrix->setToolTip(
+        tr("4x4 affine matrix applied to PSN pos, speed, orientation, acceleration and target,\n"
+           "received as PSN or as /psn/<id>/... OSC\n"
+           "\n"
+           "12 comma separated values row by row, the last row (0,0,0,1) may be included\n"
+           "Pos and target are also moved by the last column\n"
+           "Orientation is only rotated, scale is taken out and mirroring flips it\n"
+           "\n"
+           "Leave blank to route values unchanged"));
+    layout->addRow(tr("PSN Transform"), m_PSNMatrix);
+
+    m_PSNRate = new QSpinBox(this);
+    m_PSNRate->setToolTip(tr("PSN destinations get all their trackers in one frame this many times per second, plus an info frame each second\n\n0 sends a frame as soon as each tracker is routed"));
+    m_PSNRate->setRange(0, 1000);
+    m_PSNRate->setSuffix(tr(" Hz"));
+    m_PSNRate->setValue(static_cast<int>(options.psnRateHz));
+    layout->addRow(tr("PSN Frame Rate"), m_PSNRate);
+
+    m_PSNPredict = new QCheckBox(tr("Predict positions between updates"), this);
+    m_PSNPredict->setToolTip(tr("Frames sent between real updates carry positions extrapolated from each tracker's last speed and acceleration\n\nPredictions are held after 250 ms"));
+    m_PSNPredict->setChecked(options.psnPredict);
+    layout->addRow(QString(), m_PSNPredict);
+  }
+
+  m_RateLimit = new QSpinBox(this);
+  QString rateLimitToolTip = ((scope == Scope::kTcp) ? tr("Most packets per second to send on this connection") : tr("Most datagrams per second to send to this destination"));
+  rateLimitToolTip += tr("\n\nPackets over the limit are queued and sent as soon as the rate allows, 0 is unlimited");
+  if (scope == Scope::kRoute)
+    rateLimitToolTip += tr("\n\nTCP connections are limited in the TCP tab");
+  m_RateLimit->setToolTip(rateLimitToolTip);
+  m_RateLimit->setRange(0, 1000000);
+  m_RateLimit->setSuffix(tr(" /s"));
+  m_RateLimit->setSpecialValueText(tr("Unlimited"));
+  m_RateLimit->setValue(static_cast<int>(options.rateLimit));
+  connect(m_RateLimit, qOverload<int>(&QSpinBox::valueChanged), this, &OutputOptionsDialog::onRateLimitChanged);
+  layout->addRow(tr("Rate Limit"), m_RateLimit);
+
+  m_RateBurst = new QSpinBox(this);
+  m_RateBurst->setToolTip(tr("Packets that may be sent back to back before the rate limit applies"));
+  m_RateBurst->setRange(1, 100000);
+  m_RateBurst->setValue(static_cast<int>(options.rateBurst));
+  layout->addRow(tr("Rate Burst"), m_RateBurst);
+
+  m_QueueLimit = new QSpinBox(this);
+  m_QueueLimit->setToolTip(tr("Most packets that may wait to be sent before the queue policy drops some"));
+  m_QueueLimit->setRange(16, 1000000);
+  m_QueueLimit->setSuffix(tr(" packets"));
+  m_QueueLimit->setValue(static_cast<int>(options.queueLimit));
+  layout->addRow(tr("Queue Limit"), m_QueueLimit);
+
+  m_QueuePolicy = new QComboBox(this);
+  m_QueuePolicy->setToolTip(tr("What to drop when the queue is full\n\nCoalesce drops queued messages that a newer message to the same OSC path replaces, then the oldest"));
+  for (int i = 0; i < EosOutputOptions::QUEUE_POLICY_COUNT; ++i)
+    m_QueuePolicy->addItem(QueuePolicyName(static_cast<EosOutputOptions::EnumQueuePolicy>(i)));
+  m_QueuePolicy->setCurrentIndex(static_cast<int>(options.queuePolicy));
+  layout->addRow(tr("Queue Policy"), m_QueuePolicy);
+
+  if (scope == Scope::kTcp)
+  {
+    m_TcpCork = new QCheckBox(tr("Hold frames to send fewer, larger writes"), this);
+    m_TcpCork->setToolTip(tr("Frames ready together are written together\n\nWhen corked, frames are held up to the cork window or until 64 KB wait\n\nHigh priority messages are never held"));
+    m_TcpCork->setChecked(options.tcpCork);
+    connect(m_TcpCork, &QCheckBox::toggled, this, &OutputOptionsDialog::onTcpCorkToggled);
+    layout->addRow(tr("Cork"), m_TcpCork);
+
+    m_TcpCorkWindow = new QSpinBox(this);
+    m_TcpCorkWindow->setToolTip(tr("Longest time a frame is held before it is written"));
+    m_TcpCorkWindow->setRange(1, 1000);
+    m_TcpCorkWindow->setSuffix(tr(" ms"));
+    m_TcpCorkWindow->setValue(static_cast<int>(options.tcpCorkMS));
+    layout->addRow(tr("Cork Window"), m_TcpCorkWindow);
+
+    m_ReplayState = new QCheckBox(tr("Send last values on connect"), this);
+    m_ReplayState->setToolTip(tr("Remembers the newest message sent to each OSC path\n\nWhen the connection is made or remade, they are all sent again in bundles of up to 1400 bytes"));
+    m_ReplayState->setChecked(options.replayState);
+    layout->addRow(tr("Replay State"), m_ReplayState);
+  }
+
+  QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+  connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  layout->addRow(buttons);
+
+  if (scope == Scope::kRoute)
+  {
+    onBundleToggled(options.bundle);
+    onCoalesceToggled(options.coalesce);
+    onChangeOnlyToggled(options.changeOnly);
+    onPSNFormToggled(false);
+  }
+  else
+    onTcpCorkToggled(options.tcpCork);
+  onRateLimitChanged(m_RateLimit->value());
+}
+
+void OutputOptionsDialog::GetOptions(EosOutputOptions& options) const
+{
+  // options not shown for this scope are left as they were
+  options = m_Options;
+
+  if (m_Bundle)
+  {
+    options.bundle = m_Bundle->isChecked();
+    options.bundleWindowMS = static_cast<unsigned int>(m_BundleWindow->value());
+    options.bundleMTU = static_cast<unsigned int>(m_BundleMTU->value());
+    options.coalesce = m_Coalesce->isChecked();
+    options.coalesceIntervalMS = static_cast<unsigned int>(m_CoalesceInterval->value());
+    options.coalesceKeyArgs = static_cast<unsigned int>(m_CoalesceKeyArgs->value());
+    options.changeOnly = m_ChangeOnly->isChecked();
+    options.changeOnlyKeepAliveMS = static_cast<unsigned int>(m_ChangeOnlyKeepAlive->value());
+    options.keepBundles = m_KeepBundles->isChecked();
+
+    options.psnFields = 0;
+    for (int i = 0; i < PSNTracker::FIELD_COUNT; ++i)
+    {
+      if (m_PSNFields[i]->isChecked())
+        options.psnFields |= PSNTracker::FieldBit(static_cast<PSNTracker::EnumField>(i));
+    }
+
+    options.psnForms = 0;
+    if (m_PSNFormFields->isChecked())
+      options.psnForms |= EosOutputOptions::PSN_FORM_FIELDS;
+    if (m_PSNFormCombined->isChecked())
+      options.psnForms |= EosOutputOptions::PSN_FORM_COMBINED;
+    if (options.psnForms != 0 && m_PSNFormBundle->isChecked())
+      options.psnForms |= EosOutputOptions::PSN_FORM_BUNDLE;
+
+    // a matrix that does not parse keeps the previous one
+    options.psnMatrixFromString(m_PSNMatrix->text());
+
+    options.psnRateHz = static_cast<unsigned int>(m_PSNRate->value());
+    options.psnPredict = m_PSNPredict->isChecked();
+
+    int n = m_Priority->currentIndex();
+    if (n >= 0 && n < EosOutputOptions::PRIORITY_COUNT)
+      options.priority = static_cast<EosOutputOptions::EnumPriority>(n);
+  }
+
+  options.rateLimit = static_cast<unsigned int>(m_RateLimit->value());
+  options.rateBurst = static_cast<unsigned int>(m_RateBurst->value());
+  options.queueLimit = static_cast<unsigned int>(m_QueueLimit->value());
+
+  int n = m_QueuePolicy->currentIndex();
+  if (n >= 0 && n < EosOutputOptions::QUEUE_POLICY_COUNT)
+    options.queuePolicy = static_cast<EosOutputOptions::EnumQueuePolicy>(n);
+
+  if (m_TcpCork)
+  {
+    options.tcpCork = m_TcpCork->isChecked();
+    options.tcpCorkMS = static_cast<unsigned int>(m_TcpCorkWindow->value());
+    options.replayState = m_ReplayState->isChecked();
+  }
+}
+
+QString OutputOptionsDialog::SummaryForOptions(const EosOutputOptions& options)
+{
+  QStringList lines;
+  if (options.bundle)
+    lines << tr("Bundle up to %1 bytes, %2 ms window").arg(options.bundleMTU).arg(options.bundleWindowMS);
+  if (options.coalesce)
+    lines << tr("Coalesce every %1 ms, keyed on path + %2 args").arg(options.coalesceIntervalMS).arg(options.coalesceKeyArgs);
+  if (options.changeOnly)
+    lines << tr("Change only, keep alive %1 ms").arg(options.changeOnlyKeepAliveMS);
+  if (options.keepBundles)
+    lines << tr("Keep incoming bundles");
+  if (options.psnFields != EosOutputOptions().psnFields)
+  {
+    QStringList fields;
+    for (int i = 0; i < PSNTracker::FIELD_COUNT; ++i)
+    {
+      PSNTracker::EnumField field = static_cast<PSNTracker::EnumField>(i);
+      if ((options.psnFields & PSNTracker::FieldBit(field)) != 0)
+        fields << QString::fromUtf8(PSNTracker::GetFieldName(field));
+    }
+    lines << tr("PSN fields: %1").arg(fields.isEmpty() ? tr("none") : fields.join(QLatin1String(", ")));
+  }
+  if (options.psnForms != EosOutputOptions().psnForms)
+  {
+    QStringList forms;
+    if (options.psnForms & EosOutputOptions::PSN_FORM_FIELDS)
+      forms << tr("per field");
+    if (options.psnForms & EosOutputOptions::PSN_FORM_COMBINED)
+      forms << tr("per tracker");
+    if (options.psnForms & EosOutputOptions::PSN_FORM_BUNDLE)
+      forms << tr("bundled per frame");
+    lines << tr("PSN messages: %1").arg(forms.isEmpty() ? tr("none") : forms.join(QLatin1String(", ")));
+  }
+  if (options.hasPSNTransform())
+  {
+    QString matrix;
+    options.psnMatrixToString(matrix);
+    lines << tr("PSN transform: %1").arg(matrix);
+  }
+  if (options.psnRateHz != EosOutputOptions().psnRateHz)
+  {
+    if (options.psnRateHz == 0)
+      lines << tr("PSN frame per tracker");
+    else
+      lines << tr("PSN frames at %1 Hz").arg(options.psnRateHz);
+  }
+  if (options.psnPredict)
+    lines << tr("PSN positions predicted between updates");
+  if (options.priority != EosOutputOptions().priority)
+    lines << tr("%1 priority").arg(PriorityName(options.priority));
+  if (options.rateLimit != 0)
+    lines << tr("Rate limit %1/s, burst %2").arg(options.rateLimit).arg(options.rateBurst);
+  if (options.queueLimit != EosOutputOptions().queueLimit || options.queuePolicy != EosOutputOptions().queuePolicy)
+    lines << tr("Queue %1 packets, %2").arg(options.queueLimit).arg(QueuePolicyName(options.queuePolicy).toLower());
+  if (options.tcpCork)
+    lines << tr("Cork up to %1 ms").arg(options.tcpCorkMS);
+  if (options.replayState)
+    lines << tr("Replay last values on connect");
+
+  if (lines.isEmpty())
+    return tr("Output options");
+
+  return tr("Output options:\n%1").arg(lines.join(QLatin1Char('\n')));
+}
+
+QString OutputOptionsDialog::QueuePolicyName(EosOutputOptions::EnumQueuePolicy policy)
+{
+  switch (policy)
+  {
+    case EosOutputOptions::QUEUE_DROP_NEWEST: return tr("Drop Newest");
+    case EosOutputOptions::QUEUE_DROP_OLDEST: return tr("Drop Oldest");
+    case EosOutputOptions::QUEUE_COALESCE: return tr("Coalesce");
+    default: break;
+  }
+
+  return QString();
+}
+
+QString OutputOptionsDialog::PriorityName(EosOutputOptions::EnumPriority priority)
+{
+  switch (priority)
+  {
+    case EosOutputOptions::PRIORITY_HIGH: return tr("High");
+    case EosOutputOptions::PRIORITY_NORMAL: return tr("Normal");
+    case EosOutputOptions::PRIORITY_LOW: return tr("Low");
+    default: break;
+  }
+
+  return QString();
+}
+
+void OutputOptionsDialog::onBundleToggled(bool checked)
+{
+  m_BundleWindow->setEnabled(checked);
+  m_BundleMTU->setEnabled(checked);
+}
+
+void OutputOptionsDialog::onCoalesceToggled(bool checked)
+{
+  m_CoalesceInterval->setEnabled(checked);
+  m_CoalesceKeyArgs->setEnabled(checked);
+}
+
+void OutputOptionsDialog::onChangeOnlyToggled(bool checked)
+{
+  m_ChangeOnlyKeepAlive->setEnabled(checked);
+}
+
+void OutputOptionsDialog::onPSNFormToggled(bool /*checked*/)
+{
+  m_PSNFormBundle->setEnabled(m_PSNFormFields->isChecked() || m_PSNFormCombined->isChecked());
+}
+
+void OutputOptionsDialog::onRateLimitChanged(int value)
+{
+  m_RateBurst->setEnabled(value != 0);
+}
+
+void OutputOptionsDialog::onTcpCorkToggled(bool checked)
+{
+  m_TcpCorkWindow->setEnabled(checked);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 RoutingWidget::RoutingWidget(QWidget* parent /*= nullptr*/)
   : QWidget(parent)
 {
@@ -983,6 +1410,8 @@ QString RoutingWidget::HeaderForCol(Col col)
     case Col::kOutMax: return tr("Max");
 
     case Col::kOutScript: return tr("JS");
+
+    case Col::kOutOptions: return tr("Opt");
   }
 
   return QString();
@@ -1193,6 +1622,12 @@ void RoutingWidget::AddRow(size_t id, bool remove, const QString& label, const E
   row.outMax->setText(transformStr);
   AddCol(col++, row.outMax);
 
+  row.outOptions = new RoutingButton(QString(), id, m_Cols->widget(col));
+  row.options = dst.options;
+  connect(row.outOptions, &RoutingButton::clickedWithId, this, &RoutingWidget::onOutOptionsClicked);
+  UpdateOptionsButton(row);
+  AddCol(col++, row.outOptions, /*fixed*/ true);
+
   row.addRemove = new RoutingButton(remove ? QLatin1String("-") : QLatin1String("+"), id, m_Cols->widget(col));
   row.addRemove->setToolTip(tr("Add/Remove this route"));
   connect(row.addRemove, &RoutingButton::clickedWithId, this, &RoutingWidget::onAddRemoveClicked);
@@ -1223,6 +1658,12 @@ void RoutingWidget::AddCol(int index, const RoutingCol::Widgets& w, bool fixed /
   col->AddWidgets(w);
 }
 
+void RoutingWidget::UpdateOptionsButton(Row& row)
+{
+  row.outOptions->setText(row.options.isDefault() ? QLatin1String("...") : QLatin1String("*"));
+  row.outOptions->setToolTip(OutputOptionsDialog::SummaryForOptions(row.options));
+}
+
 void RoutingWidget::Load(const QStringList& lines)
 {
   Router::ROUTES routes;
@@ -1276,6 +1717,9 @@ void RoutingWidget::LoadLine(const QString& line, Router::ROUTES& routes)
     if (items.size() > 14)
       route.dst.protocol = ProtocolComboBox::SanitizedProtocol(items[14].toInt());
 
+    if (items.size() > 15)
+      route.dst.options.fromString(items[15]);
+
     routes.push_back(route);
   }
 }
@@ -1313,6 +1757,9 @@ void RoutingWidget::Save(QTextStream& stream)
     stream << QStringLiteral(",%1").arg(FileUtils::QuotedString(route.src.multicastIP));
     stream << QStringLiteral(",%1").arg(static_cast<int>(route.src.protocol));
     stream << QStringLiteral(",%1").arg(static_cast<int>(route.dst.protocol));
+    QString optionsStr;
+    route.dst.options.toString(optionsStr);
+    stream << QStringLiteral(",%1").arg(FileUtils::QuotedString(optionsStr));
     stream << QLatin1Char('\n');
   }
 }
@@ -1359,6 +1806,7 @@ void RoutingWidget::SaveRoutes(Router::ROUTES& routes, ItemStateTable* itemState
     StringToTransform(row.inMax->text(), route.dst.inMax);
     StringToTransform(row.outMin->text(), route.dst.outMin);
     StringToTransform(row.outMax->text(), route.dst.outMax);
+    route.dst.options = row.options;
 
     if (HasRoute(routes, route.src, route.dst))
       continue;
@@ -1407,6 +1855,10 @@ void RoutingWidget::UpdateItemState(const ItemState* itemState, Indicator& state
 
   QString name;
   ItemState::GetStateName(itemState->state, name);
+  QString stats;
+  itemState->GetStatsText(stats);
+  if (!stats.isEmpty())
+    name += QLatin1Char('\n') + stats;
   stateIndicator.setToolTip(name);
 
   if (itemState->state != ItemState::STATE_UNINITIALIZED)
@@ -1530,6 +1982,20 @@ void RoutingWidget::onOutScriptToggled(size_t id, bool checked)
   UpdateLayout();
 }
 
+void RoutingWidget::onOutOptionsClicked(size_t id)
+{
+  if (id >= m_Rows.size())
+    return;
+
+  Row& row = m_Rows[id];
+  OutputOptionsDialog dialog(row.options, OutputOptionsDialog::Scope::kRoute, this);
+  if (dialog.exec() == QDialog::Accepted)
+  {
+    dialog.GetOptions(row.options);
+    UpdateOptionsButton(row);
+  }
+}
+
 void RoutingWidget::onAddRemoveClicked(size_t id)
 {
   if (id >= m_Rows.size())
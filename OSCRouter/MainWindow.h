@@ -216,6 +216,7 @@ protected:
 
 private slots:
   void updateHeaders();
+  void onOptionsClicked(size_t id);
   void onAddRemoveClicked(size_t id);
 
 private:
@@ -228,6 +229,7 @@ private:
     kFraming,
     kIP,
     kPort,
+    kOptions,
     kButton,
 
     kCount
@@ -244,7 +246,9 @@ private:
     QComboBox* framing = nullptr;
     QLineEdit* ip = nullptr;
     QLineEdit* port = nullptr;
+    RoutingButton* options = nullptr;
     RoutingButton* addRemove = nullptr;
+    EosOutputOptions outputOptions;
   };
 
   typedef std::vector<Row> Rows;
@@ -257,6 +261,7 @@ private:
   void LoadLine(const QString& line, Router::CONNECTIONS& connections);
   void AddRow(size_t id, bool remove, const Router::sConnection& connection);
   void AddCol(int index, QWidget* w, int fixedW = -1);
+  void UpdateOptionsButton(Row& row);
   void UpdateLayout();
   QRect RectForCol(Col col) const;
 
@@ -290,6 +295,63 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class OutputOptionsDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  enum class Scope
+  {
+    kRoute,
+    kTcp
+  };
+
+  OutputOptionsDialog(const EosOutputOptions& options, Scope scope, QWidget* parent = nullptr);
+
+  void GetOptions(EosOutputOptions& options) const;
+
+  static QString SummaryForOptions(const EosOutputOptions& options);
+  static QString QueuePolicyName(EosOutputOptions::EnumQueuePolicy policy);
+  static QString PriorityName(EosOutputOptions::EnumPriority priority);
+
+private slots:
+  void onBundleToggled(bool checked);
+  void onCoalesceToggled(bool checked);
+  void onChangeOnlyToggled(bool checked);
+  void onPSNFormToggled(bool checked);
+  void onRateLimitChanged(int value);
+  void onTcpCorkToggled(bool checked);
+
+private:
+  EosOutputOptions m_Options;
+  QCheckBox* m_Bundle = nullptr;
+  QSpinBox* m_BundleWindow = nullptr;
+  QSpinBox* m_BundleMTU = nullptr;
+  QCheckBox* m_Coalesce = nullptr;
+  QSpinBox* m_CoalesceInterval = nullptr;
+  QSpinBox* m_CoalesceKeyArgs = nullptr;
+  QCheckBox* m_ChangeOnly = nullptr;
+  QSpinBox* m_ChangeOnlyKeepAlive = nullptr;
+  QCheckBox* m_KeepBundles = nullptr;
+  QCheckBox* m_PSNFields[PSNTracker::FIELD_COUNT] = {};
+  QCheckBox* m_PSNFormFields = nullptr;
+  QCheckBox* m_PSNFormCombined = nullptr;
+  QCheckBox* m_PSNFormBundle = nullptr;
+  QLineEdit* m_PSNMatrix = nullptr;
+  QSpinBox* m_PSNRate = nullptr;
+  QCheckBox* m_PSNPredict = nullptr;
+  QComboBox* m_Priority = nullptr;
+  QSpinBox* m_RateLimit = nullptr;
+  QSpinBox* m_RateBurst = nullptr;
+  QSpinBox* m_QueueLimit = nullptr;
+  QComboBox* m_QueuePolicy = nullptr;
+  QCheckBox* m_TcpCork = nullptr;
+  QSpinBox* m_TcpCorkWindow = nullptr;
+  QCheckBox* m_ReplayState = nullptr;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class RoutingWidget : public QWidget
 {
   Q_OBJECT
@@ -316,6 +378,7 @@ protected:
 private slots:
   void updateHeaders();
   void onOutScriptToggled(size_t id, bool checked);
+  void onOutOptionsClicked(size_t id);
   void onAddRemoveClicked(size_t id);
   void onInProtocolChanged(size_t row, Protocol protocol);
   void onOutProtocolChanged(size_t row, Protocol protocol);
@@ -345,6 +408,7 @@ private:
     kOutScript,
     kOutMin,
     kOutMax,
+    kOutOptions,
 
     kButton,
 
@@ -376,6 +440,8 @@ private:
     RoutingCheckBox* outScript = nullptr;
     QLineEdit* outMin = nullptr;
     QLineEdit* outMax = nullptr;
+    RoutingButton* outOptions = nullptr;
+    EosOutputOptions options;
     RoutingButton* addRemove = nullptr;
   };
 
@@ -393,6 +459,7 @@ private:
   void AddRow(size_t id, bool remove, const QString& label, const EosRouteSrc& src, const EosRouteDst& dst);
   void AddCol(int index, QWidget* w, bool fixed = false);
   void AddCol(int index, const RoutingCol::Widgets& w, bool fixed = false);
+  void UpdateOptionsButton(Row& row);
   void UpdateItemState(const ItemState* itemState, Indicator& stateIndicator, Indicator& activityIndicator);
   void UpdateLayout();
   QRect RectForCol(Col col) const;
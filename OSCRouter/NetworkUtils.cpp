@@ -20,14 +20,93 @@
 
 #include "NetworkUtils.h"
 
+#include <algorithm>
+
 // must be last include
 #include "LeakWatcher.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
+const int EosPacket::sm_PoolBlockSize = 2048;
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+class EosPacketPool
+{
+public:
+  EosPacketPool() = default;
+
+  ~EosPacketPool()
+  {
+    while (m_Free)
+    {
+      sBlock *block = m_Free;
+      m_Free = block->next;
+      delete[] reinterpret_cast<char *>(block);
+    }
+  }
+
+  char *Alloc()
+  {
+    m_Mutex.lock();
+    sBlock *block = m_Free;
+    if (block)
+    {
+      m_Free = block->next;
+      --m_FreeCount;
+    }
+    m_Mutex.unlock();
+
+    return (block ? reinterpret_cast<char *>(block) : new char[EosPacket::sm_PoolBlockSize]);
+  }
+
+  void Free(char *data)
+  {
+    m_Mutex.lock();
+    if (m_FreeCount < MaxFreeCount)
+    {
+      sBlock *block = reinterpret_cast<sBlock *>(data);
+      block->next = m_Free;
+      m_Free = block;
+      ++m_FreeCount;
+      data = nullptr;
+    }
+    m_Mutex.unlock();
+
+    if (data)
+      delete[] data;
+  }
+
+private:
+  struct sBlock
+  {
+    sBlock *next;
+  };
+
+  static const size_t MaxFreeCount = 8192;
+
+  QMutex m_Mutex;
+  sBlock *m_Free = nullptr;
+  size_t m_FreeCount = 0;
+};
+
+EosPacketPool &GetPacketPool()
+{
+  static EosPacketPool pool;
+  return pool;
+}
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
 EosPacket::EosPacket()
   : m_Data(0)
   , m_Size(0)
+  , m_Capacity(0)
 {
 }
 
@@ -36,25 +115,37 @@ EosPacket::EosPacket()
 EosPacket::EosPacket(const EosPacket &other)
   : m_Data(0)
   , m_Size(0)
+  , m_Capacity(0)
 {
   if (other.m_Data && other.m_Size > 0)
   {
     m_Size = other.m_Size;
-    m_Data = new char[m_Size];
-    memcpy(m_Data, other.m_Data, m_Size);  // TODO: optmize, too many needless copies of packet data in queues
+    m_Data = Alloc(m_Size, m_Capacity);
+    memcpy(m_Data, other.m_Data, m_Size);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+EosPacket::EosPacket(EosPacket &&other) noexcept
+  : m_Data(other.m_Data)
+  , m_Size(other.m_Size)
+  , m_Capacity(other.m_Capacity)
+{
+  other.Release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 EosPacket::EosPacket(const char *data, int size)
   : m_Data(0)
   , m_Size(0)
+  , m_Capacity(0)
 {
   if (data && size > 0)
   {
     m_Size = size;
-    m_Data = new char[m_Size];
+    m_Data = Alloc(m_Size, m_Capacity);
     memcpy(m_Data, data, m_Size);
   }
 }
@@ -65,20 +156,36 @@ EosPacket &EosPacket::operator=(const EosPacket &other)
 {
   if (&other != this)
   {
-    if (m_Data)
-    {
-      delete[] m_Data;
-      m_Data = 0;
-    }
-
-    m_Size = 0;
-
     if (other.m_Data && other.m_Size > 0)
     {
+      // reuse the current buffer when it is large enough
+      if (!m_Data || m_Capacity < other.m_Size)
+      {
+        Free(m_Data, m_Capacity);
+        m_Data = Alloc(other.m_Size, m_Capacity);
+      }
+
       m_Size = other.m_Size;
-      m_Data = new char[m_Size];
       memcpy(m_Data, other.m_Data, m_Size);
     }
+    else
+      m_Size = 0;
+  }
+
+  return (*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+EosPacket &EosPacket::operator=(EosPacket &&other) noexcept
+{
+  if (&other != this)
+  {
+    Free(m_Data, m_Capacity);
+    m_Data = other.m_Data;
+    m_Size = other.m_Size;
+    m_Capacity = other.m_Capacity;
+    other.Release();
   }
 
   return (*this);
@@ -90,13 +197,65 @@ EosPacket::~EosPacket()
 {
   if (m_Data)
   {
-    delete[] m_Data;
+    Free(m_Data, m_Capacity);
     m_Data = 0;
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+char *EosPacket::Reserve(int capacity)
+{
+  m_Size = 0;
+
+  if (capacity <= 0)
+    return m_Data;
+
+  if (!m_Data || m_Capacity < capacity)
+  {
+    Free(m_Data, m_Capacity);
+    m_Data = Alloc(capacity, m_Capacity);
+  }
+
+  return m_Data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosPacket::Resize(int size)
+{
+  m_Size = qBound(0, size, m_Capacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+char *EosPacket::Alloc(int size, int &capacity)
+{
+  if (size <= sm_PoolBlockSize)
+  {
+    capacity = sm_PoolBlockSize;
+    return GetPacketPool().Alloc();
+  }
+
+  capacity = size;
+  return new char[size];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosPacket::Free(char *data, int capacity)
+{
+  if (!data)
+    return;
+
+  if (capacity == sm_PoolBlockSize)
+    GetPacketPool().Free(data);
+  else
+    delete[] data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 EosAddr::EosAddr(const QString &Ip, unsigned short Port)
   : ip(Ip.toLower().trimmed())
   , port(Port)
@@ -192,10 +351,255 @@ bool EosRouteSrc::operator<(const EosRouteSrc &other) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool EosOutputOptions::operator==(const EosOutputOptions &other) const
+{
+  return (bundle == other.bundle && bundleWindowMS == other.bundleWindowMS && bundleMTU == other.bundleMTU && coalesce == other.coalesce && coalesceIntervalMS == other.coalesceIntervalMS &&
+          coalesceKeyArgs == other.coalesceKeyArgs && changeOnly == other.changeOnly && changeOnlyKeepAliveMS == other.changeOnlyKeepAliveMS && keepBundles == other.keepBundles &&
+          psnFields == other.psnFields && psnForms == other.psnForms && std::equal(psnMatrix, psnMatrix + PSN_MATRIX_SIZE, other.psnMatrix) && psnRateHz == other.psnRateHz &&
+          psnPredict == other.psnPredict && priority == other.priority && rateLimit == other.rateLimit && rateBurst == other.rateBurst && queueLimit == other.queueLimit &&
+          queuePolicy == other.queuePolicy && tcpCork == other.tcpCork && tcpCorkMS == other.tcpCorkMS && replayState == other.replayState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool EosOutputOptions::operator<(const EosOutputOptions &other) const
+{
+  if (bundle != other.bundle)
+    return (bundle < other.bundle);
+  if (bundleWindowMS != other.bundleWindowMS)
+    return (bundleWindowMS < other.bundleWindowMS);
+  if (bundleMTU != other.bundleMTU)
+    return (bundleMTU < other.bundleMTU);
+  if (coalesce != other.coalesce)
+    return (coalesce < other.coalesce);
+  if (coalesceIntervalMS != other.coalesceIntervalMS)
+    return (coalesceIntervalMS < other.coalesceIntervalMS);
+  if (coalesceKeyArgs != other.coalesceKeyArgs)
+    return (coalesceKeyArgs < other.coalesceKeyArgs);
+  if (changeOnly != other.changeOnly)
+    return (changeOnly < other.changeOnly);
+  if (changeOnlyKeepAliveMS != other.changeOnlyKeepAliveMS)
+    return (changeOnlyKeepAliveMS < other.changeOnlyKeepAliveMS);
+  if (keepBundles != other.keepBundles)
+    return (keepBundles < other.keepBundles);
+  if (psnFields != other.psnFields)
+    return (psnFields < other.psnFields);
+  if (psnForms != other.psnForms)
+    return (psnForms < other.psnForms);
+  if (!std::equal(psnMatrix, psnMatrix + PSN_MATRIX_SIZE, other.psnMatrix))
+    return std::lexicographical_compare(psnMatrix, psnMatrix + PSN_MATRIX_SIZE, other.psnMatrix, other.psnMatrix + PSN_MATRIX_SIZE);
+  if (psnRateHz != other.psnRateHz)
+    return (psnRateHz < other.psnRateHz);
+  if (psnPredict != other.psnPredict)
+    return (psnPredict < other.psnPredict);
+  if (priority != other.priority)
+    return (priority < other.priority);
+  if (rateLimit != other.rateLimit)
+    return (rateLimit < other.rateLimit);
+  if (rateBurst != other.rateBurst)
+    return (rateBurst < other.rateBurst);
+  if (queueLimit != other.queueLimit)
+    return (queueLimit < other.queueLimit);
+  if (queuePolicy != other.queuePolicy)
+    return (queuePolicy < other.queuePolicy);
+  if (tcpCork != other.tcpCork)
+    return (tcpCork < other.tcpCork);
+  if (tcpCorkMS != other.tcpCorkMS)
+    return (tcpCorkMS < other.tcpCorkMS);
+  return (replayState < other.replayState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosOutputOptions::toString(QString &str) const
+{
+  // only non-default values are written, so older files and new defaults stay compatible
+  EosOutputOptions defaults;
+  QStringList items;
+  if (bundle != defaults.bundle)
+    items << QStringLiteral("bundle=%1").arg(bundle ? 1 : 0);
+  if (bundleWindowMS != defaults.bundleWindowMS)
+    items << QStringLiteral("bundleWindow=%1").arg(bundleWindowMS);
+  if (bundleMTU != defaults.bundleMTU)
+    items << QStringLiteral("bundleMTU=%1").arg(bundleMTU);
+  if (coalesce != defaults.coalesce)
+    items << QStringLiteral("coalesce=%1").arg(coalesce ? 1 : 0);
+  if (coalesceIntervalMS != defaults.coalesceIntervalMS)
+    items << QStringLiteral("coalesceInterval=%1").arg(coalesceIntervalMS);
+  if (coalesceKeyArgs != defaults.coalesceKeyArgs)
+    items << QStringLiteral("coalesceKeyArgs=%1").arg(coalesceKeyArgs);
+  if (changeOnly != defaults.changeOnly)
+    items << QStringLiteral("changeOnly=%1").arg(changeOnly ? 1 : 0);
+  if (changeOnlyKeepAliveMS != defaults.changeOnlyKeepAliveMS)
+    items << QStringLiteral("changeOnlyKeepAlive=%1").arg(changeOnlyKeepAliveMS);
+  if (keepBundles != defaults.keepBundles)
+    items << QStringLiteral("keepBundles=%1").arg(keepBundles ? 1 : 0);
+  if (psnFields != defaults.psnFields)
+    items << QStringLiteral("psnFields=%1").arg(psnFields);
+  if (psnForms != defaults.psnForms)
+    items << QStringLiteral("psnForms=%1").arg(psnForms);
+  if (hasPSNTransform())
+  {
+    QString matrix;
+    psnMatrixToString(matrix);
+    items << QStringLiteral("psnMatrix=%1").arg(matrix);
+  }
+  if (psnRateHz != defaults.psnRateHz)
+    items << QStringLiteral("psnRate=%1").arg(psnRateHz);
+  if (psnPredict != defaults.psnPredict)
+    items << QStringLiteral("psnPredict=%1").arg(psnPredict ? 1 : 0);
+  if (priority != defaults.priority)
+    items << QStringLiteral("priority=%1").arg(static_cast<int>(priority));
+  if (rateLimit != defaults.rateLimit)
+    items << QStringLiteral("rate=%1").arg(rateLimit);
+  if (rateBurst != defaults.rateBurst)
+    items << QStringLiteral("rateBurst=%1").arg(rateBurst);
+  if (queueLimit != defaults.queueLimit)
+    items << QStringLiteral("queueLimit=%1").arg(queueLimit);
+  if (queuePolicy != defaults.queuePolicy)
+    items << QStringLiteral("queuePolicy=%1").arg(static_cast<int>(queuePolicy));
+  if (tcpCork != defaults.tcpCork)
+    items << QStringLiteral("tcpCork=%1").arg(tcpCork ? 1 : 0);
+  if (tcpCorkMS != defaults.tcpCorkMS)
+    items << QStringLiteral("tcpCorkWindow=%1").arg(tcpCorkMS);
+  if (replayState != defaults.replayState)
+    items << QStringLiteral("replayState=%1").arg(replayState ? 1 : 0);
+  str = items.join(QLatin1Char(';'));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosOutputOptions::fromString(const QString &str)
+{
+  *this = EosOutputOptions();
+
+  QStringList items = str.split(QLatin1Char(';'), Qt::SkipEmptyParts);
+  for (QStringList::const_iterator i = items.begin(); i != items.end(); i++)
+  {
+    int index = i->indexOf(QLatin1Char('='));
+    if (index < 1)
+      continue;
+
+    QString key = i->left(index).trimmed();
+    QString value = i->mid(index + 1).trimmed();
+    if (key == QLatin1String("psnMatrix"))
+    {
+      psnMatrixFromString(value);
+      continue;
+    }
+
+    bool ok = false;
+    unsigned int n = value.toUInt(&ok);
+    if (!ok)
+      continue;
+
+    if (key == QLatin1String("bundle"))
+      bundle = (n != 0);
+    else if (key == QLatin1String("bundleWindow"))
+      bundleWindowMS = qMin(n, 1000u);
+    else if (key == QLatin1String("bundleMTU"))
+      bundleMTU = qBound(64u, n, 65507u);
+    else if (key == QLatin1String("coalesce"))
+      coalesce = (n != 0);
+    else if (key == QLatin1String("coalesceInterval"))
+      coalesceIntervalMS = qBound(1u, n, 10000u);
+    else if (key == QLatin1String("coalesceKeyArgs"))
+      coalesceKeyArgs = qMin(n, 16u);
+    else if (key == QLatin1String("changeOnly"))
+      changeOnly = (n != 0);
+    else if (key == QLatin1String("changeOnlyKeepAlive"))
+      changeOnlyKeepAliveMS = qMin(n, 600000u);
+    else if (key == QLatin1String("keepBundles"))
+      keepBundles = (n != 0);
+    else if (key == QLatin1String("psnFields"))
+      psnFields = (n & PSN_FIELDS_ALL);
+    else if (key == QLatin1String("psnForms"))
+    {
+      psnForms = (n & PSN_FORMS_ALL);
+      if ((psnForms & (PSN_FORM_FIELDS | PSN_FORM_COMBINED)) == 0)
+        psnForms = 0;  // a bundle needs messages to carry
+    }
+    else if (key == QLatin1String("psnRate"))
+      psnRateHz = qMin(n, 1000u);
+    else if (key == QLatin1String("psnPredict"))
+      psnPredict = (n != 0);
+    else if (key == QLatin1String("priority") && n < PRIORITY_COUNT)
+      priority = static_cast<EnumPriority>(n);
+    else if (key == QLatin1String("rate"))
+      rateLimit = qMin(n, 1000000u);
+    else if (key == QLatin1String("rateBurst"))
+      rateBurst = qBound(1u, n, 100000u);
+    else if (key == QLatin1String("queueLimit"))
+      queueLimit = qBound(16u, n, 1000000u);
+    else if (key == QLatin1String("queuePolicy") && n < QUEUE_POLICY_COUNT)
+      queuePolicy = static_cast<EnumQueuePolicy>(n);
+    else if (key == QLatin1String("tcpCork"))
+      tcpCork = (n != 0);
+    else if (key == QLatin1String("tcpCorkWindow"))
+      tcpCorkMS = qBound(1u, n, 1000u);
+    else if (key == QLatin1String("replayState"))
+      replayState = (n != 0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool EosOutputOptions::hasPSNTransform() const
+{
+  EosOutputOptions defaults;
+  return !std::equal(psnMatrix, psnMatrix + PSN_MATRIX_SIZE, defaults.psnMatrix);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosOutputOptions::psnMatrixToString(QString &str) const
+{
+  // "m00,m01,m02,m03,m10,...", row by row
+  QStringList values;
+  for (size_t i = 0; i < PSN_MATRIX_SIZE; ++i)
+    values << QString::number(psnMatrix[i], 'g', 9);
+  str = values.join(QLatin1Char(','));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool EosOutputOptions::psnMatrixFromString(const QString &str)
+{
+  // 12 values, or all 16 of a 4x4 matrix as long as its last row is 0 0 0 1, empty is the identity
+  // the matrix is left as it was when str is not a valid transform
+  QStringList values = str.split(QLatin1Char(','), Qt::SkipEmptyParts);
+  if (values.isEmpty())
+  {
+    EosOutputOptions defaults;
+    std::copy(defaults.psnMatrix, defaults.psnMatrix + PSN_MATRIX_SIZE, psnMatrix);
+    return true;
+  }
+
+  if (values.size() != static_cast<qsizetype>(PSN_MATRIX_SIZE) && values.size() != static_cast<qsizetype>(PSN_MATRIX_SIZE + 4))
+    return false;
+
+  float matrix[PSN_MATRIX_SIZE + 4] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+  for (qsizetype i = 0; i < values.size(); ++i)
+  {
+    bool ok = false;
+    matrix[i] = values[i].trimmed().toFloat(&ok);
+    if (!ok || !qIsFinite(matrix[i]))
+      return false;
+  }
+
+  if (matrix[12] != 0 || matrix[13] != 0 || matrix[14] != 0 || matrix[15] != 1)
+    return false;
+
+  std::copy(matrix, matrix + PSN_MATRIX_SIZE, psnMatrix);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool EosRouteDst::operator==(const EosRouteDst &other) const
 {
   return (addr == other.addr && protocol == other.protocol && path == other.path && script == other.script && scriptText == other.scriptText && inMin == other.inMin && inMax == other.inMax &&
-          outMin == other.outMin && outMax == other.outMax);
+          outMin == other.outMin && outMax == other.outMax && options == other.options);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -218,7 +622,9 @@ bool EosRouteDst::operator<(const EosRouteDst &other) const
     return (inMax < other.inMax);
   if (outMin != other.outMin)
     return (outMin < other.outMin);
-  return (outMax < other.outMax);
+  if (outMax != other.outMax)
+    return (outMax < other.outMax);
+  return (options < other.options);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
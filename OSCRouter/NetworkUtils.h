@@ -30,28 +30,42 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// packet data up to sm_PoolBlockSize bytes is stored in recycled fixed size blocks, so steady state
+// traffic does not touch the heap
 class EosPacket
 {
 public:
   typedef std::vector<EosPacket> Q;
 
+  static const int sm_PoolBlockSize;
+
   EosPacket();
   EosPacket(const EosPacket &other);
+  EosPacket(EosPacket &&other) noexcept;
   EosPacket(const char *data, int size);
   EosPacket &operator=(const EosPacket &other);
+  EosPacket &operator=(EosPacket &&other) noexcept;
   virtual ~EosPacket();
   char *GetData() { return m_Data; }
   const char *GetDataConst() const { return m_Data; }
   int GetSize() const { return m_Size; }
+  int GetCapacity() const { return m_Capacity; }
+  char *Reserve(int capacity);
+  void Resize(int size);
   void Release()
   {
     m_Data = 0;
     m_Size = 0;
+    m_Capacity = 0;
   }
 
 private:
   char *m_Data;
   int m_Size;
+  int m_Capacity;
+
+  static char *Alloc(int size, int &capacity);
+  static void Free(char *data, int capacity);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -105,6 +119,106 @@ struct EosRouteSrc
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// per destination output settings, edited in the route options dialog and saved as "key=value;..."
+struct EosOutputOptions
+{
+  enum EnumQueuePolicy
+  {
+    QUEUE_DROP_NEWEST = 0,
+    QUEUE_DROP_OLDEST,
+    QUEUE_COALESCE,
+
+    QUEUE_POLICY_COUNT
+  };
+
+  enum EnumPriority
+  {
+    PRIORITY_HIGH = 0,
+    PRIORITY_NORMAL,
+    PRIORITY_LOW,
+
+    PRIORITY_COUNT
+  };
+
+  enum EnumPSNForm
+  {
+    PSN_FORM_FIELDS = 0x1,    // one message per field, "/psn/<id>/<field>"
+    PSN_FORM_COMBINED = 0x2,  // one message per tracker with all its fields, "/psn/<id>/<field>/<field>..."
+    PSN_FORM_BUNDLE = 0x4,    // with one of the forms above: the messages of each frame go to each destination as one bundle
+
+    PSN_FORMS_ALL = 0x7
+  };
+
+  static const unsigned int PSN_FIELDS_ALL = 0x7f;  // bit per PSNTracker::EnumField
+  static const size_t PSN_MATRIX_SIZE = 12;         // row major 3x4, a 4x4 affine matrix without its 0 0 0 1 row
+
+  bool operator==(const EosOutputOptions &other) const;
+  bool operator!=(const EosOutputOptions &other) const { return !((*this) == other); }
+  bool operator<(const EosOutputOptions &other) const;
+  bool isDefault() const { return ((*this) == EosOutputOptions()); }
+  void toString(QString &str) const;
+  void fromString(const QString &str);
+  bool hasPSNTransform() const;
+  void psnMatrixToString(QString &str) const;
+  bool psnMatrixFromString(const QString &str);
+
+  // pack osc messages queued for the destination into bundles up to bundleMTU bytes
+  // bundleWindowMS == 0 bundles whatever is queued each output cycle
+  bool bundle = false;
+  unsigned int bundleWindowMS = 0;
+  unsigned int bundleMTU = 1400;
+
+  // send only the newest message per address (plus first coalesceKeyArgs arguments) every coalesceIntervalMS
+  bool coalesce = false;
+  unsigned int coalesceIntervalMS = 20;
+  unsigned int coalesceKeyArgs = 0;
+
+  // per route: drop messages whose arguments are byte-identical to the last ones sent to the same address
+  // changeOnlyKeepAliveMS != 0 resends an unchanged message once that long has passed since it was last sent
+  bool changeOnly = false;
+  unsigned int changeOnlyKeepAliveMS = 1000;
+
+  // per route: messages from one input bundle that go to the same destination leave together in one bundle
+  bool keepBundles = false;
+
+  // per route, psn input: tracker fields and forms turned into osc, each input makes what any of its routes asks for
+  unsigned int psnFields = PSN_FIELDS_ALL;
+  unsigned int psnForms = (PSN_FORM_FIELDS | PSN_FORM_COMBINED);
+
+  // per route: psn float3 fields are mapped through psnMatrix, whether trackers arrive as psn or as "/psn/<id>/..." osc
+  // pos and target take the whole transform, speed and acceleration only its rotation and scale, orientation only its rotation
+  float psnMatrix[PSN_MATRIX_SIZE] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0};
+
+  // psn output: trackers routed to the destination leave together as whole frames psnRateHz times per second,
+  // with info frames once a second, 0 sends a frame for each tracker as soon as it is routed
+  unsigned int psnRateHz = 60;
+
+  // psn output: positions in frames sent between real updates are extrapolated from the last pos, speed and acceleration
+  bool psnPredict = false;
+
+  // per route: higher classes are routed and sent first, PRIORITY_HIGH also skips coalescing, bundling and rate limiting
+  EnumPriority priority = PRIORITY_NORMAL;
+
+  // pace datagrams (udp) or frames (tcp) to rateLimit per second, in bursts of up to rateBurst, 0 is unlimited
+  unsigned int rateLimit = 0;
+  unsigned int rateBurst = 10;
+
+  // packets waiting for the output thread are capped at queueLimit, queuePolicy picks what is dropped when full
+  unsigned int queueLimit = 4096;
+  EnumQueuePolicy queuePolicy = QUEUE_DROP_OLDEST;
+
+  // tcp: frames ready each cycle leave in one write, tcpCork also holds them for up to tcpCorkMS to fill larger writes
+  bool tcpCork = false;
+  unsigned int tcpCorkMS = 5;
+
+  // tcp: resend the newest message sent to each osc address, in mtu sized bundles, whenever the connection is (re)made
+  bool replayState = false;
+
+  bool hasDestinationOptions() const { return (bundle || coalesce || rateLimit != 0 || queueLimit != EosOutputOptions().queueLimit || queuePolicy != EosOutputOptions().queuePolicy); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct EosRouteDst
 {
   struct sTransform
@@ -135,6 +249,7 @@ struct EosRouteDst
   sTransform inMax;
   sTransform outMin;
   sTransform outMax;
+  EosOutputOptions options;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
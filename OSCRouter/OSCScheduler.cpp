@@ -0,0 +1,165 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OSCScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+// must be last include
+#include "LeakWatcher.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t OSCScheduler::sm_Default_Max_Events = 65536;
+const uint64_t OSCScheduler::sm_Default_Max_Hold_US = 60000000;
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCScheduler::OSCScheduler(size_t maxEvents, uint64_t maxHoldUS)
+  : m_MaxEvents(maxEvents)
+  , m_MaxHoldUS(maxHoldUS)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCScheduler::Hold(const EosAddr &addr, unsigned int ip, const char *buf, size_t size, uint64_t nowUS)
+{
+  OSCBundleIterator bundle(buf, size);
+  uint64_t timeTag = bundle.GetTimeTag();
+  if (timeTag <= OSCBundleWriter::sm_Time_Tag_Immediate)
+    return false;
+
+  // a bundle due now is routed in full, nested bundles may not be dated earlier than the one holding them
+  uint64_t ntpNowUS = GetNTPTimeUS();
+  uint64_t tagUS = TimeTagToUS(timeTag);
+  if (tagUS <= ntpNowUS)
+    return false;
+
+  if ((tagUS - ntpNowUS) > m_MaxHoldUS)
+  {
+    ++m_Stats.tooFar;
+    return false;
+  }
+
+  if (m_Timers.size() >= m_MaxEvents)
+  {
+    // nothing more can be held, so it goes out early rather than not at all
+    ++m_Stats.overflow;
+    return false;
+  }
+
+  uint64_t bundleSeq = m_Seq;
+  const char *element = nullptr;
+  size_t elementSize = 0;
+  OSCPacketInfo elementInfo;
+  while (bundle.Next(element, elementSize, elementInfo))
+  {
+    uint32_t index = 0;
+    if (m_Free.empty())
+    {
+      index = static_cast<uint32_t>(m_Events.size());
+      m_Events.emplace_back();
+    }
+    else
+    {
+      index = m_Free.back();
+      m_Free.pop_back();
+    }
+
+    uint64_t elementTagUS = qMax(tagUS, TimeTagToUS(bundle.GetTimeTag()));
+    sEvent &event = m_Events[index];
+    event.addr = addr;
+    event.ip = ip;
+    event.packet = EosPacket(element, static_cast<int>(elementSize));
+    event.info = elementInfo;
+    event.dueUS = (nowUS + (elementTagUS - ntpNowUS));
+    event.seq = m_Seq++;
+    event.bundle = bundleSeq;
+    m_Timers.Add(event.dueUS, index);
+    ++m_Stats.scheduled;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCScheduler::Release(uint64_t nowUS, EVENTS &events)
+{
+  m_Expired.clear();
+  if (m_Timers.Advance(nowUS, m_Expired) == 0)
+    return;
+
+  size_t first = events.size();
+  for (TimerWheel::TIMERS::const_iterator i = m_Expired.begin(); i != m_Expired.end(); i++)
+  {
+    uint32_t index = static_cast<uint32_t>(i->data);
+    sEvent &event = m_Events[index];
+    AddLateness((nowUS > event.dueUS) ? (nowUS - event.dueUS) : 0);
+    events.push_back(std::move(event));
+    m_Free.push_back(index);
+  }
+
+  m_Stats.released += m_Expired.size();
+
+  // the wheel only orders timers by tick
+  std::sort(events.begin() + static_cast<std::ptrdiff_t>(first), events.end(),
+            [](const sEvent &a, const sEvent &b) { return ((a.dueUS == b.dueUS) ? (a.seq < b.seq) : (a.dueUS < b.dueUS)); });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCScheduler::AddLateness(uint64_t lateUS)
+{
+  static const uint64_t bucketsUS[] = {100, 200, 500, 1000, 2000, 5000, 10000};
+
+  m_Stats.lateTotalUS += lateUS;
+  if (lateUS > m_Stats.lateMaxUS)
+    m_Stats.lateMaxUS = lateUS;
+
+  size_t bucket = 0;
+  while (bucket < (sizeof(bucketsUS) / sizeof(bucketsUS[0])) && lateUS > bucketsUS[bucket])
+    ++bucket;
+  ++m_Stats.lateHistogram[bucket];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t OSCScheduler::GetNTPTimeUS()
+{
+  // ntp time counts from 1900, the system clock from 1970
+  static const uint64_t epochOffsetUS = (2208988800ull * 1000000);
+  int64_t sinceEpochUS = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  return (epochOffsetUS + static_cast<uint64_t>(qMax<int64_t>(0, sinceEpochUS)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t OSCScheduler::TimeTagToUS(uint64_t timeTag)
+{
+  // 32 bits of seconds, 32 bits of fraction
+  uint64_t seconds = (timeTag >> 32);
+  uint64_t fractionUS = (((timeTag & 0xffffffffull) * 1000000) >> 32);
+  return (seconds * 1000000 + fractionUS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
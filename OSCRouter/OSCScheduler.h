@@ -0,0 +1,105 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef OSC_SCHEDULER_H
+#define OSC_SCHEDULER_H
+
+#ifndef NETWORK_UTILS_H
+#include "NetworkUtils.h"
+#endif
+
+#ifndef OSC_UTILS_H
+#include "OSCUtils.h"
+#endif
+
+#ifndef TIMER_WHEEL_H
+#include "TimerWheel.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// holds the messages of osc bundles whose time tag is in the future, and releases them when it arrives
+// times are in microseconds on any monotonic clock, time tags are mapped onto it with the system clock
+// messages due at the same time are released in the order they were received
+// maxEvents is checked per bundle, so one bundle is never split between held and sent
+// bundles dated more than maxHoldUS ahead are sent at once, a sender with a badly set clock must not stall a show
+class OSCScheduler
+{
+public:
+  struct sEvent
+  {
+    EosAddr addr;  // input the bundle arrived on
+    unsigned int ip = 0;
+    EosPacket packet;  // one message, nested bundles are flattened
+    OSCPacketInfo info;
+    uint64_t dueUS = 0;
+    uint64_t seq = 0;
+    uint64_t bundle = 0;  // shared by the messages of one input bundle
+  };
+
+  typedef std::vector<sEvent> EVENTS;
+
+  struct sStats
+  {
+    unsigned long long scheduled = 0;  // messages held for a future time tag
+    unsigned long long released = 0;
+    unsigned long long overflow = 0;       // bundles sent immediately, too many messages were already held
+    unsigned long long tooFar = 0;         // bundles sent immediately, dated further ahead than maxHoldUS
+    unsigned long long lateTotalUS = 0;    // how far past its time tag each released message went out
+    unsigned long long lateMaxUS = 0;
+    unsigned long long lateHistogram[8] = {};  // released within 100us, 200us, 500us, 1ms, 2ms, 5ms, 10ms, later
+  };
+
+  OSCScheduler(size_t maxEvents = sm_Default_Max_Events, uint64_t maxHoldUS = sm_Default_Max_Hold_US);
+
+  bool empty() const { return m_Timers.empty(); }
+  size_t size() const { return m_Timers.size(); }
+  const sStats &GetStats() const { return m_Stats; }
+
+  // returns true if the bundle was held, false if it is due now and should be routed as received
+  virtual bool Hold(const EosAddr &addr, unsigned int ip, const char *buf, size_t size, uint64_t nowUS);
+  virtual void Release(uint64_t nowUS, EVENTS &events);
+  bool GetNextDue(uint64_t &dueUS) const { return m_Timers.GetNextDue(dueUS); }
+
+  static uint64_t GetNTPTimeUS();
+  static uint64_t TimeTagToUS(uint64_t timeTag);
+
+  static const size_t sm_Default_Max_Events;
+  static const uint64_t sm_Default_Max_Hold_US;
+
+private:
+  typedef std::vector<uint32_t> FREE_LIST;
+
+  size_t m_MaxEvents;
+  uint64_t m_MaxHoldUS;
+  TimerWheel m_Timers;  // data is the index of the event
+  EVENTS m_Events;
+  FREE_LIST m_Free;
+  TimerWheel::TIMERS m_Expired;
+  uint64_t m_Seq = 0;
+  sStats m_Stats;
+
+  void AddLateness(uint64_t lateUS);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
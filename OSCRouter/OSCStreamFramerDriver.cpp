@@ -0,0 +1,171 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Standalone driver that feeds a captured TCP stream through OSCStreamFramer, not part of the app build:
+//   g++ -O2 -std=c++17 -I../../EosSyncLib/EosSyncLib OSCStreamFramerDriver.cpp OSCUtils.cpp SimdUtils.cpp ../../EosSyncLib/EosSyncLib/OSCParser.cpp -o OSCStreamFramerDriver
+//   ./OSCStreamFramerDriver [-slip] capture.bin [chunk size]
+//
+// The capture holds the bytes of one TCP stream, OSC 1.0 length prefixed by default or OSC 1.1 SLIP with -slip.
+// Its packets are framed again in both modes, and each stream is fed to a new framer in chunks of the given size,
+// or of several sizes from single bytes up to 64 KB. Every frame must come back whole and in order.
+// Exits with 1 if a frame is lost, changed or reordered.
+
+#include "OSCUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+typedef std::vector<std::string> PACKETS;
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char *GetFrameModeName(OSCStream::EnumFrameMode frameMode)
+{
+  return ((frameMode == OSCStream::FRAME_MODE_1_1) ? "OSC 1.1 SLIP" : "OSC 1.0 length prefixed");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ReadCapture(const char *path, std::vector<char> &data)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+
+  char buf[65536];
+  size_t size = 0;
+  while ((size = fread(buf, 1, sizeof(buf), f)) != 0)
+    data.insert(data.end(), buf, buf + size);
+
+  fclose(f);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WriteStream(OSCStream::EnumFrameMode frameMode, const PACKETS &packets, std::vector<char> &stream)
+{
+  stream.clear();
+  for (PACKETS::const_iterator i = packets.begin(); i != packets.end(); i++)
+  {
+    size_t offset = stream.size();
+    stream.resize(offset + OSCBufferWriter::GetMaxFrameSize(frameMode, i->size()));
+    size_t frameSize = OSCBufferWriter::WriteFrame(frameMode, i->data(), i->size(), stream.data() + offset, stream.size() - offset);
+    stream.resize(offset + frameSize);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool FeedStream(OSCStream::EnumFrameMode frameMode, const std::vector<char> &stream, const PACKETS &packets, size_t chunkSize)
+{
+  OSCStreamFramer framer(frameMode);
+  size_t frames = 0;
+  bool ok = true;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t offset = 0; offset < stream.size(); offset += chunkSize)
+  {
+    framer.Add(stream.data() + offset, std::min(chunkSize, stream.size() - offset));
+
+    const char *frame = nullptr;
+    size_t frameSize = 0;
+    while (framer.GetNextFrame(frame, frameSize))
+    {
+      if (frames >= packets.size() || packets[frames].size() != frameSize || memcmp(packets[frames].data(), frame, frameSize) != 0)
+        ok = false;
+      ++frames;
+    }
+  }
+  std::chrono::duration<double> elapsed = (std::chrono::steady_clock::now() - start);
+
+  if (frames != packets.size())
+    ok = false;
+
+  double mbPerSec = ((elapsed.count() > 0) ? (static_cast<double>(stream.size()) / elapsed.count() / 1000000.0) : 0);
+  printf("  %8zu byte chunks: %zu of %zu frames, %10.1f MB/s%s\n", chunkSize, frames, packets.size(), mbPerSec, ok ? "" : "  FAILED");
+  return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+  OSCStream::EnumFrameMode captureMode = OSCStream::FRAME_MODE_1_0;
+  int arg = 1;
+  if (arg < argc && strcmp(argv[arg], "-slip") == 0)
+  {
+    captureMode = OSCStream::FRAME_MODE_1_1;
+    ++arg;
+  }
+
+  if (arg >= argc)
+  {
+    printf("usage: %s [-slip] capture.bin [chunk size]\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<char> capture;
+  if (!ReadCapture(argv[arg], capture))
+  {
+    printf("could not read %s\n", argv[arg]);
+    return 2;
+  }
+
+  std::vector<size_t> chunkSizes;
+  if ((arg + 1) < argc)
+    chunkSizes.push_back(static_cast<size_t>(std::max(1, atoi(argv[arg + 1]))));
+  else
+  {
+    static const size_t sizes[] = {1, 7, 1460, 65536};
+    chunkSizes.assign(sizes, sizes + (sizeof(sizes) / sizeof(sizes[0])));
+  }
+
+  // the packets of the capture, split by the framer itself in one pass
+  PACKETS packets;
+  OSCStreamFramer captureFramer(captureMode);
+  captureFramer.Add(capture.data(), capture.size());
+  const char *frame = nullptr;
+  size_t frameSize = 0;
+  while (captureFramer.GetNextFrame(frame, frameSize))
+    packets.push_back(std::string(frame, frameSize));
+
+  printf("%s: %zu bytes, %zu %s frames\n", argv[arg], capture.size(), packets.size(), GetFrameModeName(captureMode));
+  if (packets.empty())
+    return 1;
+
+  bool ok = true;
+  static const OSCStream::EnumFrameMode frameModes[] = {OSCStream::FRAME_MODE_1_0, OSCStream::FRAME_MODE_1_1};
+  for (size_t i = 0; i < (sizeof(frameModes) / sizeof(frameModes[0])); ++i)
+  {
+    std::vector<char> stream;
+    WriteStream(frameModes[i], packets, stream);
+    printf("%s, %zu bytes\n", GetFrameModeName(frameModes[i]), stream.size());
+    for (std::vector<size_t>::const_iterator j = chunkSizes.begin(); j != chunkSizes.end(); j++)
+      ok = (FeedStream(frameModes[i], stream, packets, *j) && ok);
+  }
+
+  return (ok ? 0 : 1);
+}
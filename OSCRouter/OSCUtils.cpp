@@ -0,0 +1,1442 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OSCUtils.h"
+#include "SimdUtils.h"
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+// must be last include
+#include "LeakWatcher.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+inline size_t OSCPad4(size_t size)
+{
+  return ((size + 3) & ~static_cast<size_t>(3));
+}
+
+inline uint32_t ReadUInt32(const char *data)
+{
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+  return ((static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]));
+}
+
+inline uint64_t ReadUInt64(const char *data)
+{
+  return ((static_cast<uint64_t>(ReadUInt32(data)) << 32) | static_cast<uint64_t>(ReadUInt32(data + 4)));
+}
+
+inline void WriteUInt32(uint32_t n, char *data)
+{
+  unsigned char *p = reinterpret_cast<unsigned char *>(data);
+  p[0] = static_cast<unsigned char>(n >> 24);
+  p[1] = static_cast<unsigned char>(n >> 16);
+  p[2] = static_cast<unsigned char>(n >> 8);
+  p[3] = static_cast<unsigned char>(n);
+}
+
+inline void WriteUInt64(uint64_t n, char *data)
+{
+  WriteUInt32(static_cast<uint32_t>(n >> 32), data);
+  WriteUInt32(static_cast<uint32_t>(n), data + 4);
+}
+
+inline float ReadFloat32(const char *data)
+{
+  uint32_t n = ReadUInt32(data);
+  float f;
+  memcpy(&f, &n, sizeof(f));
+  return f;
+}
+
+inline double ReadFloat64(const char *data)
+{
+  uint64_t n = ReadUInt64(data);
+  double f;
+  memcpy(&f, &n, sizeof(f));
+  return f;
+}
+
+const unsigned char SLIP_END = 0xc0;
+const unsigned char SLIP_ESC = 0xdb;
+const unsigned char SLIP_ESC_END = 0xdc;
+const unsigned char SLIP_ESC_ESC = 0xdd;
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCPacketInfo::Parse(const char *buf, size_t size, OSCPacketInfo &info)
+{
+  info = OSCPacketInfo();
+
+  if (!buf || size == 0 || size > 0xffffffff)
+    return false;
+
+  if (buf[0] == '#')
+  {
+    // bundle header and time tag, elements are validated as they are iterated
+    if (size < 16 || (size % 4) != 0 || memcmp(buf, "#bundle", 8) != 0)
+      return false;
+
+    info.kind = KIND_BUNDLE;
+    info.tagsOffset = info.argsOffset = static_cast<uint32_t>(size);
+    return true;
+  }
+
+  // messages that do not check out here are routed raw
+  if (buf[0] != '/' || (size % 4) != 0)
+    return false;
+
+  const char *pathEnd = SimdUtils::FindByte(buf, size, 0);
+  if (!pathEnd)
+    return false;
+
+  size_t offset = OSCPad4(static_cast<size_t>(pathEnd - buf) + 1);
+  if (offset > size)
+    return false;
+
+  info.kind = KIND_MESSAGE;
+  info.pathLen = static_cast<uint32_t>(pathEnd - buf);
+  info.tagsOffset = info.argsOffset = static_cast<uint32_t>(size);
+
+  // no type tags, so no arguments
+  if (offset == size)
+    return true;
+
+  const char *tagsEnd = ((buf[offset] == ',') ? SimdUtils::FindByte(&buf[offset + 1], size - offset - 1, 0) : nullptr);
+  size_t argsOffset = (tagsEnd ? OSCPad4(static_cast<size_t>(tagsEnd - buf) + 1) : 0);
+  if (!tagsEnd || argsOffset > size)
+  {
+    info = OSCPacketInfo();
+    return false;
+  }
+
+  // the arguments must fill the rest of the packet exactly
+  size_t argsEnd = argsOffset;
+  for (const char *tag = &buf[offset + 1]; tag != tagsEnd; ++tag)
+  {
+    size_t argSize = 0;
+    if (!OSCArgView::GetArgSize(*tag, &buf[argsEnd], size - argsEnd, argSize))
+    {
+      info = OSCPacketInfo();
+      return false;
+    }
+    argsEnd += argSize;
+  }
+
+  if (argsEnd != size)
+  {
+    info = OSCPacketInfo();
+    return false;
+  }
+
+  info.tagsOffset = static_cast<uint32_t>(offset);
+  info.tagCount = static_cast<uint32_t>(tagsEnd - &buf[offset + 1]);
+  info.argsOffset = static_cast<uint32_t>(argsOffset);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCArgument::EnumArgumentTypes OSCArgView::GetTypeForTag(char tag)
+{
+  switch (tag)
+  {
+    case 'c': return OSCArgument::OSC_TYPE_CHAR;
+    case 'i': return OSCArgument::OSC_TYPE_INT32;
+    case 'h': return OSCArgument::OSC_TYPE_INT64;
+    case 'f': return OSCArgument::OSC_TYPE_FLOAT32;
+    case 'd': return OSCArgument::OSC_TYPE_FLOAT64;
+    case 's':
+    case 'S': return OSCArgument::OSC_TYPE_STRING;
+    case 'b': return OSCArgument::OSC_TYPE_BLOB;
+    case 't': return OSCArgument::OSC_TYPE_TIME;
+    case 'r': return OSCArgument::OSC_TYPE_RGBA32;
+    case 'm': return OSCArgument::OSC_TYPE_MIDI;
+    case 'T': return OSCArgument::OSC_TYPE_TRUE;
+    case 'F': return OSCArgument::OSC_TYPE_FALSE;
+    case 'N': return OSCArgument::OSC_TYPE_NULL;
+    case 'I': return OSCArgument::OSC_TYPE_INFINITY;
+  }
+
+  return OSCArgument::OSC_TYPE_INVALID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgView::GetArgSize(char tag, const char *data, size_t maxSize, size_t &size)
+{
+  switch (tag)
+  {
+    case 'c':
+    case 'i':
+    case 'f':
+    case 'r':
+    case 'm': size = 4; break;
+
+    case 'h':
+    case 'd':
+    case 't': size = 8; break;
+
+    case 'T':
+    case 'F':
+    case 'N':
+    case 'I': size = 0; break;
+
+    case 's':
+    case 'S':
+    {
+      const char *end = static_cast<const char *>(memchr(data, 0, maxSize));
+      if (!end)
+        return false;
+      size = OSCPad4(static_cast<size_t>(end - data) + 1);
+    }
+    break;
+
+    case 'b':
+    {
+      if (maxSize < 4)
+        return false;
+      size = OSCPad4(4 + static_cast<size_t>(ReadUInt32(data)));
+    }
+    break;
+
+    default: return false;
+  }
+
+  return (size <= maxSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgView::GetInt(int &n) const
+{
+  switch (m_Tag)
+  {
+    case 'c':
+    case 'i':
+    case 'r':
+    case 'm': n = static_cast<int>(ReadUInt32(m_Data)); return true;
+    case 'h':
+    case 't': n = static_cast<int>(ReadUInt64(m_Data)); return true;
+    case 'f': n = static_cast<int>(ReadFloat32(m_Data)); return true;
+    case 'd': n = static_cast<int>(ReadFloat64(m_Data)); return true;
+    case 'T': n = 1; return true;
+    case 'F':
+    case 'N': n = 0; return true;
+    case 'I': n = std::numeric_limits<int>::max(); return true;
+    case 's':
+    case 'S': n = atoi(m_Data); return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgView::GetInt64(int64_t &n) const
+{
+  switch (m_Tag)
+  {
+    case 'h':
+    case 't': n = static_cast<int64_t>(ReadUInt64(m_Data)); return true;
+    case 'f': n = static_cast<int64_t>(ReadFloat32(m_Data)); return true;
+    case 'd': n = static_cast<int64_t>(ReadFloat64(m_Data)); return true;
+    case 'I': n = std::numeric_limits<int64_t>::max(); return true;
+    case 's':
+    case 'S': n = static_cast<int64_t>(atoll(m_Data)); return true;
+  }
+
+  int i = 0;
+  if (GetInt(i))
+  {
+    n = i;
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgView::GetUInt64(uint64_t &n) const
+{
+  switch (m_Tag)
+  {
+    case 'h':
+    case 't': n = ReadUInt64(m_Data); return true;
+    case 'c':
+    case 'i':
+    case 'r':
+    case 'm': n = static_cast<uint64_t>(ReadUInt32(m_Data)); return true;
+    case 'I': n = std::numeric_limits<uint64_t>::max(); return true;
+    case 's':
+    case 'S': n = static_cast<uint64_t>(strtoull(m_Data, nullptr, 10)); return true;
+  }
+
+  int64_t i = 0;
+  if (GetInt64(i))
+  {
+    n = static_cast<uint64_t>(i);
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgView::GetFloat(float &f) const
+{
+  switch (m_Tag)
+  {
+    case 'f': f = ReadFloat32(m_Data); return true;
+    case 'd': f = static_cast<float>(ReadFloat64(m_Data)); return true;
+    case 'h':
+    case 't': f = static_cast<float>(static_cast<int64_t>(ReadUInt64(m_Data))); return true;
+    case 'I': f = std::numeric_limits<float>::infinity(); return true;
+    case 's':
+    case 'S': f = static_cast<float>(atof(m_Data)); return true;
+  }
+
+  int n = 0;
+  if (GetInt(n))
+  {
+    f = static_cast<float>(n);
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgView::GetDouble(double &f) const
+{
+  switch (m_Tag)
+  {
+    case 'd': f = ReadFloat64(m_Data); return true;
+    case 'I': f = std::numeric_limits<double>::infinity(); return true;
+    case 's':
+    case 'S': f = atof(m_Data); return true;
+  }
+
+  float n = 0;
+  if (GetFloat(n))
+  {
+    f = n;
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgView::GetString(std::string &str) const
+{
+  char buf[64];
+
+  switch (m_Tag)
+  {
+    case 's':
+    case 'S': str = m_Data; return true;
+    case 'c': str = std::string(1, static_cast<char>(ReadUInt32(m_Data))); return true;
+    case 'f': snprintf(buf, sizeof(buf), "%g", ReadFloat32(m_Data)); break;
+    case 'd': snprintf(buf, sizeof(buf), "%g", ReadFloat64(m_Data)); break;
+    case 'h': snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(ReadUInt64(m_Data))); break;
+    case 't': snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(ReadUInt64(m_Data))); break;
+    case 'T': str = "true"; return true;
+    case 'F': str = "false"; return true;
+    case 'N': str = "null"; return true;
+    case 'I': str = "infinity"; return true;
+    case 'b': return false;
+
+    default:
+    {
+      int n = 0;
+      if (!GetInt(n))
+        return false;
+      snprintf(buf, sizeof(buf), "%d", n);
+    }
+    break;
+  }
+
+  str = buf;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCArgsView::OSCArgsView(const char *buf, size_t size)
+{
+  OSCPacketInfo info;
+  if (OSCPacketInfo::Parse(buf, size, info))
+    *this = OSCArgsView(buf, size, info);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCArgsView::OSCArgsView(const char *buf, size_t size, const OSCPacketInfo &info)
+{
+  if (!buf || info.kind != OSCPacketInfo::KIND_MESSAGE || info.tagCount == 0 || info.argsOffset > size)
+    return;
+
+  m_Tags = &buf[info.tagsOffset + 1];
+  m_Count = info.tagCount;
+  m_Data = &buf[info.argsOffset];
+  m_End = &buf[size];
+  m_Cursor = m_Data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgsView::GetArg(size_t index, OSCArgView &arg) const
+{
+  if (index >= m_Count)
+    return false;
+
+  if (index < m_CursorIndex)
+  {
+    m_CursorIndex = 0;
+    m_Cursor = m_Data;
+  }
+
+  for (;;)
+  {
+    char tag = m_Tags[m_CursorIndex];
+    size_t argSize = 0;
+    if (!OSCArgView::GetArgSize(tag, m_Cursor, static_cast<size_t>(m_End - m_Cursor), argSize))
+      return false;
+
+    if (m_CursorIndex == index)
+    {
+      arg = OSCArgView(tag, m_Cursor, argSize);
+      return true;
+    }
+
+    m_Cursor += argSize;
+    ++m_CursorIndex;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t OSCArgsView::GetRunLength(size_t index) const
+{
+  if (index >= m_Count)
+    return 0;
+
+  size_t i = (index + 1);
+  while (i < m_Count && m_Tags[i] == m_Tags[index])
+    ++i;
+
+  return (i - index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgsView::GetInts(size_t index, int32_t *values, size_t count) const
+{
+  OSCArgView arg;
+  if (!GetArg(index, arg))
+    return false;
+
+  if (m_Tags[index] == 'i' && GetRunLength(index) >= count && (count * 4) <= static_cast<size_t>(m_End - arg.GetData()))
+  {
+    // short runs like a PSN xyz are read in place, the swap kernels only pay off on longer ones
+    if (count < SimdUtils::sm_Min_Swap32_Count)
+    {
+      for (size_t i = 0; i < count; ++i)
+        values[i] = static_cast<int32_t>(ReadUInt32(arg.GetData() + (i * 4)));
+    }
+    else
+      SimdUtils::SwapBytes32(arg.GetData(), values, count);
+    return true;
+  }
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    int n = 0;
+    if (!GetArg(index + i, arg) || !arg.GetInt(n))
+      return false;
+    values[i] = n;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgsView::GetFloats(size_t index, float *values, size_t count) const
+{
+  OSCArgView arg;
+  if (!GetArg(index, arg))
+    return false;
+
+  if (m_Tags[index] == 'f' && GetRunLength(index) >= count && (count * 4) <= static_cast<size_t>(m_End - arg.GetData()))
+  {
+    if (count < SimdUtils::sm_Min_Swap32_Count)
+    {
+      for (size_t i = 0; i < count; ++i)
+        values[i] = ReadFloat32(arg.GetData() + (i * 4));
+    }
+    else
+      SimdUtils::SwapBytes32(arg.GetData(), values, count);
+    return true;
+  }
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (!GetArg(index + i, arg) || !arg.GetFloat(values[i]))
+      return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCArgsView::GetDoubles(size_t index, double *values, size_t count) const
+{
+  OSCArgView arg;
+  if (!GetArg(index, arg))
+    return false;
+
+  if (m_Tags[index] == 'd' && GetRunLength(index) >= count && (count * 8) <= static_cast<size_t>(m_End - arg.GetData()))
+  {
+    if (count < SimdUtils::sm_Min_Swap64_Count)
+    {
+      for (size_t i = 0; i < count; ++i)
+        values[i] = ReadFloat64(arg.GetData() + (i * 8));
+    }
+    else
+      SimdUtils::SwapBytes64(arg.GetData(), values, count);
+    return true;
+  }
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (!GetArg(index + i, arg) || !arg.GetDouble(values[i]))
+      return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCBundleIterator::OSCBundleIterator(const char *buf, size_t size)
+{
+  Push(buf, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBundleIterator::Next(const char *&element, size_t &size, OSCPacketInfo &info)
+{
+  while (m_Depth > 0)
+  {
+    sLevel &level = m_Levels[m_Depth - 1];
+    size_t remaining = static_cast<size_t>(level.end - level.pos);
+    if (remaining < 4)
+    {
+      // end of this bundle, resume parent
+      --m_Depth;
+      continue;
+    }
+
+    size_t elementSize = static_cast<size_t>(ReadUInt32(level.pos));
+    if (elementSize > (remaining - 4))
+    {
+      // truncated element, ignore the rest of this bundle
+      --m_Depth;
+      continue;
+    }
+
+    const char *elementData = (level.pos + 4);
+    level.pos = (elementData + elementSize);
+
+    if (!OSCPacketInfo::Parse(elementData, elementSize, info))
+      continue;
+
+    if (info.kind == OSCPacketInfo::KIND_BUNDLE)
+    {
+      Push(elementData, elementSize);
+      continue;
+    }
+
+    element = elementData;
+    size = elementSize;
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBundleIterator::Push(const char *buf, size_t size)
+{
+  if (m_Depth >= sm_Max_Depth || !buf || size < 16 || memcmp(buf, "#bundle", 8) != 0)
+    return false;
+
+  sLevel &level = m_Levels[m_Depth++];
+  level.pos = (buf + 16);
+  level.end = (buf + size);
+  level.timeTag = ReadUInt64(buf + 8);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCBufferWriter::OSCBufferWriter(char *buf, size_t capacity)
+  : m_Buf(buf)
+  , m_Capacity(buf ? capacity : 0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::Begin(const char *path, size_t pathLen, size_t maxArgs)
+{
+  m_Valid = false;
+
+  size_t pathSize = OSCPad4(pathLen + 1);
+  size_t tagsSize = OSCPad4(maxArgs + 2);
+  if (!path || pathLen == 0 || (pathSize + tagsSize) > m_Capacity)
+    return false;
+
+  memcpy(m_Buf, path, pathLen);
+  memset(&m_Buf[pathLen], 0, pathSize - pathLen);
+
+  m_PathLen = pathLen;
+  m_TagsOffset = pathSize;
+  m_Buf[m_TagsOffset] = ',';
+  m_TagCount = 0;
+  m_MaxTags = maxArgs;
+  m_DataOffset = (m_TagsOffset + tagsSize);
+  m_Size = m_DataOffset;
+  m_Valid = true;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+char *OSCBufferWriter::AddTag(char tag, size_t dataSize)
+{
+  return AddTags(tag, 1, dataSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+char *OSCBufferWriter::AddTags(char tag, size_t count, size_t dataSize)
+{
+  if (!m_Valid || (m_TagCount + count) > m_MaxTags || (m_Size + dataSize) > m_Capacity)
+  {
+    m_Valid = false;
+    return nullptr;
+  }
+
+  memset(&m_Buf[m_TagsOffset + 1 + m_TagCount], tag, count);
+  m_TagCount += count;
+  char *data = &m_Buf[m_Size];
+  m_Size += dataSize;
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddBool(bool b)
+{
+  return (AddTag(b ? 'T' : 'F', 0) != nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddInt32(int32_t n)
+{
+  char *data = AddTag('i', 4);
+  if (!data)
+    return false;
+
+  WriteUInt32(static_cast<uint32_t>(n), data);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddInt64(int64_t n)
+{
+  char *data = AddTag('h', 8);
+  if (!data)
+    return false;
+
+  WriteUInt64(static_cast<uint64_t>(n), data);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddUInt64(uint64_t n)
+{
+  char *data = AddTag('h', 8);
+  if (!data)
+    return false;
+
+  WriteUInt64(n, data);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddFloat32(float f)
+{
+  char *data = AddTag('f', 4);
+  if (!data)
+    return false;
+
+  uint32_t n;
+  memcpy(&n, &f, sizeof(n));
+  WriteUInt32(n, data);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddFloat64(double f)
+{
+  char *data = AddTag('d', 8);
+  if (!data)
+    return false;
+
+  uint64_t n;
+  memcpy(&n, &f, sizeof(n));
+  WriteUInt64(n, data);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddInt32Array(const int32_t *values, size_t count)
+{
+  char *data = AddTags('i', count, count * 4);
+  if (!data)
+    return false;
+
+  // short runs are written in place, as in OSCArgsView::GetInts
+  if (count < SimdUtils::sm_Min_Swap32_Count)
+  {
+    for (size_t i = 0; i < count; ++i)
+      WriteUInt32(static_cast<uint32_t>(values[i]), data + (i * 4));
+  }
+  else
+    SimdUtils::SwapBytes32(values, data, count);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddFloat32Array(const float *values, size_t count)
+{
+  char *data = AddTags('f', count, count * 4);
+  if (!data)
+    return false;
+
+  if (count < SimdUtils::sm_Min_Swap32_Count)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      uint32_t n;
+      memcpy(&n, &values[i], sizeof(n));
+      WriteUInt32(n, data + (i * 4));
+    }
+  }
+  else
+    SimdUtils::SwapBytes32(values, data, count);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddFloat64Array(const double *values, size_t count)
+{
+  char *data = AddTags('d', count, count * 8);
+  if (!data)
+    return false;
+
+  if (count < SimdUtils::sm_Min_Swap64_Count)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      uint64_t n;
+      memcpy(&n, &values[i], sizeof(n));
+      WriteUInt64(n, data + (i * 8));
+    }
+  }
+  else
+    SimdUtils::SwapBytes64(values, data, count);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddString(const char *str, size_t len)
+{
+  size_t size = OSCPad4(len + 1);
+  char *data = AddTag('s', size);
+  if (!data)
+    return false;
+
+  if (len != 0)
+    memcpy(data, str, len);
+  memset(&data[len], 0, size - len);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddArg(const OSCArgView &arg)
+{
+  char *data = AddTag(arg.GetTag(), arg.GetSize());
+  if (!data)
+    return false;
+
+  if (arg.GetSize() != 0)
+    memcpy(data, arg.GetData(), arg.GetSize());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::AddArgs(const OSCArgsView &args)
+{
+  size_t count = args.size();
+  size_t size = args.GetArgsDataSize();
+  if (!m_Valid || (m_TagCount + count) > m_MaxTags || (m_Size + size) > m_Capacity)
+  {
+    m_Valid = false;
+    return false;
+  }
+
+  if (count != 0)
+  {
+    memcpy(&m_Buf[m_TagsOffset + 1 + m_TagCount], args.GetTags(), count);
+    m_TagCount += count;
+  }
+
+  if (size != 0)
+  {
+    memcpy(&m_Buf[m_Size], args.GetArgsData(), size);
+    m_Size += size;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::End(size_t &size)
+{
+  if (!m_Valid)
+    return false;
+
+  // null terminate and pad the tags, then close any gap left by unused tag slots
+  size_t tagsEnd = (m_TagsOffset + 1 + m_TagCount);
+  size_t dataOffset = (m_TagsOffset + OSCPad4(m_TagCount + 2));
+  memset(&m_Buf[tagsEnd], 0, dataOffset - tagsEnd);
+
+  if (dataOffset < m_DataOffset)
+  {
+    size_t dataSize = (m_Size - m_DataOffset);
+    if (dataSize != 0)
+      memmove(&m_Buf[dataOffset], &m_Buf[m_DataOffset], dataSize);
+    m_Size -= (m_DataOffset - dataOffset);
+    m_DataOffset = dataOffset;
+  }
+
+  m_Valid = false;
+  size = m_Size;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCBufferWriter::GetInfo(OSCPacketInfo &info) const
+{
+  // describes the message completed by the last End
+  info.kind = OSCPacketInfo::KIND_MESSAGE;
+  info.pathLen = static_cast<uint32_t>(m_PathLen);
+  info.tagsOffset = static_cast<uint32_t>(m_TagsOffset);
+  info.tagCount = static_cast<uint32_t>(m_TagCount);
+  info.argsOffset = static_cast<uint32_t>(m_DataOffset);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBufferWriter::WriteForString(const char *str, size_t len, size_t &size)
+{
+  const char *end = (str + len);
+  const char *args = static_cast<const char *>(memchr(str, '=', len));
+  size_t pathLen = (args ? static_cast<size_t>(args - str) : len);
+
+  size_t maxArgs = 0;
+  if (args)
+  {
+    ++args;
+    maxArgs = 1;
+    for (const char *p = args; p < end; ++p)
+    {
+      if (*p == ',')
+        ++maxArgs;
+    }
+  }
+
+  if (!Begin(str, pathLen, maxArgs))
+    return false;
+
+  while (args && args <= end)
+  {
+    const char *argEnd = static_cast<const char *>(memchr(args, ',', static_cast<size_t>(end - args)));
+    if (!argEnd)
+      argEnd = end;
+
+    size_t argLen = static_cast<size_t>(argEnd - args);
+    char number[64];
+    bool added = false;
+    if (argLen != 0 && argLen < sizeof(number))
+    {
+      memcpy(number, args, argLen);
+      number[argLen] = 0;
+
+      char *numberEnd = nullptr;
+      long n = strtol(number, &numberEnd, 10);
+      if (numberEnd == &number[argLen])
+      {
+        added = AddInt32(static_cast<int32_t>(n));
+      }
+      else
+      {
+        float f = strtof(number, &numberEnd);
+        if (numberEnd == &number[argLen])
+          added = AddFloat32(f);
+        else
+          added = AddString(args, argLen);
+      }
+    }
+    else
+      added = AddString(args, argLen);
+
+    if (!added)
+      return false;
+
+    args = (argEnd + 1);
+  }
+
+  return End(size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t OSCBufferWriter::GetMaxSize(size_t pathLen, size_t maxArgs, size_t argsDataSize)
+{
+  return (OSCPad4(pathLen + 1) + OSCPad4(maxArgs + 2) + argsDataSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t OSCBufferWriter::GetMaxSizeForString(size_t len)
+{
+  // worst case is every character being a separator for an empty string argument
+  return GetMaxSize(len, len + 1, 4 * (len + 1) + len);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t OSCBufferWriter::GetMaxFrameSize(OSCStream::EnumFrameMode frameMode, size_t size)
+{
+  switch (frameMode)
+  {
+    case OSCStream::FRAME_MODE_1_0: return (size + 4);
+    case OSCStream::FRAME_MODE_1_1: return (2 * size + 2);
+    default: break;
+  }
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t OSCBufferWriter::WriteFrame(OSCStream::EnumFrameMode frameMode, const char *data, size_t size, char *buf, size_t capacity)
+{
+  if (!data || size == 0 || !buf)
+    return 0;
+
+  switch (frameMode)
+  {
+    case OSCStream::FRAME_MODE_1_0:
+    {
+      if ((size + 4) > capacity || size > 0x7fffffff)
+        return 0;
+
+      WriteUInt32(static_cast<uint32_t>(size), buf);
+      memcpy(&buf[4], data, size);
+      return (size + 4);
+    }
+
+    case OSCStream::FRAME_MODE_1_1:
+    {
+      if (capacity < (size + 2))
+        return 0;
+
+      unsigned char *dst = reinterpret_cast<unsigned char *>(buf);
+      unsigned char *dstEnd = (dst + capacity - 1);  // leave room for closing SLIP_END
+      *dst++ = SLIP_END;
+      const unsigned char *src = reinterpret_cast<const unsigned char *>(data);
+      for (const unsigned char *srcEnd = (src + size); src < srcEnd; ++src)
+      {
+        if (*src == SLIP_END || *src == SLIP_ESC)
+        {
+          if ((dst + 2) > dstEnd)
+            return 0;
+
+          *dst++ = SLIP_ESC;
+          *dst++ = ((*src == SLIP_END) ? SLIP_ESC_END : SLIP_ESC_ESC);
+        }
+        else
+        {
+          if (dst >= dstEnd)
+            return 0;
+
+          *dst++ = *src;
+        }
+      }
+      *dst++ = SLIP_END;
+      return static_cast<size_t>(reinterpret_cast<char *>(dst) - buf);
+    }
+
+    default: break;
+  }
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCBundleWriter::OSCBundleWriter(char *buf, size_t capacity)
+  : m_Buf(buf)
+  , m_Capacity(buf ? capacity : 0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBundleWriter::Begin(uint64_t timeTag /*= sm_Time_Tag_Immediate*/)
+{
+  m_Size = m_Count = 0;
+  m_Valid = (m_Capacity >= sm_Header_Size);
+  if (!m_Valid)
+    return false;
+
+  memcpy(m_Buf, "#bundle", 8);
+  WriteUInt64(timeTag, &m_Buf[8]);
+  m_Size = sm_Header_Size;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCBundleWriter::Add(const char *element, size_t size)
+{
+  if (!element || size == 0 || size > 0x7fffffff || !CanAdd(size))
+    return false;
+
+  WriteUInt32(static_cast<uint32_t>(size), &m_Buf[m_Size]);
+  memcpy(&m_Buf[m_Size + 4], element, size);
+  m_Size += (4 + size);
+  ++m_Count;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t OSCStreamFramer::sm_Default_Max_Frame_Size = 0x100000;
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCStreamFramer::OSCStreamFramer(OSCStream::EnumFrameMode frameMode, size_t maxFrameSize /*= sm_Default_Max_Frame_Size*/)
+  : m_FrameMode(frameMode)
+  , m_MaxFrameSize(maxFrameSize)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCStreamFramer::Reset()
+{
+  m_Begin = m_End = m_Scanned = 0;
+  m_Ext = nullptr;
+  m_ExtSize = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCStreamFramer::Add(const char *data, size_t size)
+{
+  // keep anything the caller did not drain from the previous Add
+  if (m_ExtSize != 0)
+  {
+    Append(m_Ext, m_ExtSize);
+    m_Ext = nullptr;
+    m_ExtSize = 0;
+  }
+
+  if (!data || size == 0)
+    return;
+
+  if (m_Begin == m_End)
+  {
+    // nothing buffered, so frames can be viewed straight from the caller's data
+    m_Begin = m_End = m_Scanned = 0;
+    m_Ext = data;
+    m_ExtSize = size;
+  }
+  else
+    Append(data, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCStreamFramer::GetNextFrame(const char *&frame, size_t &size)
+{
+  for (;;)
+  {
+    size_t consumed = 0;
+
+    if (m_Begin != m_End)
+    {
+      if (GetNextFrame(&m_Buf[m_Begin], nullptr, m_End - m_Begin, m_Scanned, frame, size, consumed))
+      {
+        m_Begin += consumed;
+        m_Scanned = 0;
+        if (m_Begin == m_End)
+          m_Begin = m_End = 0;
+        if (size != 0)
+          return true;
+        continue;
+      }
+
+      m_Scanned = consumed;
+
+      // partial frame buffered, so the rest of the caller's data has to join it
+      if (m_ExtSize == 0)
+        return false;
+
+      Append(m_Ext, m_ExtSize);
+      m_Ext = nullptr;
+      m_ExtSize = 0;
+      continue;
+    }
+
+    if (m_ExtSize == 0)
+      return false;
+
+    if (GetNextFrame(nullptr, m_Ext, m_ExtSize, 0, frame, size, consumed))
+    {
+      m_Ext += consumed;
+      m_ExtSize -= consumed;
+      if (size != 0)
+        return true;
+      continue;
+    }
+
+    // partial frame at the end of the caller's data
+    Append(m_Ext, m_ExtSize);
+    m_Scanned = consumed;
+    m_Ext = nullptr;
+    m_ExtSize = 0;
+    return false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OSCStreamFramer::GetNextFrame(char *data, const char *constData, size_t available, size_t scanned, const char *&frame, size_t &size, size_t &consumed)
+{
+  // data is writable and may be unescaped in place, constData belongs to the caller
+  const char *src = (data ? data : constData);
+  frame = nullptr;
+  size = 0;
+  consumed = 0;
+
+  switch (m_FrameMode)
+  {
+    case OSCStream::FRAME_MODE_1_0:
+    {
+      if (available < 4)
+        return false;
+
+      size_t frameSize = static_cast<size_t>(ReadUInt32(src));
+      if (frameSize > m_MaxFrameSize)
+      {
+        // invalid length, the stream can not be re-synchronized so drop what is buffered
+        consumed = available;
+        return true;
+      }
+
+      if (available < (frameSize + 4))
+        return false;
+
+      frame = (src + 4);
+      size = frameSize;
+      consumed = (frameSize + 4);
+      return true;
+    }
+
+    case OSCStream::FRAME_MODE_1_1:
+    {
+      const char *end = SimdUtils::FindByte(src + scanned, available - scanned, static_cast<char>(SLIP_END));
+      if (!end)
+      {
+        if (available > m_MaxFrameSize)
+        {
+          // runaway frame
+          consumed = available;
+          return true;
+        }
+
+        consumed = available;  // remember how far was searched
+        return false;
+      }
+
+      size_t frameSize = static_cast<size_t>(end - src);
+      consumed = (frameSize + 1);
+      if (frameSize == 0)
+        return true;  // empty frame between END markers
+
+      if (!SimdUtils::FindByte(src, frameSize, static_cast<char>(SLIP_ESC)))
+      {
+        frame = src;
+        size = frameSize;
+        return true;
+      }
+
+      // escaped, unescape in place if the bytes are ours, otherwise into scratch space
+      char *dst = data;
+      if (!dst)
+      {
+        if (m_Unescaped.size() < frameSize)
+          m_Unescaped.resize(frameSize);
+        dst = m_Unescaped.data();
+      }
+
+      char *out = dst;
+      for (const char *in = src; in < end; ++in)
+      {
+        if (static_cast<unsigned char>(*in) == SLIP_ESC && (in + 1) < end)
+        {
+          ++in;
+          if (static_cast<unsigned char>(*in) == SLIP_ESC_END)
+            *out++ = static_cast<char>(SLIP_END);
+          else if (static_cast<unsigned char>(*in) == SLIP_ESC_ESC)
+            *out++ = static_cast<char>(SLIP_ESC);
+          else
+            *out++ = *in;
+        }
+        else
+          *out++ = *in;
+      }
+
+      frame = dst;
+      size = static_cast<size_t>(out - dst);
+      return true;
+    }
+
+    default:
+      // unknown framing, drop everything
+      consumed = available;
+      return true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCStreamFramer::Append(const char *data, size_t size)
+{
+  if (m_Begin != 0)
+  {
+    // compact consumed bytes away
+    if (m_End > m_Begin)
+      memmove(m_Buf.data(), &m_Buf[m_Begin], m_End - m_Begin);
+    m_End -= m_Begin;
+    m_Begin = 0;
+  }
+
+  if ((m_End + size) > m_Buf.size())
+    m_Buf.resize(m_End + size);
+
+  memcpy(&m_Buf[m_End], data, size);
+  m_End += size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const OSCAddressTable::ID OSCAddressTable::sm_Invalid_Id = static_cast<OSCAddressTable::ID>(-1);
+const size_t OSCAddressTable::sm_Default_Max_Entries = 16384;
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCAddressTable::OSCAddressTable(size_t maxEntries /*= sm_Default_Max_Entries*/)
+  : m_MaxEntries(maxEntries)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCAddressTable::ID OSCAddressTable::Intern(const char *address, size_t len)
+{
+  if (!address || len == 0)
+    return sm_Invalid_Id;
+
+  uint32_t hash = Hash(address, len);
+  if (!m_Slots.empty())
+  {
+    size_t slot = FindSlot(address, len, hash);
+    if (m_Slots[slot] != sm_Invalid_Id)
+      return m_Slots[slot];
+  }
+
+  if (full())
+    return sm_Invalid_Id;
+
+  // keep load factor at or below 1/2
+  if ((m_Entries.size() + 1) * 2 > m_Slots.size())
+    Rehash(std::max<size_t>(64, m_Slots.size() * 2));
+
+  ID id = static_cast<ID>(m_Entries.size());
+  m_Entries.emplace_back();
+  sEntry &entry = m_Entries.back();
+  entry.address.assign(address, len);
+  entry.hash = hash;
+  Split(address, len, entry.segments);
+
+  m_Slots[FindSlot(address, len, hash)] = id;
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OSCAddressTable::ID OSCAddressTable::Find(const char *address, size_t len) const
+{
+  if (!address || len == 0 || m_Slots.empty())
+    return sm_Invalid_Id;
+
+  return m_Slots[FindSlot(address, len, Hash(address, len))];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCAddressTable::Clear()
+{
+  m_Entries.clear();
+  m_Slots.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t OSCAddressTable::Hash(const char *address, size_t len)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; ++i)
+  {
+    hash ^= static_cast<unsigned char>(address[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCAddressTable::Split(const char *address, size_t len, SEGMENTS &segments)
+{
+  segments.clear();
+
+  size_t start = 0;
+  for (size_t i = 0; i <= len; ++i)
+  {
+    if (i == len || address[i] == OSC_ADDR_SEPARATOR)
+    {
+      if (i > start)
+      {
+        sSegment segment;
+        segment.offset = static_cast<uint32_t>(start);
+        segment.size = static_cast<uint32_t>(i - start);
+        segments.push_back(segment);
+      }
+      start = (i + 1);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t OSCAddressTable::FindSlot(const char *address, size_t len, uint32_t hash) const
+{
+  // linear probing, slot count is a power of 2 and never full
+  size_t mask = (m_Slots.size() - 1);
+  for (size_t slot = (hash & mask);; slot = ((slot + 1) & mask))
+  {
+    ID id = m_Slots[slot];
+    if (id == sm_Invalid_Id)
+      return slot;
+
+    const sEntry &entry = m_Entries[id];
+    if (entry.hash == hash && entry.address.size() == len && memcmp(entry.address.data(), address, len) == 0)
+      return slot;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OSCAddressTable::Rehash(size_t slotCount)
+{
+  m_Slots.assign(slotCount, sm_Invalid_Id);
+
+  size_t mask = (slotCount - 1);
+  for (size_t i = 0; i < m_Entries.size(); ++i)
+  {
+    size_t slot = (m_Entries[i].hash & mask);
+    while (m_Slots[slot] != sm_Invalid_Id)
+      slot = ((slot + 1) & mask);
+    m_Slots[slot] = static_cast<ID>(i);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,311 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef OSC_UTILS_H
+#define OSC_UTILS_H
+
+#ifndef OSC_PARSER_H
+#include "OSCParser.h"
+#endif
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// result of the one-time scan done when a packet is received, so later stages do not re-scan it
+struct OSCPacketInfo
+{
+  enum EnumKind
+  {
+    KIND_INVALID = 0,
+    KIND_MESSAGE,
+    KIND_BUNDLE
+  };
+
+  bool IsOSC() const { return (kind != KIND_INVALID); }
+  static bool Parse(const char *buf, size_t size, OSCPacketInfo &info);
+
+  EnumKind kind = KIND_INVALID;
+  uint32_t pathLen = 0;     // osc address length, not including null terminator
+  uint32_t tagsOffset = 0;  // offset of ',' type tag string, or packet size if no type tags
+  uint32_t tagCount = 0;    // number of type tags, not including ','
+  uint32_t argsOffset = 0;  // offset of first argument
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// non-owning view of a single osc argument inside a packet buffer
+class OSCArgView
+{
+public:
+  OSCArgView() = default;
+  OSCArgView(char tag, const char *data, size_t size)
+    : m_Tag(tag)
+    , m_Data(data)
+    , m_Size(size)
+  {
+  }
+
+  char GetTag() const { return m_Tag; }
+  OSCArgument::EnumArgumentTypes GetType() const { return GetTypeForTag(m_Tag); }
+  const char *GetData() const { return m_Data; }
+  size_t GetSize() const { return m_Size; }
+
+  bool GetInt(int &n) const;
+  bool GetInt64(int64_t &n) const;
+  bool GetUInt64(uint64_t &n) const;
+  bool GetFloat(float &f) const;
+  bool GetDouble(double &f) const;
+  bool GetString(std::string &str) const;
+
+  static OSCArgument::EnumArgumentTypes GetTypeForTag(char tag);
+  static bool GetArgSize(char tag, const char *data, size_t maxSize, size_t &size);
+
+private:
+  char m_Tag = 0;
+  const char *m_Data = nullptr;
+  size_t m_Size = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// non-owning view of the arguments of an osc message, decoded lazily in place
+class OSCArgsView
+{
+public:
+  OSCArgsView() = default;
+  OSCArgsView(const char *buf, size_t size);
+  OSCArgsView(const char *buf, size_t size, const OSCPacketInfo &info);
+
+  bool empty() const { return (m_Count == 0); }
+  size_t size() const { return m_Count; }
+  const char *GetTags() const { return m_Tags; }
+  bool GetArg(size_t index, OSCArgView &arg) const;
+
+  // runs of same type numeric arguments are converted from big-endian in one pass
+  size_t GetRunLength(size_t index) const;
+  bool GetInts(size_t index, int32_t *values, size_t count) const;
+  bool GetFloats(size_t index, float *values, size_t count) const;
+  bool GetDoubles(size_t index, double *values, size_t count) const;
+  const char *GetArgsData() const { return m_Data; }
+  size_t GetArgsDataSize() const { return (m_Data ? static_cast<size_t>(m_End - m_Data) : 0); }
+
+private:
+  const char *m_Tags = nullptr;
+  size_t m_Count = 0;
+  const char *m_Data = nullptr;
+  const char *m_End = nullptr;
+
+  // sequential access is the common case, so remember where the last lookup ended
+  mutable size_t m_CursorIndex = 0;
+  mutable const char *m_Cursor = nullptr;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// walks the messages of an osc bundle, descending into nested bundles
+// elements are views into the original buffer, nothing is copied
+class OSCBundleIterator
+{
+public:
+  OSCBundleIterator(const char *buf, size_t size);
+
+  bool Next(const char *&element, size_t &size, OSCPacketInfo &info);
+  uint64_t GetTimeTag() const { return ((m_Depth > 0) ? m_Levels[m_Depth - 1].timeTag : 0); }
+  size_t GetDepth() const { return m_Depth; }
+
+  static const size_t sm_Max_Depth = 8;
+
+private:
+  struct sLevel
+  {
+    const char *pos = nullptr;
+    const char *end = nullptr;
+    uint64_t timeTag = 0;
+  };
+
+  sLevel m_Levels[sm_Max_Depth];
+  size_t m_Depth = 0;
+
+  bool Push(const char *buf, size_t size);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// encodes an osc message directly into a caller supplied buffer
+// room for the type tags is reserved up front by Begin, and trimmed by End if fewer arguments were added
+class OSCBufferWriter
+{
+public:
+  OSCBufferWriter(char *buf, size_t capacity);
+
+  bool Begin(const char *path, size_t pathLen, size_t maxArgs);
+  bool AddBool(bool b);
+  bool AddInt32(int32_t n);
+  bool AddInt64(int64_t n);
+  bool AddUInt64(uint64_t n);
+  bool AddFloat32(float f);
+  bool AddFloat64(double f);
+  bool AddInt32Array(const int32_t *values, size_t count);
+  bool AddFloat32Array(const float *values, size_t count);
+  bool AddFloat64Array(const double *values, size_t count);
+  bool AddString(const char *str, size_t len);
+  bool AddArg(const OSCArgView &arg);
+  bool AddArgs(const OSCArgsView &args);
+  bool End(size_t &size);
+  void GetInfo(OSCPacketInfo &info) const;
+
+  // "/path=arg1,arg2,..." where each argument is written as an int, float or string
+  bool WriteForString(const char *str, size_t len, size_t &size);
+
+  static size_t GetMaxSize(size_t pathLen, size_t maxArgs, size_t argsDataSize);
+  static size_t GetMaxSizeForString(size_t len);
+  static size_t GetMaxFrameSize(OSCStream::EnumFrameMode frameMode, size_t size);
+  static size_t WriteFrame(OSCStream::EnumFrameMode frameMode, const char *data, size_t size, char *buf, size_t capacity);
+
+private:
+  char *m_Buf;
+  size_t m_Capacity;
+  size_t m_PathLen = 0;
+  size_t m_TagsOffset = 0;
+  size_t m_TagCount = 0;
+  size_t m_MaxTags = 0;
+  size_t m_DataOffset = 0;
+  size_t m_Size = 0;
+  bool m_Valid = false;
+
+  char *AddTag(char tag, size_t dataSize);
+  char *AddTags(char tag, size_t count, size_t dataSize);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// packs osc messages into a bundle in a caller supplied buffer
+class OSCBundleWriter
+{
+public:
+  OSCBundleWriter(char *buf, size_t capacity);
+
+  bool Begin(uint64_t timeTag = sm_Time_Tag_Immediate);
+  bool Add(const char *element, size_t size);
+  bool CanAdd(size_t size) const { return (m_Valid && (m_Size + 4 + size) <= m_Capacity); }
+  size_t GetCount() const { return m_Count; }
+  size_t GetSize() const { return m_Size; }
+
+  static size_t GetMaxSize(size_t elementCount, size_t elementsSize) { return (sm_Header_Size + 4 * elementCount + elementsSize); }
+
+  static const size_t sm_Header_Size = 16;
+  static const uint64_t sm_Time_Tag_Immediate = 1;
+
+private:
+  char *m_Buf;
+  size_t m_Capacity;
+  size_t m_Size = 0;
+  size_t m_Count = 0;
+  bool m_Valid = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// incremental decoder for length prefixed (osc 1.0) and SLIP (osc 1.1) framed tcp streams
+// frames are returned as views, either into the data passed to Add or into an internal buffer that is reused
+// views are valid until the next call to GetNextFrame, Add or Reset
+class OSCStreamFramer
+{
+public:
+  OSCStreamFramer(OSCStream::EnumFrameMode frameMode, size_t maxFrameSize = sm_Default_Max_Frame_Size);
+
+  void Reset();
+  void Add(const char *data, size_t size);
+  bool GetNextFrame(const char *&frame, size_t &size);
+
+  static const size_t sm_Default_Max_Frame_Size;
+
+private:
+  OSCStream::EnumFrameMode m_FrameMode;
+  size_t m_MaxFrameSize;
+  std::vector<char> m_Buf;
+  size_t m_Begin = 0;
+  size_t m_End = 0;
+  size_t m_Scanned = 0;  // bytes past m_Begin already searched for a SLIP_END
+  std::vector<char> m_Unescaped;
+  const char *m_Ext = nullptr;
+  size_t m_ExtSize = 0;
+
+  bool GetNextFrame(char *data, const char *constData, size_t available, size_t scanned, const char *&frame, size_t &size, size_t &consumed);
+  void Append(const char *data, size_t size);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// maps each distinct osc address to a small integer id, with its hash and path segments cached
+// ids stay valid until Clear, and no new ids are handed out once the table is full
+class OSCAddressTable
+{
+public:
+  typedef uint32_t ID;
+
+  struct sSegment
+  {
+    uint32_t offset = 0;
+    uint32_t size = 0;
+  };
+
+  typedef std::vector<sSegment> SEGMENTS;
+
+  struct sEntry
+  {
+    std::string address;
+    uint32_t hash = 0;
+    SEGMENTS segments;
+  };
+
+  OSCAddressTable(size_t maxEntries = sm_Default_Max_Entries);
+
+  ID Intern(const char *address, size_t len);
+  ID Find(const char *address, size_t len) const;
+  const sEntry *GetEntry(ID id) const { return ((id < m_Entries.size()) ? &m_Entries[id] : nullptr); }
+  size_t size() const { return m_Entries.size(); }
+  bool full() const { return (m_Entries.size() >= m_MaxEntries); }
+  void Clear();
+
+  static uint32_t Hash(const char *address, size_t len);
+  static void Split(const char *address, size_t len, SEGMENTS &segments);
+
+  static const ID sm_Invalid_Id;
+  static const size_t sm_Default_Max_Entries;
+
+private:
+  typedef std::vector<ID> SLOTS;
+
+  std::vector<sEntry> m_Entries;
+  SLOTS m_Slots;
+  size_t m_MaxEntries;
+
+  size_t FindSlot(const char *address, size_t len, uint32_t hash) const;
+  void Rehash(size_t slotCount);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
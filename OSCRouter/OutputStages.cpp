@@ -0,0 +1,751 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OutputStages.h"
+
+#include <cstring>
+
+// must be last include
+#include "LeakWatcher.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+OutputBundler::OutputBundler(const EosOutputOptions &options)
+  : m_Options(options)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputBundler::Bundle(EosPacket::Q &packets, EosPacket::Q &datagrams)
+{
+  if (!m_Options.bundle)
+  {
+    for (EosPacket::Q::iterator i = packets.begin(); i != packets.end(); i++)
+      datagrams.push_back(std::move(*i));
+    packets.clear();
+    return;
+  }
+
+  size_t mtu = static_cast<size_t>(m_Options.bundleMTU);
+  OSCBundleWriter writer(m_Bundle.Reserve(static_cast<int>(mtu)), mtu);
+  writer.Begin();
+
+  for (EosPacket::Q::iterator i = packets.begin(); i != packets.end(); i++)
+  {
+    EosPacket &packet = *i;
+    const char *data = packet.GetDataConst();
+    size_t size = ((packet.GetSize() > 0) ? static_cast<size_t>(packet.GetSize()) : 0);
+
+    bool isMessage = (data && size != 0 && data[0] == '/');
+    if (isMessage && OSCBundleWriter::GetMaxSize(1, size) <= mtu)
+    {
+      if (!writer.CanAdd(size))
+      {
+        Flush(writer, datagrams);
+        writer = OSCBundleWriter(m_Bundle.Reserve(static_cast<int>(mtu)), mtu);
+        writer.Begin();
+      }
+
+      writer.Add(data, size);
+    }
+    else
+    {
+      // keep arrival order
+      if (writer.GetCount() != 0)
+      {
+        Flush(writer, datagrams);
+        writer = OSCBundleWriter(m_Bundle.Reserve(static_cast<int>(mtu)), mtu);
+        writer.Begin();
+      }
+
+      datagrams.push_back(std::move(packet));
+    }
+  }
+
+  Flush(writer, datagrams);
+  packets.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputBundler::Flush(OSCBundleWriter &writer, EosPacket::Q &datagrams)
+{
+  if (writer.GetCount() == 0)
+    return;
+
+  if (writer.GetCount() == 1)
+  {
+    // a bundle of one only adds overhead
+    const char *element = (m_Bundle.GetDataConst() + OSCBundleWriter::sm_Header_Size + 4);
+    datagrams.push_back(EosPacket(element, static_cast<int>(writer.GetSize() - OSCBundleWriter::sm_Header_Size - 4)));
+  }
+  else
+  {
+    m_Bundle.Resize(static_cast<int>(writer.GetSize()));
+    datagrams.push_back(std::move(m_Bundle));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OutputCoalescer::OutputCoalescer(unsigned int keyArgs)
+  : m_KeyArgs(keyArgs)
+{
+  Rehash(1024);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputCoalescer::Add(EosPacket &packet)
+{
+  // returns true if an older message with the same key was replaced
+  m_Entries.emplace_back();
+  sEntry &entry = m_Entries.back();
+  entry.packet = std::move(packet);
+  if (!MakeKey(entry))
+    return false;
+
+  size_t mask = (m_Slots.size() - 1);
+  for (size_t slot = (entry.hash & mask);; slot = ((slot + 1) & mask))
+  {
+    uint32_t index = m_Slots[slot];
+    if (index == 0)
+    {
+      m_Slots[slot] = static_cast<uint32_t>(m_Entries.size());
+      entry.slot = static_cast<uint32_t>(slot);
+
+      // keep load factor at or below 1/2
+      if (m_Entries.size() * 2 > m_Slots.size())
+        Rehash(m_Slots.size() * 2);
+      return false;
+    }
+
+    sEntry &existing = m_Entries[index - 1];
+    if (existing.hash == entry.hash && KeysEqual(existing, entry))
+    {
+      existing = std::move(entry);
+      existing.slot = static_cast<uint32_t>(slot);
+      m_Entries.pop_back();
+      return true;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputCoalescer::Flush(EosPacket::Q &packets)
+{
+  for (ENTRIES::iterator i = m_Entries.begin(); i != m_Entries.end(); i++)
+  {
+    if (i->keyed)
+      m_Slots[i->slot] = 0;
+    packets.push_back(std::move(i->packet));
+  }
+
+  m_Entries.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputCoalescer::MakeKey(sEntry &entry) const
+{
+  const char *data = entry.packet.GetDataConst();
+  size_t size = ((entry.packet.GetSize() > 0) ? static_cast<size_t>(entry.packet.GetSize()) : 0);
+
+  OSCPacketInfo info;
+  if (!OSCPacketInfo::Parse(data, size, info) || info.kind != OSCPacketInfo::KIND_MESSAGE)
+    return false;
+
+  entry.pathLen = info.pathLen;
+
+  if (m_KeyArgs != 0 && info.tagCount != 0)
+  {
+    OSCArgsView args(data, size, info);
+    size_t keyArgs = qMin(static_cast<size_t>(m_KeyArgs), args.size());
+    OSCArgView lastArg;
+    if (keyArgs != 0 && args.GetArg(keyArgs - 1, lastArg))
+    {
+      entry.tagsOffset = (info.tagsOffset + 1);
+      entry.tagsLen = static_cast<uint32_t>(keyArgs);
+      entry.argsOffset = info.argsOffset;
+      entry.argsLen = static_cast<uint32_t>((lastArg.GetData() + lastArg.GetSize()) - (data + info.argsOffset));
+    }
+  }
+
+  uint32_t hash = OSCAddressTable::Hash(data, entry.pathLen);
+  hash = ((hash * 31u) ^ OSCAddressTable::Hash(&data[entry.tagsOffset], entry.tagsLen));
+  hash = ((hash * 31u) ^ OSCAddressTable::Hash(&data[entry.argsOffset], entry.argsLen));
+  entry.hash = hash;
+  entry.keyed = true;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputCoalescer::KeysEqual(const sEntry &a, const sEntry &b) const
+{
+  if (a.pathLen != b.pathLen || a.tagsLen != b.tagsLen || a.argsLen != b.argsLen)
+    return false;
+
+  const char *dataA = a.packet.GetDataConst();
+  const char *dataB = b.packet.GetDataConst();
+  return (memcmp(dataA, dataB, a.pathLen) == 0 && memcmp(&dataA[a.tagsOffset], &dataB[b.tagsOffset], a.tagsLen) == 0 &&
+          memcmp(&dataA[a.argsOffset], &dataB[b.argsOffset], a.argsLen) == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputCoalescer::Rehash(size_t slotCount)
+{
+  m_Slots.assign(slotCount, 0);
+
+  size_t mask = (slotCount - 1);
+  for (size_t i = 0; i < m_Entries.size(); ++i)
+  {
+    sEntry &entry = m_Entries[i];
+    if (!entry.keyed)
+      continue;
+
+    size_t slot = (entry.hash & mask);
+    while (m_Slots[slot] != 0)
+      slot = ((slot + 1) & mask);
+    m_Slots[slot] = static_cast<uint32_t>(i + 1);
+    entry.slot = static_cast<uint32_t>(slot);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t ChangeFilter::sm_Default_Max_Entries = 65536;
+
+////////////////////////////////////////////////////////////////////////////////
+
+ChangeFilter::ChangeFilter(unsigned int keepAliveMS, size_t maxEntries)
+  : m_KeepAliveMS(keepAliveMS)
+  , m_MaxEntries(maxEntries)
+{
+  m_Entries.reserve(qMin(maxEntries, static_cast<size_t>(512)));
+  Rehash(1024);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ChangeFilter::Pass(unsigned int ip, unsigned short port, const char *buf, size_t size, const OSCPacketInfo &info, int64_t nowMS)
+{
+  // only plain osc messages are filtered
+  if (info.kind != OSCPacketInfo::KIND_MESSAGE || info.tagsOffset > size)
+    return true;
+
+  uint64_t dst = ((static_cast<uint64_t>(ip) << 16) | port);
+  size_t pathLen = info.pathLen;
+  const char *payload = &buf[info.tagsOffset];
+  size_t payloadSize = (size - info.tagsOffset);
+  uint32_t hash = (OSCAddressTable::Hash(buf, pathLen) ^ static_cast<uint32_t>(dst * 0x9e3779b97f4a7c15ull >> 32));
+
+  size_t mask = (m_Slots.size() - 1);
+  size_t slot = (hash & mask);
+  for (;; slot = ((slot + 1) & mask))
+  {
+    uint32_t index = m_Slots[slot];
+    if (index == 0)
+      break;
+
+    sEntry &entry = m_Entries[index - 1];
+    if (entry.hash == hash && entry.dst == dst && entry.pathLen == pathLen && memcmp(entry.data.data(), buf, pathLen) == 0)
+    {
+      bool unchanged = ((entry.data.size() - pathLen) == payloadSize && memcmp(&entry.data[pathLen], payload, payloadSize) == 0);
+      if (unchanged && (m_KeepAliveMS == 0 || (nowMS - entry.sentMS) < static_cast<int64_t>(m_KeepAliveMS)))
+      {
+        ++m_Suppressed;
+        m_SuppressedBytes += size;
+        return false;
+      }
+
+      if (!unchanged)
+      {
+        entry.data.resize(pathLen + payloadSize);
+        memcpy(&entry.data[pathLen], payload, payloadSize);
+      }
+      entry.sentMS = nowMS;
+      return true;
+    }
+  }
+
+  // new address, remembered unless the table is full
+  if (m_Entries.size() < m_MaxEntries)
+  {
+    m_Entries.emplace_back();
+    sEntry &entry = m_Entries.back();
+    entry.dst = dst;
+    entry.hash = hash;
+    entry.pathLen = static_cast<uint32_t>(pathLen);
+    entry.data.resize(pathLen + payloadSize);
+    memcpy(entry.data.data(), buf, pathLen);
+    memcpy(&entry.data[pathLen], payload, payloadSize);
+    entry.sentMS = nowMS;
+    m_Slots[slot] = static_cast<uint32_t>(m_Entries.size());
+
+    // keep load factor at or below 1/2
+    if (m_Entries.size() * 2 > m_Slots.size())
+      Rehash(m_Slots.size() * 2);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ChangeFilter::Rehash(size_t slotCount)
+{
+  m_Slots.assign(slotCount, 0);
+
+  size_t mask = (slotCount - 1);
+  for (size_t i = 0; i < m_Entries.size(); ++i)
+  {
+    size_t slot = (m_Entries[i].hash & mask);
+    while (m_Slots[slot] != 0)
+      slot = ((slot + 1) & mask);
+    m_Slots[slot] = static_cast<uint32_t>(i + 1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t StateStore::sm_Default_Max_Entries = 65536;
+
+////////////////////////////////////////////////////////////////////////////////
+
+StateStore::StateStore(size_t maxEntries)
+  : m_MaxEntries(maxEntries)
+{
+  Rehash(1024);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StateStore::Update(uint64_t dst, const char *buf, size_t size, const OSCPacketInfo &info)
+{
+  if (info.kind != OSCPacketInfo::KIND_MESSAGE || info.pathLen == 0 || info.pathLen > size)
+    return;
+
+  size_t pathLen = info.pathLen;
+  uint32_t hash = (OSCAddressTable::Hash(buf, pathLen) ^ static_cast<uint32_t>(dst * 0x9e3779b97f4a7c15ull >> 32));
+
+  size_t mask = (m_Slots.size() - 1);
+  size_t slot = (hash & mask);
+  for (;; slot = ((slot + 1) & mask))
+  {
+    uint32_t index = m_Slots[slot];
+    if (index == 0)
+      break;
+
+    sEntry &entry = m_Entries[index - 1];
+    if (entry.hash == hash && entry.dst == dst && entry.pathLen == pathLen && memcmp(entry.data.data(), buf, pathLen) == 0)
+    {
+      entry.data.assign(buf, buf + size);
+      return;
+    }
+  }
+
+  // new address, remembered unless the table is full
+  if (m_Entries.size() < m_MaxEntries)
+  {
+    m_Entries.emplace_back();
+    sEntry &entry = m_Entries.back();
+    entry.dst = dst;
+    entry.hash = hash;
+    entry.pathLen = static_cast<uint32_t>(pathLen);
+    entry.data.assign(buf, buf + size);
+    m_Slots[slot] = static_cast<uint32_t>(m_Entries.size());
+
+    // keep load factor at or below 1/2
+    if (m_Entries.size() * 2 > m_Slots.size())
+      Rehash(m_Slots.size() * 2);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t StateStore::Snapshot(uint64_t dst, size_t mtu, EosPacket::Q &packets) const
+{
+  size_t count = 0;
+  EosPacket bundle;
+  OSCBundleWriter writer(bundle.Reserve(static_cast<int>(mtu)), mtu);
+  writer.Begin();
+
+  for (ENTRIES::const_iterator i = m_Entries.begin(); i != m_Entries.end(); i++)
+  {
+    if (i->dst != dst)
+      continue;
+
+    const char *data = i->data.data();
+    size_t size = i->data.size();
+    if (!writer.CanAdd(size))
+    {
+      if (writer.GetCount() != 0)
+      {
+        bundle.Resize(static_cast<int>(writer.GetSize()));
+        packets.push_back(std::move(bundle));
+        writer = OSCBundleWriter(bundle.Reserve(static_cast<int>(mtu)), mtu);
+        writer.Begin();
+      }
+
+      if (!writer.CanAdd(size))
+      {
+        // too large to bundle
+        packets.push_back(EosPacket(data, static_cast<int>(size)));
+        ++count;
+        continue;
+      }
+    }
+
+    writer.Add(data, size);
+    ++count;
+  }
+
+  if (writer.GetCount() != 0)
+  {
+    bundle.Resize(static_cast<int>(writer.GetSize()));
+    packets.push_back(std::move(bundle));
+  }
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StateStore::Rehash(size_t slotCount)
+{
+  m_Slots.assign(slotCount, 0);
+
+  size_t mask = (slotCount - 1);
+  for (size_t i = 0; i < m_Entries.size(); ++i)
+  {
+    size_t slot = (m_Entries[i].hash & mask);
+    while (m_Slots[slot] != 0)
+      slot = ((slot + 1) & mask);
+    m_Slots[slot] = static_cast<uint32_t>(i + 1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OutputPacer::OutputPacer(unsigned int rate, unsigned int burst, uint64_t nowUS)
+  : m_Rate(rate)
+  , m_Capacity(static_cast<uint64_t>((burst == 0) ? 1 : burst) * 1000000)
+  , m_LastUS(nowUS)
+{
+  m_Tokens = m_Capacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputPacer::Take(uint64_t nowUS)
+{
+  if (m_Rate == 0)
+    return true;
+
+  Refill(nowUS);
+  if (m_Tokens < 1000000)
+    return false;
+
+  m_Tokens -= 1000000;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t OutputPacer::GetNextUS(uint64_t nowUS) const
+{
+  if (m_Rate == 0 || m_Tokens >= 1000000)
+    return nowUS;
+
+  // each microsecond adds rate millionths of a packet
+  uint64_t elapsedUS = ((nowUS > m_LastUS) ? (nowUS - m_LastUS) : 0);
+  if (elapsedUS >= 1000000)
+    return nowUS;
+
+  uint64_t tokens = (m_Tokens + elapsedUS * m_Rate);
+  if (tokens >= 1000000)
+    return nowUS;
+
+  return (nowUS + (1000000 - tokens + m_Rate - 1) / m_Rate);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputPacer::Refill(uint64_t nowUS)
+{
+  if (nowUS <= m_LastUS)
+    return;
+
+  uint64_t elapsedUS = (nowUS - m_LastUS);
+  m_LastUS = nowUS;
+
+  // cap elapsed time before multiplying so a long idle period cannot overflow
+  uint64_t maxUS = (m_Capacity / m_Rate + 1);
+  if (elapsedUS > maxUS)
+    elapsedUS = maxUS;
+
+  m_Tokens += (elapsedUS * m_Rate);
+  if (m_Tokens > m_Capacity)
+    m_Tokens = m_Capacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OutputQueue::OutputQueue()
+  : m_Head(0)
+  , m_Limit(4096)
+  , m_Policy(EosOutputOptions::QUEUE_DROP_OLDEST)
+  , m_PushesSinceCoalesce(0)
+  , m_HighWater(0)
+  , m_Dropped(0)
+  , m_Coalesced(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputQueue::Reset(size_t limit, EosOutputOptions::EnumQueuePolicy policy)
+{
+  m_Packets.clear();
+  m_Head = 0;
+  m_Limit = qMax(limit, static_cast<size_t>(1));
+  m_Policy = policy;
+  m_PushesSinceCoalesce = m_Limit;
+  m_Slots.clear();
+  m_HighWater = 0;
+  m_Dropped = 0;
+  m_Coalesced = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputQueue::Push(const EosPacket &packet)
+{
+  if (!MakeRoom())
+    return false;
+
+  m_Packets.push_back(packet);
+  m_HighWater = qMax(m_HighWater, size());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputQueue::Push(EosPacket &&packet)
+{
+  if (!MakeRoom())
+    return false;
+
+  m_Packets.push_back(std::move(packet));
+  m_HighWater = qMax(m_HighWater, size());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputQueue::Take(EosPacket::Q &packets)
+{
+  if (m_Head != 0)
+  {
+    m_Packets.erase(m_Packets.begin(), m_Packets.begin() + static_cast<std::ptrdiff_t>(m_Head));
+    m_Head = 0;
+  }
+
+  if (packets.empty())
+  {
+    packets.swap(m_Packets);
+  }
+  else
+  {
+    for (EosPacket::Q::iterator i = m_Packets.begin(); i != m_Packets.end(); i++)
+      packets.push_back(std::move(*i));
+  }
+
+  m_Packets.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputQueue::MakeRoom()
+{
+  // returns false if the new packet should be dropped
+  ++m_PushesSinceCoalesce;
+
+  if (size() < m_Limit)
+    return true;
+
+  switch (m_Policy)
+  {
+    case EosOutputOptions::QUEUE_DROP_NEWEST:
+      ++m_Dropped;
+      return false;
+
+    case EosOutputOptions::QUEUE_COALESCE:
+      // a full pass is O(n), so only repeat it once a quarter of the queue has turned over
+      if (m_PushesSinceCoalesce >= qMax(m_Limit / 4, static_cast<size_t>(1)))
+      {
+        m_PushesSinceCoalesce = 0;
+        Coalesce();
+        if (size() < m_Limit)
+          return true;
+      }
+      break;
+
+    default: break;
+  }
+
+  DropOldest();
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputQueue::Coalesce()
+{
+  size_t count = size();
+  size_t slotCount = 16;
+  while (slotCount < (count * 2))
+    slotCount *= 2;
+  m_Slots.assign(slotCount, 0);
+
+  // walk newest to oldest, older messages to an address already seen are superseded
+  size_t mask = (slotCount - 1);
+  size_t dropped = 0;
+  for (size_t i = m_Packets.size(); i-- > m_Head;)
+  {
+    const char *key = 0;
+    size_t keyLen = 0;
+    if (!GetKey(m_Packets[i], key, keyLen))
+      continue;
+
+    size_t slot = (OSCAddressTable::Hash(key, keyLen) & mask);
+    for (;; slot = ((slot + 1) & mask))
+    {
+      uint32_t index = m_Slots[slot];
+      if (index == 0)
+      {
+        m_Slots[slot] = static_cast<uint32_t>(i + 1);
+        break;
+      }
+
+      const char *otherKey = 0;
+      size_t otherKeyLen = 0;
+      if (GetKey(m_Packets[index - 1], otherKey, otherKeyLen) && otherKeyLen == keyLen && memcmp(otherKey, key, keyLen) == 0)
+      {
+        m_Packets[i] = EosPacket();
+        ++dropped;
+        break;
+      }
+    }
+  }
+
+  if (dropped == 0)
+    return;
+
+  // compact, keeping order
+  size_t dst = 0;
+  for (size_t i = m_Head; i < m_Packets.size(); ++i)
+  {
+    if (m_Packets[i].GetSize() != 0)
+      m_Packets[dst++] = std::move(m_Packets[i]);
+  }
+  m_Packets.resize(dst);
+  m_Head = 0;
+  m_Coalesced += dropped;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputQueue::DropOldest()
+{
+  m_Packets[m_Head++] = EosPacket();
+  ++m_Dropped;
+
+  // reclaim the front once it is at least half the vector
+  if (m_Head >= 64 && (m_Head * 2) >= m_Packets.size())
+  {
+    m_Packets.erase(m_Packets.begin(), m_Packets.begin() + static_cast<std::ptrdiff_t>(m_Head));
+    m_Head = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputQueue::GetKey(const EosPacket &packet, const char *&key, size_t &keyLen) const
+{
+  // the osc address, without its null terminator
+  if (packet.GetSize() <= 0)
+    return false;
+
+  key = packet.GetDataConst();
+  if (key[0] != '/')
+    return false;
+
+  const char *end = static_cast<const char *>(memchr(key, 0, static_cast<size_t>(packet.GetSize())));
+  if (!end)
+    return false;
+
+  keyLen = static_cast<size_t>(end - key);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+OutputFrameBatch::OutputFrameBatch(OSCStream::EnumFrameMode frameMode)
+  : m_FrameMode(frameMode)
+  , m_Size(0)
+  , m_Frames(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputFrameBatch::Add(const char *data, size_t size)
+{
+  size_t maxFrameSize = OSCBufferWriter::GetMaxFrameSize(m_FrameMode, size);
+  if (maxFrameSize == 0)
+    return false;
+
+  // the buffer only grows, so a steady stream of batches does not touch the heap
+  if ((m_Size + maxFrameSize) > m_Buf.size())
+    m_Buf.resize(qMax(m_Buf.size() * 2, m_Size + maxFrameSize));
+
+  size_t frameSize = OSCBufferWriter::WriteFrame(m_FrameMode, data, size, &m_Buf[m_Size], m_Buf.size() - m_Size);
+  if (frameSize == 0)
+    return false;
+
+  m_Size += frameSize;
+  ++m_Frames;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputFrameBatch::clear()
+{
+  m_Size = 0;
+  m_Frames = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,251 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef OUTPUT_STAGES_H
+#define OUTPUT_STAGES_H
+
+#ifndef NETWORK_UTILS_H
+#include "NetworkUtils.h"
+#endif
+
+#ifndef OSC_UTILS_H
+#include "OSCUtils.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// packs osc messages queued for one destination into bundles that fill the destination MTU
+// non-osc packets and messages too large to bundle are passed through in order
+class OutputBundler
+{
+public:
+  OutputBundler(const EosOutputOptions &options);
+
+  virtual void Bundle(EosPacket::Q &packets, EosPacket::Q &datagrams);
+
+private:
+  EosOutputOptions m_Options;
+  EosPacket m_Bundle;
+
+  virtual void Flush(OSCBundleWriter &writer, EosPacket::Q &datagrams);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// keeps only the newest message per osc address (and optionally its first few arguments)
+// messages are released in the order their key was first seen, non-osc packets keep their place
+class OutputCoalescer
+{
+public:
+  OutputCoalescer(unsigned int keyArgs);
+
+  bool empty() const { return m_Entries.empty(); }
+  size_t size() const { return m_Entries.size(); }
+  virtual bool Add(EosPacket &packet);
+  virtual void Flush(EosPacket::Q &packets);
+
+private:
+  struct sEntry
+  {
+    EosPacket packet;
+    uint32_t hash = 0;
+    uint32_t slot = 0;
+    uint32_t pathLen = 0;
+    uint32_t tagsOffset = 0;
+    uint32_t tagsLen = 0;
+    uint32_t argsOffset = 0;
+    uint32_t argsLen = 0;
+    bool keyed = false;
+  };
+
+  typedef std::vector<sEntry> ENTRIES;
+  typedef std::vector<uint32_t> SLOTS;
+
+  unsigned int m_KeyArgs;
+  ENTRIES m_Entries;
+  SLOTS m_Slots;  // entry index + 1, 0 if empty
+
+  bool MakeKey(sEntry &entry) const;
+  bool KeysEqual(const sEntry &a, const sEntry &b) const;
+  void Rehash(size_t slotCount);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// remembers the arguments last sent to each destination and osc address, and drops byte-identical repeats
+// unchanged messages are let through again once keepAliveMS has passed, 0 never resends them
+class ChangeFilter
+{
+public:
+  ChangeFilter(unsigned int keepAliveMS, size_t maxEntries = sm_Default_Max_Entries);
+
+  virtual bool Pass(unsigned int ip, unsigned short port, const char *buf, size_t size, const OSCPacketInfo &info, int64_t nowMS);
+  size_t size() const { return m_Entries.size(); }
+  unsigned long long GetSuppressed() const { return m_Suppressed; }
+  unsigned long long GetSuppressedBytes() const { return m_SuppressedBytes; }
+
+  static const size_t sm_Default_Max_Entries;
+
+private:
+  struct sEntry
+  {
+    uint64_t dst = 0;
+    uint32_t hash = 0;
+    uint32_t pathLen = 0;
+    std::vector<char> data;  // osc address followed by type tags and arguments
+    int64_t sentMS = 0;
+  };
+
+  typedef std::vector<sEntry> ENTRIES;
+  typedef std::vector<uint32_t> SLOTS;
+
+  unsigned int m_KeepAliveMS;
+  size_t m_MaxEntries;
+  ENTRIES m_Entries;
+  SLOTS m_Slots;  // entry index + 1, 0 if empty
+  unsigned long long m_Suppressed = 0;
+  unsigned long long m_SuppressedBytes = 0;
+
+  void Rehash(size_t slotCount);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// remembers the newest osc message sent to each destination and address, so a peer that (re)connects can be
+// brought up to date at once instead of waiting for every value to change again
+class StateStore
+{
+public:
+  StateStore(size_t maxEntries = sm_Default_Max_Entries);
+
+  size_t size() const { return m_Entries.size(); }
+  virtual void Update(uint64_t dst, const char *buf, size_t size, const OSCPacketInfo &info);
+
+  // the destination's messages packed into bundles of up to mtu bytes, in the order their address was first seen
+  virtual size_t Snapshot(uint64_t dst, size_t mtu, EosPacket::Q &packets) const;
+
+  static const size_t sm_Default_Max_Entries;
+
+private:
+  struct sEntry
+  {
+    uint64_t dst = 0;
+    uint32_t hash = 0;
+    uint32_t pathLen = 0;
+    std::vector<char> data;  // the whole message
+  };
+
+  typedef std::vector<sEntry> ENTRIES;
+  typedef std::vector<uint32_t> SLOTS;
+
+  size_t m_MaxEntries;
+  ENTRIES m_Entries;
+  SLOTS m_Slots;  // entry index + 1, 0 if empty
+
+  void Rehash(size_t slotCount);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// token bucket limiting output to rate packets per second, in bursts of up to burst packets
+// times are in microseconds on any monotonic clock
+class OutputPacer
+{
+public:
+  OutputPacer(unsigned int rate, unsigned int burst, uint64_t nowUS = 0);
+
+  bool enabled() const { return (m_Rate != 0); }
+  virtual bool Take(uint64_t nowUS);
+  virtual uint64_t GetNextUS(uint64_t nowUS) const;
+
+private:
+  uint64_t m_Rate;
+  uint64_t m_Capacity;
+  uint64_t m_Tokens;  // millionths of a packet
+  uint64_t m_LastUS;
+
+  void Refill(uint64_t nowUS);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// bounded queue of packets waiting for an output thread, callers provide locking
+// when full, QUEUE_DROP_NEWEST rejects the new packet and QUEUE_DROP_OLDEST discards the oldest queued one
+// QUEUE_COALESCE first drops queued osc messages superseded by a newer one to the same address, then the oldest
+class OutputQueue
+{
+public:
+  OutputQueue();
+
+  bool empty() const { return (m_Head == m_Packets.size()); }
+  size_t size() const { return (m_Packets.size() - m_Head); }
+  virtual void Reset(size_t limit, EosOutputOptions::EnumQueuePolicy policy);
+  virtual bool Push(const EosPacket &packet);
+  virtual bool Push(EosPacket &&packet);
+  virtual void Take(EosPacket::Q &packets);
+  size_t GetHighWater() const { return m_HighWater; }
+  unsigned long long GetDropped() const { return m_Dropped; }
+  unsigned long long GetCoalesced() const { return m_Coalesced; }
+
+private:
+  typedef std::vector<uint32_t> SLOTS;
+
+  EosPacket::Q m_Packets;
+  size_t m_Head;  // packets before this index have been dropped
+  size_t m_Limit;
+  EosOutputOptions::EnumQueuePolicy m_Policy;
+  size_t m_PushesSinceCoalesce;
+  SLOTS m_Slots;  // scratch for Coalesce, packet index + 1, 0 if empty
+  size_t m_HighWater;
+  unsigned long long m_Dropped;
+  unsigned long long m_Coalesced;
+
+  virtual bool MakeRoom();
+  virtual void Coalesce();
+  virtual void DropOldest();
+  bool GetKey(const EosPacket &packet, const char *&key, size_t &keyLen) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// frames packets for a tcp stream in place into one buffer, so a whole batch leaves in a single write
+class OutputFrameBatch
+{
+public:
+  OutputFrameBatch(OSCStream::EnumFrameMode frameMode);
+
+  bool empty() const { return (m_Size == 0); }
+  size_t size() const { return m_Size; }
+  size_t GetFrames() const { return m_Frames; }
+  const char *GetData() const { return (m_Buf.empty() ? nullptr : &m_Buf[0]); }
+  virtual bool Add(const char *data, size_t size);
+  virtual void clear();
+
+private:
+  OSCStream::EnumFrameMode m_FrameMode;
+  std::vector<char> m_Buf;  // m_Size bytes in use
+  size_t m_Size;
+  size_t m_Frames;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,507 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PSNUtils.h"
+#include "SimdUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+// must be last include
+#include "LeakWatcher.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t PSNTracker::sm_Max_OSC_Size = 256;
+const unsigned int PSNFrameAggregator::sm_Default_Rate_Hz = 60;
+const uint64_t PSNFrameAggregator::sm_Info_Interval_US = 1000000;
+const uint64_t PSNFrameAggregator::sm_Tracker_Timeout_US = 2000000;
+const uint64_t PSNFrameAggregator::sm_Max_Prediction_US = 250000;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNTracker::SetFloat3(EnumField field, float x, float y, float z)
+{
+  if (field < FIELD_FLOAT3_COUNT)
+  {
+    float3[field][0] = x;
+    float3[field][1] = y;
+    float3[field][2] = z;
+    fields |= FieldBit(field);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNTracker::SetStatus(float value)
+{
+  status = value;
+  fields |= FieldBit(FIELD_STATUS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNTracker::SetTimestamp(uint64_t value)
+{
+  timestamp = value;
+  fields |= FieldBit(FIELD_TIMESTAMP);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNTracker::Merge(const PSNTracker &other, uint32_t fieldMask)
+{
+  fieldMask &= other.fields;
+  for (int i = 0; i < FIELD_FLOAT3_COUNT; ++i)
+  {
+    if ((fieldMask & FieldBit(static_cast<EnumField>(i))) != 0)
+      memcpy(float3[i], other.float3[i], sizeof(float3[i]));
+  }
+
+  if ((fieldMask & FieldBit(FIELD_STATUS)) != 0)
+    status = other.status;
+  if ((fieldMask & FieldBit(FIELD_TIMESTAMP)) != 0)
+    timestamp = other.timestamp;
+
+  fields |= static_cast<uint16_t>(fieldMask);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t PSNTracker::MakePath(uint32_t fieldMask, char *buf, size_t capacity) const
+{
+  int len = snprintf(buf, capacity, "/psn/%u", static_cast<unsigned int>(id));
+  if (len <= 0 || static_cast<size_t>(len) >= capacity)
+    return 0;
+
+  size_t pathLen = static_cast<size_t>(len);
+  for (int i = 0; i < FIELD_COUNT; ++i)
+  {
+    if ((fieldMask & FieldBit(static_cast<EnumField>(i))) == 0)
+      continue;
+
+    const char *name = GetFieldName(static_cast<EnumField>(i));
+    size_t nameLen = strlen(name);
+    if (pathLen + 1 + nameLen >= capacity)
+      return 0;
+
+    buf[pathLen++] = '/';
+    memcpy(&buf[pathLen], name, nameLen);
+    pathLen += nameLen;
+  }
+
+  buf[pathLen] = 0;
+  return pathLen;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PSNTracker::MakeOSC(uint32_t fieldMask, char *buf, size_t capacity, size_t &size) const
+{
+  fieldMask &= fields;
+
+  char path[128];
+  size_t pathLen = MakePath(fieldMask, path, sizeof(path));
+  if (pathLen == 0)
+    return false;
+
+  float values[FIELD_FLOAT3_COUNT * 3 + 1];
+  size_t valueCount = 0;
+  for (int i = 0; i < FIELD_FLOAT3_COUNT; ++i)
+  {
+    if ((fieldMask & FieldBit(static_cast<EnumField>(i))) != 0)
+    {
+      memcpy(&values[valueCount], float3[i], sizeof(float3[i]));
+      valueCount += 3;
+    }
+  }
+
+  if ((fieldMask & FieldBit(FIELD_STATUS)) != 0)
+    values[valueCount++] = status;
+
+  bool hasTimestamp = ((fieldMask & FieldBit(FIELD_TIMESTAMP)) != 0);
+
+  OSCBufferWriter osc(buf, capacity);
+  if (!osc.Begin(path, pathLen, valueCount + (hasTimestamp ? 1 : 0)))
+    return false;
+
+  if (valueCount != 0 && !osc.AddFloat32Array(values, valueCount))
+    return false;
+
+  if (hasTimestamp && !osc.AddUInt64(timestamp))
+    return false;
+
+  return osc.End(size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PSNTracker::FromOSC(const char *buf, size_t size, const OSCPacketInfo &info, PSNTracker &tracker)
+{
+  if (!buf || info.kind != OSCPacketInfo::KIND_MESSAGE || info.pathLen < 2)
+    return false;
+
+  OSCAddressTable::SEGMENTS segments;
+  OSCAddressTable::Split(buf, info.pathLen, segments);
+  if (segments.size() < 2 || segments[0].size != 3 || memcmp(&buf[segments[0].offset], "psn", 3) != 0)
+    return false;
+
+  // an id that is not a number is tracker 0
+  tracker = PSNTracker();
+  unsigned int id = 0;
+  for (uint32_t i = 0; i < segments[1].size; ++i)
+  {
+    char c = buf[segments[1].offset + i];
+    if (c < '0' || c > '9' || id > 0xffff)
+    {
+      id = 0;
+      break;
+    }
+    id = (id * 10 + static_cast<unsigned int>(c - '0'));
+  }
+  tracker.id = static_cast<uint16_t>((id <= 0xffff) ? id : 0);
+
+  OSCArgsView args(buf, size, info);
+  OSCArgView arg;
+  size_t argIndex = 0;
+  for (size_t segment = 2; segment < segments.size(); ++segment)
+  {
+    const char *name = &buf[segments[segment].offset];
+    size_t nameLen = segments[segment].size;
+    for (int i = 0; i < FIELD_COUNT; ++i)
+    {
+      EnumField field = static_cast<EnumField>(i);
+      const char *fieldName = GetFieldName(field);
+      if (strlen(fieldName) != nameLen || memcmp(fieldName, name, nameLen) != 0)
+        continue;
+
+      if (field < FIELD_FLOAT3_COUNT)
+      {
+        float values[3];
+        if (args.GetFloats(argIndex, values, 3))
+          tracker.SetFloat3(field, values[0], values[1], values[2]);
+        argIndex += 3;
+      }
+      else if (field == FIELD_STATUS)
+      {
+        float f = 0;
+        if (args.GetArg(argIndex, arg) && arg.GetFloat(f))
+          tracker.SetStatus(f);
+        ++argIndex;
+      }
+      else
+      {
+        uint64_t u = 0;
+        if (args.GetArg(argIndex, arg) && arg.GetUInt64(u))
+          tracker.SetTimestamp(u);
+        ++argIndex;
+      }
+      break;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char *PSNTracker::GetFieldName(EnumField field)
+{
+  switch (field)
+  {
+    case FIELD_POS: return "pos";
+    case FIELD_SPEED: return "speed";
+    case FIELD_ORIENTATION: return "orientation";
+    case FIELD_ACCELERATION: return "acceleration";
+    case FIELD_TARGET: return "target";
+    case FIELD_STATUS: return "status";
+    case FIELD_TIMESTAMP: return "timestamp";
+    default: break;
+  }
+
+  return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PSNFrameAggregator::PSNFrameAggregator(unsigned int rateHz, bool predict)
+  : m_IntervalUS((rateHz == 0) ? 0 : (1000000 / rateHz))
+  , m_Predict(predict)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNFrameAggregator::Update(const PSNTracker &tracker, uint32_t fieldMask, uint64_t nowUS)
+{
+  if ((fieldMask & tracker.fields) == 0)
+    return;
+
+  // the first tracker after a quiet spell goes out right away, the rate is kept from then on
+  if (m_Entries.empty())
+  {
+    m_NextDataUS = nowUS;
+    m_NextInfoUS = nowUS;
+  }
+
+  sEntry &entry = m_Entries[tracker.id];
+  bool hasPos = ((fieldMask & tracker.fields & PSNTracker::FieldBit(PSNTracker::FIELD_POS)) != 0);
+
+  // every real position resyncs the prediction, after scoring how close it came
+  if (m_Predict && hasPos && entry.tracker.IsSet(PSNTracker::FIELD_POS))
+  {
+    const PSNTracker &last = entry.tracker;
+    float dt = GetPredictionSeconds(entry.posUS, nowUS);
+    float distance = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+      float speed = (last.IsSet(PSNTracker::FIELD_SPEED) ? last.float3[PSNTracker::FIELD_SPEED][i] : 0);
+      float accel = (last.IsSet(PSNTracker::FIELD_ACCELERATION) ? last.float3[PSNTracker::FIELD_ACCELERATION][i] : 0);
+      float predicted = 0;
+      SimdUtils::Extrapolate_Scalar(&last.float3[PSNTracker::FIELD_POS][i], &speed, &accel, &dt, &predicted, 1);
+      float d = (predicted - tracker.float3[PSNTracker::FIELD_POS][i]);
+      distance += (d * d);
+    }
+
+    sPredictionStats &stats = entry.prediction;
+    stats.last = std::sqrt(distance);
+    stats.max = std::max(stats.max, stats.last);
+    stats.sum += stats.last;
+    ++stats.count;
+  }
+
+  entry.tracker.id = tracker.id;
+  entry.tracker.Merge(tracker, fieldMask);
+  entry.updatedUS = nowUS;
+  if (hasPos)
+    entry.posUS = nowUS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int PSNFrameAggregator::Poll(uint64_t nowUS, TRACKERS &trackers)
+{
+  trackers.clear();
+
+  if (m_IntervalUS == 0 || m_Entries.empty())
+    return DUE_NONE;
+
+  int due = DUE_NONE;
+
+  if (nowUS >= m_NextDataUS)
+  {
+    // intervals missed while the router was busy are skipped, not sent back to back
+    m_NextDataUS += m_IntervalUS;
+    if (m_NextDataUS <= nowUS)
+      m_NextDataUS = (nowUS + m_IntervalUS);
+    due |= DUE_DATA;
+  }
+
+  if (nowUS >= m_NextInfoUS)
+  {
+    m_NextInfoUS = (nowUS + sm_Info_Interval_US);
+    due |= DUE_INFO;
+  }
+
+  if (due == DUE_NONE)
+    return DUE_NONE;
+
+  trackers.reserve(m_Entries.size());
+  for (ENTRIES::iterator i = m_Entries.begin(); i != m_Entries.end();)
+  {
+    if (nowUS - i->second.updatedUS > sm_Tracker_Timeout_US)
+      m_Entries.erase(i++);
+    else
+    {
+      trackers.push_back(i->second.tracker);
+      i++;
+    }
+  }
+
+  if (m_Predict && (due & DUE_DATA) != 0 && !trackers.empty())
+    Predict(nowUS, trackers);
+
+  return (trackers.empty() ? DUE_NONE : due);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNFrameAggregator::Predict(uint64_t nowUS, TRACKERS &trackers)
+{
+  // trackers is in the same order as m_Entries, so pos times line up without lookups
+  m_PredictIndex.clear();
+  m_PredictDT.clear();
+  ENTRIES::const_iterator entryIter = m_Entries.begin();
+  for (size_t i = 0; i < trackers.size(); ++i, ++entryIter)
+  {
+    const PSNTracker &tracker = trackers[i];
+    if (tracker.IsSet(PSNTracker::FIELD_POS) && (tracker.IsSet(PSNTracker::FIELD_SPEED) || tracker.IsSet(PSNTracker::FIELD_ACCELERATION)))
+    {
+      m_PredictIndex.push_back(i);
+      m_PredictDT.push_back(GetPredictionSeconds(entryIter->second.posUS, nowUS));
+    }
+  }
+
+  size_t count = m_PredictIndex.size();
+  if (count == 0)
+    return;
+
+  // laid out axis by axis, pos then speed then accel, so each axis of every tracker is extrapolated in one vectorized pass
+  m_PredictBuf.resize(count * 9);
+  for (size_t j = 0; j < count; ++j)
+  {
+    const PSNTracker &tracker = trackers[m_PredictIndex[j]];
+    bool hasSpeed = tracker.IsSet(PSNTracker::FIELD_SPEED);
+    bool hasAccel = tracker.IsSet(PSNTracker::FIELD_ACCELERATION);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      float *pos = &m_PredictBuf[axis * 3 * count];
+      pos[j] = tracker.float3[PSNTracker::FIELD_POS][axis];
+      pos[count + j] = (hasSpeed ? tracker.float3[PSNTracker::FIELD_SPEED][axis] : 0);
+      pos[count * 2 + j] = (hasAccel ? tracker.float3[PSNTracker::FIELD_ACCELERATION][axis] : 0);
+    }
+  }
+
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    float *pos = &m_PredictBuf[axis * 3 * count];
+    SimdUtils::Extrapolate(pos, pos + count, pos + count * 2, m_PredictDT.data(), pos, count);
+  }
+
+  for (size_t j = 0; j < count; ++j)
+  {
+    float *pos = trackers[m_PredictIndex[j]].float3[PSNTracker::FIELD_POS];
+    for (int axis = 0; axis < 3; ++axis)
+      pos[axis] = m_PredictBuf[axis * 3 * count + j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+float PSNFrameAggregator::GetPredictionSeconds(uint64_t fromUS, uint64_t nowUS)
+{
+  // a tracker that stops updating is held where the prediction got to, not sent off into the distance
+  uint64_t us = ((nowUS > fromUS) ? std::min(nowUS - fromUS, sm_Max_Prediction_US) : 0);
+  return (static_cast<float>(us) * 0.000001f);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNFrameAggregator::GetPredictionStats(PREDICTION_STATS &stats) const
+{
+  stats.clear();
+  for (ENTRIES::const_iterator i = m_Entries.begin(); i != m_Entries.end(); i++)
+  {
+    if (i->second.prediction.count != 0)
+      stats[i->first] = i->second.prediction;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PSNFrameAggregator::GetNextDue(uint64_t &dueUS) const
+{
+  if (m_IntervalUS == 0 || m_Entries.empty())
+    return false;
+
+  dueUS = std::min(m_NextDataUS, m_NextInfoUS);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PSNTransform::PSNTransform(const float *matrix)
+{
+  memcpy(m_Matrix, matrix, sizeof(m_Matrix));
+
+  // orientation is an axis * angle rotation vector, so scale and translation must not reach it
+  // each column of the 3x3 is normalized, and a mirroring matrix flips the rotation vector as well
+  float det = (m_Matrix[0] * (m_Matrix[5] * m_Matrix[10] - m_Matrix[6] * m_Matrix[9]) - m_Matrix[1] * (m_Matrix[4] * m_Matrix[10] - m_Matrix[6] * m_Matrix[8]) +
+               m_Matrix[2] * (m_Matrix[4] * m_Matrix[9] - m_Matrix[5] * m_Matrix[8]));
+  float sign = ((det < 0) ? -1.0f : 1.0f);
+  memset(m_Rotation, 0, sizeof(m_Rotation));
+  for (int col = 0; col < 3; ++col)
+  {
+    float length = std::sqrt(m_Matrix[col] * m_Matrix[col] + m_Matrix[4 + col] * m_Matrix[4 + col] + m_Matrix[8 + col] * m_Matrix[8 + col]);
+    if (length == 0)
+      continue;
+
+    for (int row = 0; row < 3; ++row)
+      m_Rotation[row * 4 + col] = (sign * m_Matrix[row * 4 + col] / length);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PSNTransform::Apply(PSNTracker *trackers, size_t count)
+{
+  size_t capacity = (count * PSNTracker::FIELD_FLOAT3_COUNT);
+  if (m_Buf.size() < (capacity * 4))
+    m_Buf.resize(capacity * 4);
+
+  float *x = m_Buf.data();
+  float *y = (x + capacity);
+  float *z = (y + capacity);
+  float *w = (z + capacity);
+
+  // gathered axis by axis in tracker then field order, and scattered back in the same order
+  // orientations go to the back of the arrays, they are rotated by m_Rotation instead
+  size_t n = 0;
+  size_t rotated = capacity;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const PSNTracker &tracker = trackers[i];
+    for (int field = 0; field < PSNTracker::FIELD_FLOAT3_COUNT; ++field)
+    {
+      if (!tracker.IsSet(static_cast<PSNTracker::EnumField>(field)))
+        continue;
+
+      size_t index = ((field == PSNTracker::FIELD_ORIENTATION) ? --rotated : n++);
+      x[index] = tracker.float3[field][0];
+      y[index] = tracker.float3[field][1];
+      z[index] = tracker.float3[field][2];
+      w[index] = ((field == PSNTracker::FIELD_POS || field == PSNTracker::FIELD_TARGET) ? 1.0f : 0.0f);
+    }
+  }
+
+  if (n != 0)
+    SimdUtils::TransformAffine(m_Matrix, x, y, z, w, n);
+  if (rotated != capacity)
+    SimdUtils::TransformAffine(m_Rotation, x + rotated, y + rotated, z + rotated, w + rotated, capacity - rotated);
+
+  n = 0;
+  rotated = capacity;
+  for (size_t i = 0; i < count; ++i)
+  {
+    PSNTracker &tracker = trackers[i];
+    for (int field = 0; field < PSNTracker::FIELD_FLOAT3_COUNT; ++field)
+    {
+      if (!tracker.IsSet(static_cast<PSNTracker::EnumField>(field)))
+        continue;
+
+      size_t index = ((field == PSNTracker::FIELD_ORIENTATION) ? --rotated : n++);
+      tracker.float3[field][0] = x[index];
+      tracker.float3[field][1] = y[index];
+      tracker.float3[field][2] = z[index];
+    }
+  }
+}
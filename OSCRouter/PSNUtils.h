@@ -0,0 +1,169 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef PSN_UTILS_H
+#define PSN_UTILS_H
+
+#ifndef OSC_UTILS_H
+#include "OSCUtils.h"
+#endif
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// one decoded psn tracker, routed as is and only written as osc for destinations that want osc
+// its osc address is "/psn/<id>/<field>..." with the values of each field as arguments, in field order
+struct PSNTracker
+{
+  enum EnumField
+  {
+    FIELD_POS = 0,
+    FIELD_SPEED,
+    FIELD_ORIENTATION,
+    FIELD_ACCELERATION,
+    FIELD_TARGET,
+    FIELD_STATUS,
+    FIELD_TIMESTAMP,
+
+    FIELD_COUNT,
+    FIELD_FLOAT3_COUNT = FIELD_STATUS  // fields before status are float3
+  };
+
+  bool IsSet(EnumField field) const { return ((fields & FieldBit(field)) != 0); }
+  void SetFloat3(EnumField field, float x, float y, float z);
+  void SetStatus(float value);
+  void SetTimestamp(uint64_t value);
+  void Merge(const PSNTracker &other, uint32_t fieldMask);
+
+  size_t MakePath(uint32_t fieldMask, char *buf, size_t capacity) const;
+  bool MakeOSC(uint32_t fieldMask, char *buf, size_t capacity, size_t &size) const;
+
+  // reads "/psn/<id>/<field>..." messages, unknown fields are skipped
+  static bool FromOSC(const char *buf, size_t size, const OSCPacketInfo &info, PSNTracker &tracker);
+
+  static uint32_t FieldBit(EnumField field) { return (1u << field); }
+  static const char *GetFieldName(EnumField field);
+
+  static const size_t sm_Max_OSC_Size;
+
+  uint16_t id = 0;
+  uint16_t fields = 0;  // FieldBit of each field set
+  float float3[FIELD_FLOAT3_COUNT][3] = {};
+  float status = 0;
+  uint64_t timestamp = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// gathers the trackers routed to one psn destination, so they leave together as whole frames at a fixed rate
+// trackers keep their newest value of each field until they have not been updated for sm_Tracker_Timeout_US
+// with predict set, positions sent between real updates are extrapolated from the last pos, speed and acceleration
+class PSNFrameAggregator
+{
+public:
+  enum EnumDue
+  {
+    DUE_NONE = 0,
+    DUE_DATA = 0x1,
+    DUE_INFO = 0x2
+  };
+
+  // how far predicted positions were from the real ones that followed, in psn units (meters)
+  struct sPredictionStats
+  {
+    uint64_t count = 0;
+    float last = 0;
+    float max = 0;
+    double sum = 0;
+
+    float mean() const { return ((count == 0) ? 0 : static_cast<float>(sum / count)); }
+  };
+
+  typedef std::vector<PSNTracker> TRACKERS;
+  typedef std::map<uint16_t, sPredictionStats> PREDICTION_STATS;
+
+  PSNFrameAggregator(unsigned int rateHz = sm_Default_Rate_Hz, bool predict = false);
+  virtual ~PSNFrameAggregator() {}
+
+  virtual void Update(const PSNTracker &tracker, uint32_t fieldMask, uint64_t nowUS);
+
+  // returns EnumDue bits, trackers holds everything to send when anything is due
+  virtual int Poll(uint64_t nowUS, TRACKERS &trackers);
+
+  virtual bool GetNextDue(uint64_t &dueUS) const;
+  virtual void GetPredictionStats(PREDICTION_STATS &stats) const;
+  bool empty() const { return m_Entries.empty(); }
+
+  static const unsigned int sm_Default_Rate_Hz;
+  static const uint64_t sm_Info_Interval_US;
+  static const uint64_t sm_Tracker_Timeout_US;
+  static const uint64_t sm_Max_Prediction_US;
+
+private:
+  struct sEntry
+  {
+    PSNTracker tracker;
+    uint64_t updatedUS = 0;
+    uint64_t posUS = 0;  // when pos was last set, predictions start from there
+    sPredictionStats prediction;
+  };
+
+  typedef std::map<uint16_t, sEntry> ENTRIES;
+
+  ENTRIES m_Entries;
+  uint64_t m_IntervalUS = 0;
+  uint64_t m_NextDataUS = 0;
+  uint64_t m_NextInfoUS = 0;
+  bool m_Predict = false;
+  std::vector<size_t> m_PredictIndex;  // trackers being extrapolated this frame
+  std::vector<float> m_PredictDT;
+  std::vector<float> m_PredictBuf;
+
+  virtual void Predict(uint64_t nowUS, TRACKERS &trackers);
+  static float GetPredictionSeconds(uint64_t fromUS, uint64_t nowUS);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a route's affine transform of psn float3 fields, every field of every tracker given is mapped in one vectorized pass
+// pos and target are points, speed, orientation and acceleration are directions and skip the translation
+class PSNTransform
+{
+public:
+  static const size_t sm_Matrix_Size = 12;  // row major 3x4, the last row of the 4x4 matrix is always 0 0 0 1
+
+  PSNTransform(const float *matrix);
+  virtual ~PSNTransform() {}
+
+  virtual void Apply(PSNTracker *trackers, size_t count);
+
+private:
+  float m_Matrix[sm_Matrix_Size];
+  float m_Rotation[sm_Matrix_Size];  // rotation part of m_Matrix, for orientation
+  std::vector<float> m_Buf;  // x, y, z and translation weight arrays of every float3 value
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
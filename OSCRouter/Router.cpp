@@ -22,6 +22,8 @@
 #include "EosTimer.h"
 #include "EosUdp.h"
 #include "EosTcp.h"
+#include "OutputStages.h"
+#include "TimerWheel.h"
 #include <psn_lib.hpp>
 
 #ifdef WIN32
@@ -33,6 +35,8 @@
 #include <arpa/inet.h>
 #endif
 
+#include <cstring>
+#include <functional>
 #include <sstream>
 #include <iomanip>
 
@@ -93,6 +97,54 @@ void PacketLogger::PrintPacket(OSCParser &oscParser, const char *packet, size_t
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void PacketLogger::PrintPSNTracker(const PSNTracker &tracker)
+{
+  // "PSN /psn/<id> pos(x, y, z) ... status(s) timestamp(t)"
+  std::stringstream ss;
+  ss << "PSN /psn/" << tracker.id;
+  for (int i = 0; i < PSNTracker::FIELD_FLOAT3_COUNT; ++i)
+  {
+    PSNTracker::EnumField field = static_cast<PSNTracker::EnumField>(i);
+    if (tracker.IsSet(field))
+      ss << ' ' << PSNTracker::GetFieldName(field) << '(' << tracker.float3[i][0] << ", " << tracker.float3[i][1] << ", " << tracker.float3[i][2] << ')';
+  }
+
+  if (tracker.IsSet(PSNTracker::FIELD_STATUS))
+    ss << " status(" << tracker.status << ')';
+
+  if (tracker.IsSet(PSNTracker::FIELD_TIMESTAMP))
+    ss << " timestamp(" << tracker.timestamp << ')';
+
+  OSCParserClient_Log(ss.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadWake::Wake()
+{
+  m_Mutex.lock();
+  m_Wake = true;
+  m_Condition.wakeOne();
+  m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadWake::Wait(uint64_t timeoutUS)
+{
+  m_Mutex.lock();
+  if (!m_Wake)
+    m_Condition.wait(&m_Mutex, QDeadlineTimer(std::chrono::microseconds(timeoutUS), Qt::PreciseTimer));
+  m_Wake = false;
+  m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t EosUdpInThread::sm_Max_PSN_Sources = 64;
+
+////////////////////////////////////////////////////////////////////////////////
+
 EosUdpInThread::EosUdpInThread()
   : m_Run(false)
   , m_Mutex()
@@ -134,13 +186,15 @@ void EosUdpInThread::Stop()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosUdpInThread::Flush(EosLog::LOG_Q &logQ, RECV_Q &recvQ)
+void EosUdpInThread::Flush(EosLog::LOG_Q &logQ, RECV_Q &recvQ, TRACKER_Q &trackerQ)
 {
   recvQ.clear();
+  trackerQ.clear();
 
   m_Mutex.lock();
   m_Log.Flush(logQ);
   m_Q.swap(recvQ);
+  m_TrackerQ.swap(trackerQ);
   m_Mutex.unlock();
 }
 
@@ -166,7 +220,7 @@ void EosUdpInThread::SetState(ItemState::EnumState state)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosUdpInThread::RecvPacket(const QHostAddress &host, const char *data, int len, OSCParser &logParser, PacketLogger &packetLogger)
+void EosUdpInThread::RecvPacket(const QHostAddress &host, unsigned short port, const char *data, int len, OSCParser &logParser, PacketLogger &packetLogger)
 {
   if (m_Protocol != Protocol::kPSN)
   {
@@ -174,178 +228,183 @@ void EosUdpInThread::RecvPacket(const QHostAddress &host, const char *data, int
     return;
   }
 
-  if (!m_PSNDecoder->decode(data, static_cast<size_t>(len)))
-    return;  // could not decode psn packet
+  // nothing is decoded if no route wants anything from this input
+  if ((m_PSNForms & (EosOutputOptions::PSN_FORM_FIELDS | EosOutputOptions::PSN_FORM_COMBINED)) == 0 || m_PSNFields == 0)
+    return;
+
+  unsigned int ip = static_cast<unsigned int>(host.toIPv4Address());
+  sPSNSource *source = GetPSNSource(ip, port);
+  if (!source)
+    return;
+
+  // the decoder hands over each frame it completes, a packet that closes a frame early can complete two
+  m_DecodedTrackers.clear();
+  source->decoder->decode(data, static_cast<size_t>(len));
+
+  if (m_PSNStatsTimer.hasExpired(10000))
+  {
+    LogPSNStats();
+    m_PSNStatsTimer.restart();
+  }
+
+  // a frame closed early is still routed when the packet that closed it could not be decoded
+  if (m_DecodedTrackers.empty())
+    return;
+
+  SetLogPrefix(host, ip, packetLogger);
+  for (TRACKER_Q::const_iterator i = m_DecodedTrackers.begin(); i != m_DecodedTrackers.end(); i++)
+    packetLogger.PrintPSNTracker(i->tracker);
 
-  if (m_PSNFrame.has_value() && m_PSNFrame.value() == m_PSNDecoder->get_data().header.frame_id)
-    return;  // already recevied this psn frame
+  m_Mutex.lock();
+  m_TrackerQ.insert(m_TrackerQ.end(), m_DecodedTrackers.begin(), m_DecodedTrackers.end());
+  m_Mutex.unlock();
+}
 
-  m_PSNFrame = m_PSNDecoder->get_data().header.frame_id;
+////////////////////////////////////////////////////////////////////////////////
 
-  const psn::tracker_map &trackers = m_PSNDecoder->get_data().trackers;
-  for (psn::tracker_map::const_iterator trackerIter = trackers.begin(); trackerIter != trackers.end(); ++trackerIter)
+void EosUdpInThread::DecodePSNFrame(unsigned int ip, const psn::psn_decoder &decoder)
+{
+  // duplicate packets and frames are dropped by the decoder, only newly completed frames get here
+  // trackers go to the router as they are, osc is only written for destinations that need it
+  // fields no route asks for are left out here
+  ++m_PSNFrameCount;
+  const psn::tracker_store &trackers = decoder.get_tracker_store();
+  for (psn::tracker_store::const_iterator trackerIter = trackers.begin(); trackerIter != trackers.end(); ++trackerIter)
   {
-    const psn::tracker &tracker = trackerIter->second;
-    std::string path = "/psn/" + std::to_string(tracker.get_id());
+    uint16_t id = *trackerIter;
+    uint32_t fields = trackers.get_fields(id);
 
-    std::string completePath = path;
-    OSCPacketWriter completeOSC;
+    PSNTracker decoded;
+    decoded.id = id;
 
-    if (tracker.is_pos_set())
-    {
-      OSCPacketWriter osc(path + "/pos");
-      completePath += "/pos";
-      osc.AddFloat32(tracker.get_pos().x);
-      osc.AddFloat32(tracker.get_pos().y);
-      osc.AddFloat32(tracker.get_pos().z);
-      completeOSC.AddFloat32(tracker.get_pos().x);
-      completeOSC.AddFloat32(tracker.get_pos().y);
-      completeOSC.AddFloat32(tracker.get_pos().z);
-      size_t size = 0;
-      char *packet = osc.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
-    }
+    if ((fields & (1 << psn::DATA_TRACKER_POS)) != 0 && (m_PSNFields & PSNTracker::FieldBit(PSNTracker::FIELD_POS)) != 0)
+      decoded.SetFloat3(PSNTracker::FIELD_POS, trackers.get_pos(id).x, trackers.get_pos(id).y, trackers.get_pos(id).z);
 
-    if (tracker.is_speed_set())
-    {
-      OSCPacketWriter osc(path + "/speed");
-      completePath += "/speed";
-      osc.AddFloat32(tracker.get_speed().x);
-      osc.AddFloat32(tracker.get_speed().y);
-      osc.AddFloat32(tracker.get_speed().z);
-      completeOSC.AddFloat32(tracker.get_speed().x);
-      completeOSC.AddFloat32(tracker.get_speed().y);
-      completeOSC.AddFloat32(tracker.get_speed().z);
-      size_t size = 0;
-      char *packet = osc.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
-    }
+    if ((fields & (1 << psn::DATA_TRACKER_SPEED)) != 0 && (m_PSNFields & PSNTracker::FieldBit(PSNTracker::FIELD_SPEED)) != 0)
+      decoded.SetFloat3(PSNTracker::FIELD_SPEED, trackers.get_speed(id).x, trackers.get_speed(id).y, trackers.get_speed(id).z);
 
-    if (tracker.is_ori_set())
-    {
-      OSCPacketWriter osc(path + "/orientation");
-      completePath += "/orientation";
-      osc.AddFloat32(tracker.get_ori().x);
-      osc.AddFloat32(tracker.get_ori().y);
-      osc.AddFloat32(tracker.get_ori().z);
-      completeOSC.AddFloat32(tracker.get_ori().x);
-      completeOSC.AddFloat32(tracker.get_ori().y);
-      completeOSC.AddFloat32(tracker.get_ori().z);
-      size_t size = 0;
-      char *packet = osc.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
-    }
+    if ((fields & (1 << psn::DATA_TRACKER_ORI)) != 0 && (m_PSNFields & PSNTracker::FieldBit(PSNTracker::FIELD_ORIENTATION)) != 0)
+      decoded.SetFloat3(PSNTracker::FIELD_ORIENTATION, trackers.get_ori(id).x, trackers.get_ori(id).y, trackers.get_ori(id).z);
 
-    if (tracker.is_accel_set())
-    {
-      OSCPacketWriter osc(path + "/acceleration");
-      completePath += "/acceleration";
-      osc.AddFloat32(tracker.get_accel().x);
-      osc.AddFloat32(tracker.get_accel().y);
-      osc.AddFloat32(tracker.get_accel().z);
-      completeOSC.AddFloat32(tracker.get_accel().x);
-      completeOSC.AddFloat32(tracker.get_accel().y);
-      completeOSC.AddFloat32(tracker.get_accel().z);
-      size_t size = 0;
-      char *packet = osc.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
-    }
+    if ((fields & (1 << psn::DATA_TRACKER_ACCEL)) != 0 && (m_PSNFields & PSNTracker::FieldBit(PSNTracker::FIELD_ACCELERATION)) != 0)
+      decoded.SetFloat3(PSNTracker::FIELD_ACCELERATION, trackers.get_accel(id).x, trackers.get_accel(id).y, trackers.get_accel(id).z);
 
-    if (tracker.is_target_pos_set())
-    {
-      OSCPacketWriter osc(path + "/target");
-      completePath += "/target";
-      osc.AddFloat32(tracker.get_target_pos().x);
-      osc.AddFloat32(tracker.get_target_pos().y);
-      osc.AddFloat32(tracker.get_target_pos().z);
-      completeOSC.AddFloat32(tracker.get_target_pos().x);
-      completeOSC.AddFloat32(tracker.get_target_pos().y);
-      completeOSC.AddFloat32(tracker.get_target_pos().z);
-      size_t size = 0;
-      char *packet = osc.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
-    }
+    if ((fields & (1 << psn::DATA_TRACKER_TRGTPOS)) != 0 && (m_PSNFields & PSNTracker::FieldBit(PSNTracker::FIELD_TARGET)) != 0)
+      decoded.SetFloat3(PSNTracker::FIELD_TARGET, trackers.get_target_pos(id).x, trackers.get_target_pos(id).y, trackers.get_target_pos(id).z);
 
-    if (tracker.is_status_set())
+    if ((fields & (1 << psn::DATA_TRACKER_STATUS)) != 0 && (m_PSNFields & PSNTracker::FieldBit(PSNTracker::FIELD_STATUS)) != 0)
+      decoded.SetStatus(trackers.get_status(id));
+
+    if ((fields & (1 << psn::DATA_TRACKER_TIMESTAMP)) != 0 && (m_PSNFields & PSNTracker::FieldBit(PSNTracker::FIELD_TIMESTAMP)) != 0)
+      decoded.SetTimestamp(trackers.get_timestamp(id));
+
+    if (decoded.fields == 0)
+      continue;
+
+    m_DecodedTrackers.emplace_back();
+    sRecvTracker &recvTracker = m_DecodedTrackers.back();
+    recvTracker.tracker = decoded;
+    recvTracker.ip = ip;
+    recvTracker.frame = m_PSNFrameCount;
+    recvTracker.forms = static_cast<uint16_t>(m_PSNForms);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+EosUdpInThread::sPSNSource *EosUdpInThread::GetPSNSource(unsigned int ip, unsigned short port)
+{
+  uint64_t key = ((static_cast<uint64_t>(ip) << 16) | port);
+  PSN_SOURCES::iterator i = m_PSNSources.find(key);
+  if (i != m_PSNSources.end())
+    return (i->second.decoder ? &(i->second) : nullptr);
+
+  QString ipString;
+  EosAddr::UIntToIP(ip, ipString);
+
+  if (m_PSNSources.size() >= sm_Max_PSN_Sources)
+  {
+    if (m_PSNSources.size() == sm_Max_PSN_Sources)
     {
-      OSCPacketWriter osc(path + "/status");
-      completePath += "/status";
-      osc.AddFloat32(tracker.get_status());
-      completeOSC.AddFloat32(tracker.get_status());
-      size_t size = 0;
-      char *packet = osc.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
+      // logged once, an entry without a decoder marks the input as full until it restarts
+      QString msg = QString("udp input %1:%2 ignoring psn from %3:%4, already receiving from %5 servers").arg(m_Addr.ip).arg(m_Addr.port).arg(ipString).arg(port).arg(sm_Max_PSN_Sources);
+      m_PrivateLog.AddWarning(msg.toUtf8().constData());
+      m_PSNSources[key];
     }
+    return nullptr;
+  }
+
+  QString msg = QString("udp input %1:%2 receiving psn from %3:%4").arg(m_Addr.ip).arg(m_Addr.port).arg(ipString).arg(port);
+  m_PrivateLog.AddInfo(msg.toUtf8().constData());
+
+  sPSNSource &source = m_PSNSources[key];
+  source.decoder = new psn::psn_decoder(psn::psn_decoder::MODE_TRACKER_STORE);
+  source.decoder->set_frame_handler(std::bind(&EosUdpInThread::DecodePSNFrame, this, ip, std::placeholders::_1));
+  return &source;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosUdpInThread::LogPSNStats()
+{
+  for (PSN_SOURCES::iterator i = m_PSNSources.begin(); i != m_PSNSources.end(); i++)
+  {
+    sPSNSource &source = i->second;
+    if (!source.decoder)
+      continue;
 
-    if (tracker.is_status_set())
+    QString ipString;
+    EosAddr::UIntToIP(static_cast<unsigned int>(i->first >> 16), ipString);
+    unsigned short port = static_cast<unsigned short>(i->first & 0xffff);
+
+    QString systemName = QString::fromStdString(source.decoder->get_info().system_name);
+    if (systemName != source.systemName)
     {
-      OSCPacketWriter osc(path + "/timestamp");
-      completePath += "/timestamp";
-      osc.AddUInt64(tracker.get_timestamp());
-      completeOSC.AddUInt64(tracker.get_timestamp());
-      size_t size = 0;
-      char *packet = osc.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
+      source.systemName = systemName;
+      QString msg = QString("udp input %1:%2 psn from %3:%4 is \"%5\"").arg(m_Addr.ip).arg(m_Addr.port).arg(ipString).arg(port).arg(systemName);
+      m_PrivateLog.AddInfo(msg.toUtf8().constData());
     }
 
-    if (!completeOSC.empty())
+    const psn::psn_decoder::stats_t &stats = source.decoder->get_stats();
+    uint64_t duplicates = (stats.duplicate_frames + stats.duplicate_packets);
+    if (stats.incomplete_frames != source.loggedIncomplete || duplicates != source.loggedDuplicates)
     {
-      completeOSC.SetPath(completePath);
-      size_t size = 0;
-      char *packet = completeOSC.Create(size);
-      if (packet)
-      {
-        if (size > 0)
-          QueuePacket(host, packet, static_cast<int>(size), logParser, packetLogger);
-        delete[] packet;
-      }
+      QString msg = QString("udp input %1:%2 psn from %3:%4").arg(m_Addr.ip).arg(m_Addr.port).arg(ipString).arg(port);
+      msg += QString(": %1 frames, %2 incomplete, %3 duplicate, %4 duplicate packets").arg(stats.data_frames).arg(stats.incomplete_frames).arg(stats.duplicate_frames).arg(stats.duplicate_packets);
+      m_PrivateLog.AddWarning(msg.toUtf8().constData());
+      source.loggedIncomplete = stats.incomplete_frames;
+      source.loggedDuplicates = duplicates;
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void EosUdpInThread::ClearPSNSources()
+{
+  for (PSN_SOURCES::const_iterator i = m_PSNSources.begin(); i != m_PSNSources.end(); i++)
+    delete i->second.decoder;
+  m_PSNSources.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosUdpInThread::SetLogPrefix(const QHostAddress &host, unsigned int ip, PacketLogger &packetLogger)
+{
+  if (!m_LogPrefixIp.has_value() || m_LogPrefixIp.value() != ip)
+  {
+    packetLogger.SetPrefix(QString("UDP IN  [%1:%2] ").arg(host.toString()).arg(m_Addr.port).toUtf8().constData());
+    m_LogPrefixIp = ip;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void EosUdpInThread::QueuePacket(const QHostAddress &host, const char *data, int len, OSCParser &logParser, PacketLogger &packetLogger)
 {
-  std::string logPrefix = QString("UDP IN  [%1:%2] ").arg(host.toString()).arg(m_Addr.port).toUtf8().constData();
-  packetLogger.SetPrefix(logPrefix);
-  packetLogger.PrintPacket(logParser, data, static_cast<size_t>(len));
   unsigned int ip = static_cast<unsigned int>(host.toIPv4Address());
+  SetLogPrefix(host, ip, packetLogger);
+  packetLogger.PrintPacket(logParser, data, static_cast<size_t>(len));
   m_Mutex.lock();
   m_Q.push_back(sRecvPacket(data, len, ip));
   m_Mutex.unlock();
@@ -359,8 +418,8 @@ void EosUdpInThread::run()
   m_PrivateLog.AddInfo(msg.toUtf8().constData());
   UpdateLog();
 
-  m_PSNDecoder = new psn::psn_decoder();
-  m_PSNFrame.reset();
+  ClearPSNSources();
+  m_PSNStatsTimer.start();
 
   EosTimer reconnectTimer;
 
@@ -377,7 +436,7 @@ void EosUdpInThread::run()
       OSCParser logParser;
       logParser.SetRoot(new OSCMethod());
       PacketLogger packetLogger(EosLog::LOG_MSG_TYPE_RECV, m_PrivateLog);
-      std::string logPrefix;
+      m_LogPrefixIp.reset();
       sockaddr_in addr;
 
       // run
@@ -386,12 +445,19 @@ void EosUdpInThread::run()
         int len = 0;
         int addrSize = static_cast<int>(sizeof(addr));
         const char *data = udpIn->RecvPacket(m_PrivateLog, 100, 0, len, &addr, &addrSize);
-        if (data && len > 0)
-          RecvPacket(QHostAddress(reinterpret_cast<const sockaddr *>(&addr)), data, len, logParser, packetLogger);
+        bool received = (data && len > 0);
+        if (received)
+        {
+          RecvPacket(QHostAddress(reinterpret_cast<const sockaddr *>(&addr)), ntohs(addr.sin_port), data, len, logParser, packetLogger);
+          if (m_RouterWake)
+            m_RouterWake->Wake();
+        }
 
         UpdateLog();
 
-        msleep(1);
+        // keep reading while datagrams are waiting
+        if (!received)
+          msleep(1);
       }
     }
 
@@ -411,7 +477,8 @@ void EosUdpInThread::run()
       msleep(10);
   }
 
-  delete m_PSNDecoder;
+  LogPSNStats();
+  ClearPSNSources();
 
   msg = QString("udp input %1:%2 thread ended").arg(m_Addr.ip).arg(m_Addr.port);
   m_PrivateLog.AddInfo(msg.toUtf8().constData());
@@ -431,6 +498,10 @@ void EosUdpInThread::UpdateLog()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+const uint64_t EosUdpOutThread::sm_Max_Wait_US = 50000;
+
+////////////////////////////////////////////////////////////////////////////////
+
 EosUdpOutThread::EosUdpOutThread()
   : m_Run(false)
   , m_ItemStateTableId(ItemStateTable::sm_Invalid_Id)
@@ -449,12 +520,16 @@ EosUdpOutThread::~EosUdpOutThread()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosUdpOutThread::Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, unsigned int reconnectDelayMS)
+void EosUdpOutThread::Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, const EosOutputOptions &options, unsigned int reconnectDelayMS)
 {
   Stop();
 
   m_Addr = addr;
   m_ItemStateTableId = itemStateTableId;
+  m_Options = options;
+  m_OutputStats = ItemState::sOutputStats();
+  for (int i = 0; i < EosOutputOptions::PRIORITY_COUNT; ++i)
+    m_Q[i].Reset(options.queueLimit, options.queuePolicy);
   m_ReconnectDelay = reconnectDelayMS;
   m_Run = true;
   m_QEnabled = true;  // q commands while on-demand thread is first starting
@@ -466,18 +541,19 @@ void EosUdpOutThread::Start(const EosAddr &addr, ItemStateTable::ID itemStateTab
 void EosUdpOutThread::Stop()
 {
   m_Run = false;
+  m_Wake.Wake();
   wait();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool EosUdpOutThread::Send(const EosPacket &packet)
+bool EosUdpOutThread::Send(const EosPacket &packet, EosOutputOptions::EnumPriority priority /*= EosOutputOptions::PRIORITY_NORMAL*/)
 {
   m_Mutex.lock();
-  if (m_QEnabled)
+  if (m_QEnabled && m_Q[priority].Push(packet))
   {
-    m_Q.push_back(packet);
     m_Mutex.unlock();
+    m_Wake.Wake();
     return true;
   }
   m_Mutex.unlock();
@@ -506,6 +582,21 @@ ItemState::EnumState EosUdpOutThread::GetState()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void EosUdpOutThread::GetOutputStats(ItemState::sOutputStats &stats)
+{
+  m_Mutex.lock();
+  stats = m_OutputStats;
+  for (int i = 0; i < EosOutputOptions::PRIORITY_COUNT; ++i)
+  {
+    stats.coalesced += m_Q[i].GetCoalesced();
+    stats.dropped += m_Q[i].GetDropped();
+    stats.queueHighWater = qMax(stats.queueHighWater, static_cast<unsigned long long>(m_Q[i].GetHighWater()));
+  }
+  m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void EosUdpOutThread::SetState(ItemState::EnumState state)
 {
   m_Mutex.lock();
@@ -548,25 +639,163 @@ void EosUdpOutThread::run()
       packetLogger.SetPrefix(QString("UDP OUT [%1:%2] ").arg(m_Addr.ip).arg(m_Addr.port).toUtf8().constData());
 
       // run
+      EosPacket::Q urgent;
       EosPacket::Q q;
+      EosPacket::Q pending;
+      EosPacket::Q datagrams;
+      size_t datagramsSent = 0;     // datagrams before this index have been sent
+      size_t datagramsDelayed = 0;  // datagrams before this index have been counted as delayed
+      OutputCoalescer coalescer(m_Options.coalesceKeyArgs);
+      OutputBundler bundler(m_Options);
+      OutputPacer pacer(m_Options.rateLimit, m_Options.rateBurst);
+      uint64_t coalesceIntervalUS = (static_cast<uint64_t>(m_Options.coalesceIntervalMS) * 1000);
+      uint64_t bundleWindowUS = (static_cast<uint64_t>(m_Options.bundleWindowMS) * 1000);
+      uint64_t coalesceStartUS = 0;
+      uint64_t bundleWindowStartUS = 0;
+      bool pacingTimer = false;
+      TimerWheel timers;
+      TimerWheel::TIMERS expiredTimers;
+      QElapsedTimer clock;
+      clock.start();
       while (m_Run)
       {
+        uint64_t nowUS = static_cast<uint64_t>(clock.nsecsElapsed() / 1000);
+
+        expiredTimers.clear();
+        timers.Advance(nowUS, expiredTimers);
+        for (TimerWheel::TIMERS::const_iterator i = expiredTimers.begin(); i != expiredTimers.end(); i++)
+        {
+          if (i->data == TIMER_PACING)
+            pacingTimer = false;
+        }
+
+        // the top lane is always taken, lower lanes in order once earlier datagrams are out
+        // while rate limited, new packets wait in their bounded queue
         m_Mutex.lock();
-        m_Q.swap(q);
+        m_Q[EosOutputOptions::PRIORITY_HIGH].Take(urgent);
+        if (datagramsSent == datagrams.size())
+        {
+          for (int i = EosOutputOptions::PRIORITY_HIGH + 1; i < EosOutputOptions::PRIORITY_COUNT; ++i)
+            m_Q[i].Take(q);
+        }
         m_Mutex.unlock();
 
-        for (EosPacket::Q::iterator i = q.begin(); m_Run && i != q.end(); i++)
+        ItemState::sOutputStats stats;
+        stats.packets = (urgent.size() + q.size());
+
+        // top priority goes straight out, ahead of anything coalescing, bundling or rate limited
+        for (EosPacket::Q::iterator i = urgent.begin(); m_Run && i != urgent.end(); i++)
         {
+          pacer.Take(nowUS);
           const char *buf = i->GetData();
           int len = i->GetSize();
           if (udpOut->SendPacket(m_PrivateLog, buf, len))
+          {
+            ++stats.datagrams;
+            packetLogger.PrintPacket(logParser, buf, static_cast<size_t>(len));
+          }
+        }
+        urgent.clear();
+
+        if (m_Options.coalesce)
+        {
+          if (!q.empty() && coalescer.empty())
+          {
+            coalesceStartUS = nowUS;
+            timers.Add(nowUS + coalesceIntervalUS, TIMER_COALESCE);
+          }
+
+          for (EosPacket::Q::iterator i = q.begin(); i != q.end(); i++)
+          {
+            if (coalescer.Add(*i))
+              ++stats.coalesced;
+          }
+          q.clear();
+
+          if (!coalescer.empty() && (nowUS - coalesceStartUS) >= coalesceIntervalUS)
+            coalescer.Flush(q);
+        }
+
+        if (!q.empty())
+        {
+          if (pending.empty())
+          {
+            pending.swap(q);
+            bundleWindowStartUS = nowUS;
+            if (m_Options.bundle && bundleWindowUS != 0)
+              timers.Add(nowUS + bundleWindowUS, TIMER_BUNDLE_WINDOW);
+          }
+          else
+          {
+            for (EosPacket::Q::iterator i = q.begin(); i != q.end(); i++)
+              pending.push_back(std::move(*i));
+            q.clear();
+          }
+        }
+
+        // when bundling with a window, hold packets until the oldest has waited long enough
+        if (!pending.empty() && (!m_Options.bundle || bundleWindowUS == 0 || (nowUS - bundleWindowStartUS) >= bundleWindowUS))
+          bundler.Bundle(pending, datagrams);
+
+        for (; m_Run && datagramsSent < datagrams.size() && pacer.Take(nowUS); ++datagramsSent)
+        {
+          EosPacket &datagram = datagrams[datagramsSent];
+          const char *buf = datagram.GetData();
+          int len = datagram.GetSize();
+          if (udpOut->SendPacket(m_PrivateLog, buf, len))
+          {
+            ++stats.datagrams;
             packetLogger.PrintPacket(logParser, buf, static_cast<size_t>(len));
+          }
+        }
+
+        if (datagramsSent < datagrams.size())
+        {
+          // rate limited, wake when the next datagram may be sent
+          if (datagramsDelayed < datagramsSent)
+            datagramsDelayed = datagramsSent;
+          stats.delayed += (datagrams.size() - datagramsDelayed);
+          datagramsDelayed = datagrams.size();
+
+          if (!pacingTimer)
+          {
+            timers.Add(pacer.GetNextUS(nowUS), TIMER_PACING);
+            pacingTimer = true;
+          }
+
+          if (datagramsSent >= 1024 && datagramsSent * 2 >= datagrams.size())
+          {
+            datagrams.erase(datagrams.begin(), datagrams.begin() + static_cast<std::ptrdiff_t>(datagramsSent));
+            datagramsDelayed -= datagramsSent;
+            datagramsSent = 0;
+          }
+        }
+        else
+        {
+          datagrams.clear();
+          datagramsSent = datagramsDelayed = 0;
+        }
+
+        if (stats != ItemState::sOutputStats())
+        {
+          m_Mutex.lock();
+          m_OutputStats.add(stats);
+          m_Mutex.unlock();
         }
-        q.clear();
 
         UpdateLog();
 
-        msleep(1);
+        // sleep until a timer is due or more packets are queued
+        uint64_t waitUS = sm_Max_Wait_US;
+        uint64_t dueUS = 0;
+        if (timers.GetNextDue(dueUS))
+        {
+          nowUS = static_cast<uint64_t>(clock.nsecsElapsed() / 1000);
+          waitUS = ((dueUS > nowUS) ? qMin(dueUS - nowUS, sm_Max_Wait_US) : 0);
+        }
+
+        if (waitUS != 0)
+          m_Wake.Wait(waitUS);
       }
     }
 
@@ -604,6 +833,10 @@ void EosUdpOutThread::UpdateLog()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+const size_t EosTcpClientThread::sm_Max_Batch_Size = 65536;
+
+////////////////////////////////////////////////////////////////////////////////
+
 EosTcpClientThread::EosTcpClientThread()
   : m_AcceptedTcp(0)
   , m_Run(false)
@@ -611,6 +844,8 @@ EosTcpClientThread::EosTcpClientThread()
   , m_FrameMode(OSCStream::FRAME_MODE_INVALID)
   , m_State(ItemState::STATE_UNINITIALIZED)
   , m_ReconnectDelay(0)
+  , m_Urgent(false)
+  , m_Connected(false)
 {
 }
 
@@ -623,14 +858,15 @@ EosTcpClientThread::~EosTcpClientThread()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosTcpClientThread::Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, unsigned int reconnectDelayMS)
+void EosTcpClientThread::Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options, unsigned int reconnectDelayMS)
 {
-  Start(0, addr, itemStateTableId, frameMode, reconnectDelayMS);
+  Start(0, addr, itemStateTableId, frameMode, options, reconnectDelayMS);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosTcpClientThread::Start(EosTcp *tcp, const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, unsigned int reconnectDelayMS)
+void EosTcpClientThread::Start(EosTcp *tcp, const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options,
+                               unsigned int reconnectDelayMS)
 {
   Stop();
 
@@ -638,6 +874,11 @@ void EosTcpClientThread::Start(EosTcp *tcp, const EosAddr &addr, ItemStateTable:
   m_Addr = addr;
   m_ItemStateTableId = itemStateTableId;
   m_FrameMode = frameMode;
+  m_Options = options;
+  m_OutputStats = ItemState::sOutputStats();
+  for (int i = 0; i < EosOutputOptions::PRIORITY_COUNT; ++i)
+    m_SendQ[i].Reset(options.queueLimit, options.queuePolicy);
+  m_Connected = false;
   m_ReconnectDelay = reconnectDelayMS;
   m_Run = true;
   start();
@@ -659,12 +900,11 @@ void EosTcpClientThread::Stop()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool EosTcpClientThread::Send(const EosPacket &packet)
+bool EosTcpClientThread::Send(const EosPacket &packet, EosOutputOptions::EnumPriority priority /*= EosOutputOptions::PRIORITY_NORMAL*/)
 {
   m_Mutex.lock();
-  if (GetState() == ItemState::STATE_CONNECTED)
+  if (GetState() == ItemState::STATE_CONNECTED && m_SendQ[priority].Push(packet))
   {
-    m_SendQ.push_back(packet);
     m_Mutex.unlock();
     return true;
   }
@@ -674,27 +914,6 @@ bool EosTcpClientThread::Send(const EosPacket &packet)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool EosTcpClientThread::SendFramed(const EosPacket &packet)
-{
-  m_Mutex.lock();
-  if (GetState() == ItemState::STATE_CONNECTED)
-  {
-    size_t frameSize = packet.GetSize();
-    char *frame = OSCStream::CreateFrame(m_FrameMode, packet.GetDataConst(), frameSize);
-    if (frame)
-    {
-      m_SendQ.push_back(EosPacket(frame, static_cast<int>(frameSize)));
-      m_Mutex.unlock();
-      delete[] frame;
-      return true;
-    }
-  }
-  m_Mutex.unlock();
-  return false;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
 void EosTcpClientThread::Flush(EosLog::LOG_Q &logQ, EosUdpInThread::RECV_Q &recvQ)
 {
   recvQ.clear();
@@ -718,9 +937,38 @@ ItemState::EnumState EosTcpClientThread::GetState()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool EosTcpClientThread::TakeConnected()
+{
+  bool connected;
+  m_Mutex.lock();
+  connected = m_Connected;
+  m_Connected = false;
+  m_Mutex.unlock();
+  return connected;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosTcpClientThread::GetOutputStats(ItemState::sOutputStats &stats)
+{
+  m_Mutex.lock();
+  stats = m_OutputStats;
+  for (int i = 0; i < EosOutputOptions::PRIORITY_COUNT; ++i)
+  {
+    stats.coalesced += m_SendQ[i].GetCoalesced();
+    stats.dropped += m_SendQ[i].GetDropped();
+    stats.queueHighWater = qMax(stats.queueHighWater, static_cast<unsigned long long>(m_SendQ[i].GetHighWater()));
+  }
+  m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void EosTcpClientThread::SetState(ItemState::EnumState state)
 {
   m_Mutex.lock();
+  if (state == ItemState::STATE_CONNECTED && m_State != ItemState::STATE_CONNECTED)
+    m_Connected = true;
   m_State = state;
   m_Mutex.unlock();
 }
@@ -765,71 +1013,150 @@ void EosTcpClientThread::run()
       UpdateLog();
 
       // send/recv while connected
+      EosPacket::Q urgentQ;
       EosPacket::Q sendQ;
+      size_t sendQSent = 0;     // packets before this index have been sent
+      size_t sendQDelayed = 0;  // packets before this index have been counted as delayed
       unsigned int ip = m_Addr.toUInt();
-      OSCStream recvStream(m_FrameMode);
-      OSCStream sendStream(m_FrameMode);
+      OSCStreamFramer recvFramer(m_FrameMode);
+      OutputFrameBatch sendBatch(m_FrameMode);
+      uint64_t corkUS = (m_Options.tcpCork ? (static_cast<uint64_t>(m_Options.tcpCorkMS) * 1000) : 0);
+      uint64_t corkStartUS = 0;
+      bool corkTimer = false;
+      OutputPacer pacer(m_Options.rateLimit, m_Options.rateBurst);
+      bool pacingTimer = false;
+      TimerWheel timers;
+      TimerWheel::TIMERS expiredTimers;
+      QElapsedTimer clock;
+      clock.start();
       while (m_Run && tcp->GetConnectState() == EosTcp::CONNECT_CONNECTED)
       {
+        // wait for incoming data, but not past the time corked or rate limited output may be sent
+        // Recv cannot be woken, so connections that high priority routes send to poll every millisecond
+        unsigned int recvTimeoutMS = (m_Urgent ? 1 : 100);
+        uint64_t dueUS = 0;
+        if (timers.GetNextDue(dueUS))
+        {
+          uint64_t nowUS = static_cast<uint64_t>(clock.nsecsElapsed() / 1000);
+          recvTimeoutMS = ((dueUS > nowUS) ? static_cast<unsigned int>(qMin<uint64_t>((dueUS - nowUS + 999) / 1000, recvTimeoutMS)) : 0);
+        }
+
         size_t len = 0;
-        const char *data = tcp->Recv(m_PrivateLog, 100, len);
+        const char *data = tcp->Recv(m_PrivateLog, recvTimeoutMS, len);
 
-        recvStream.Add(data, len);
+        recvFramer.Add(data, len);
 
-        while (m_Run)
+        const char *frame = nullptr;
+        size_t frameSize = 0;
+        bool received = false;
+        while (m_Run && recvFramer.GetNextFrame(frame, frameSize))
         {
-          size_t frameSize = 0;
-          char *frame = recvStream.GetNextFrame(frameSize);
-          if (frame)
-          {
-            if (frameSize != 0)
-            {
-              inPacketLogger.PrintPacket(logParser, frame, frameSize);
-              m_Mutex.lock();
-              m_RecvQ.push_back(EosUdpInThread::sRecvPacket(frame, static_cast<int>(frameSize), ip));
-              m_Mutex.unlock();
-            }
-
-            delete[] frame;
-          }
-          else
-            break;
+          inPacketLogger.PrintPacket(logParser, frame, frameSize);
+          m_Mutex.lock();
+          m_RecvQ.push_back(EosUdpInThread::sRecvPacket(frame, static_cast<int>(frameSize), ip));
+          m_Mutex.unlock();
+          received = true;
         }
 
-        msleep(1);
+        if (received && m_RouterWake)
+          m_RouterWake->Wake();
+
+        // the top lane is always taken, lower lanes in order once earlier packets are out
+        // while rate limited, new packets wait in their bounded queue
+        if (sendQSent == sendQ.size())
+        {
+          sendQ.clear();
+          sendQSent = sendQDelayed = 0;
+        }
 
         m_Mutex.lock();
-        m_SendQ.swap(sendQ);
+        m_SendQ[EosOutputOptions::PRIORITY_HIGH].Take(urgentQ);
+        if (sendQ.empty())
+        {
+          for (int i = EosOutputOptions::PRIORITY_HIGH + 1; i < EosOutputOptions::PRIORITY_COUNT; ++i)
+            m_SendQ[i].Take(sendQ);
+        }
         m_Mutex.unlock();
 
-        for (EosPacket::Q::iterator i = sendQ.begin(); m_Run && i != sendQ.end(); i++)
+        uint64_t nowUS = static_cast<uint64_t>(clock.nsecsElapsed() / 1000);
+        expiredTimers.clear();
+        timers.Advance(nowUS, expiredTimers);
+        for (TimerWheel::TIMERS::const_iterator i = expiredTimers.begin(); i != expiredTimers.end(); i++)
         {
-          data = i->GetData();
-          len = static_cast<size_t>(i->GetSize());
-          if (tcp->Send(m_PrivateLog, data, len))
+          if (i->data == TIMER_PACING)
+            pacingTimer = false;
+          else if (i->data == TIMER_CORK)
+            corkTimer = false;
+        }
+
+        // frames are written in place into one buffer that leaves in a single write
+        if (sendBatch.empty())
+          corkStartUS = nowUS;
+
+        // top priority goes straight out, ahead of anything corked or rate limited
+        bool flush = !urgentQ.empty();
+        for (EosPacket::Q::const_iterator i = urgentQ.begin(); m_Run && i != urgentQ.end(); i++)
+        {
+          pacer.Take(nowUS);
+          outPacketLogger.PrintPacket(logParser, i->GetDataConst(), static_cast<size_t>(qMax(0, i->GetSize())));
+          sendBatch.Add(i->GetDataConst(), static_cast<size_t>(qMax(0, i->GetSize())));
+          if (sendBatch.size() >= sm_Max_Batch_Size)
+            SendBatch(*tcp, sendBatch);
+        }
+        urgentQ.clear();
+
+        for (; m_Run && sendQSent < sendQ.size() && pacer.Take(nowUS); ++sendQSent)
+        {
+          const EosPacket &packet = sendQ[sendQSent];
+          outPacketLogger.PrintPacket(logParser, packet.GetDataConst(), static_cast<size_t>(qMax(0, packet.GetSize())));
+          sendBatch.Add(packet.GetDataConst(), static_cast<size_t>(qMax(0, packet.GetSize())));
+          if (sendBatch.size() >= sm_Max_Batch_Size)
+            SendBatch(*tcp, sendBatch);
+        }
+
+        if (m_Run && !sendBatch.empty())
+        {
+          if (flush || corkUS == 0 || nowUS >= (corkStartUS + corkUS))
+            SendBatch(*tcp, sendBatch);
+          else if (!corkTimer)
           {
-            sendStream.Reset();
-            sendStream.Add(data, len);
-            for (;;)
-            {
-              size_t frameSize = 0;
-              char *frame = recvStream.GetNextFrame(frameSize);
-              if (frame)
-              {
-                if (frameSize != 0)
-                  outPacketLogger.PrintPacket(logParser, frame, frameSize);
-                delete[] frame;
-              }
-              else
-                break;
-            }
+            // corked, hold frames until the window closes or the batch fills
+            timers.Add(corkStartUS + corkUS, TIMER_CORK);
+            corkTimer = true;
           }
         }
-        sendQ.clear();
 
-        UpdateLog();
+        if (sendQSent < sendQ.size())
+        {
+          // rate limited, wake when the next packet may be sent
+          if (sendQDelayed < sendQSent)
+            sendQDelayed = sendQSent;
+
+          ItemState::sOutputStats stats;
+          stats.delayed = (sendQ.size() - sendQDelayed);
+          sendQDelayed = sendQ.size();
+          if (stats.delayed != 0)
+          {
+            m_Mutex.lock();
+            m_OutputStats.add(stats);
+            m_Mutex.unlock();
+          }
+
+          if (!pacingTimer)
+          {
+            timers.Add(pacer.GetNextUS(nowUS), TIMER_PACING);
+            pacingTimer = true;
+          }
+
+          if (sendQSent >= 1024 && sendQSent * 2 >= sendQ.size())
+          {
+            sendQ.erase(sendQ.begin(), sendQ.begin() + static_cast<std::ptrdiff_t>(sendQSent));
+            sendQDelayed -= sendQSent;
+            sendQSent = 0;
+          }
+        }
 
-        msleep(1);
+        UpdateLog();
       }
     }
 
@@ -856,12 +1183,34 @@ void EosTcpClientThread::run()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosTcpClientThread::UpdateLog()
+bool EosTcpClientThread::SendBatch(EosTcp &tcp, OutputFrameBatch &batch)
 {
-  m_Mutex.lock();
-  m_Log.AddLog(m_PrivateLog);
-  m_Mutex.unlock();
-
+  // packets were logged as they went into the batch
+  bool sent = tcp.Send(m_PrivateLog, batch.GetData(), batch.size());
+  if (!sent)
+  {
+    ItemState::sOutputStats stats;
+    stats.failed = batch.GetFrames();
+    m_Mutex.lock();
+    m_OutputStats.add(stats);
+    m_Mutex.unlock();
+
+    QString msg = QString("tcp client %1:%2 send failed, %3 packets lost").arg(m_Addr.ip).arg(m_Addr.port).arg(batch.GetFrames());
+    m_PrivateLog.AddWarning(msg.toUtf8().constData());
+  }
+
+  batch.clear();
+  return sent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosTcpClientThread::UpdateLog()
+{
+  m_Mutex.lock();
+  m_Log.AddLog(m_PrivateLog);
+  m_Mutex.unlock();
+
   m_PrivateLog.Clear();
 }
 
@@ -884,13 +1233,14 @@ EosTcpServerThread::~EosTcpServerThread()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EosTcpServerThread::Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, unsigned int reconnectDelayMS)
+void EosTcpServerThread::Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options, unsigned int reconnectDelayMS)
 {
   Stop();
 
   m_Addr = addr;
   m_ItemStateTableId = itemStateTableId;
   m_FrameMode = frameMode;
+  m_Options = options;
   m_ReconnectDelay = reconnectDelayMS;
   m_Run = true;
   start();
@@ -1024,20 +1374,7 @@ void EosTcpServerThread::UpdateLog()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool OSCBundleMethod::ProcessPacket(OSCParserClient & /*client*/, char *buf, size_t size)
-{
-  EosUdpInThread::sRecvPacket packet(buf, static_cast<int>(size), m_IP);
-  m_Q.push_back(packet);
-  return true;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void OSCBundleMethod::Flush(EosUdpInThread::RECV_Q &q)
-{
-  q.clear();
-  m_Q.swap(q);
-}
+const size_t RouterThread::sm_Max_Datagram_Size = 65507;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -1062,6 +1399,7 @@ RouterThread::~RouterThread()
 void RouterThread::Stop()
 {
   m_Run = false;
+  m_Wake.Wake();
   wait();
 }
 
@@ -1077,7 +1415,7 @@ void RouterThread::Flush(EosLog::LOG_Q &logQ, ItemStateTable &itemStateTable)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udpInThreads, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, TCP_SERVER_THREADS &tcpServerThreads)
+void RouterThread::BuildRoutes(ROUTES_BY_LANE &routesByLane, UDP_IN_THREADS &udpInThreads, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, TCP_SERVER_THREADS &tcpServerThreads)
 {
   m_PrivateLog.AddInfo("Building Routing Table...");
 
@@ -1101,6 +1439,20 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
 
   if (!nics.empty())
   {
+    // output options are per destination, the first route to a destination with destination options wins
+    m_OutputOptions.clear();
+    m_UrgentAddrs.clear();
+    for (Router::ROUTES::const_iterator i = m_Routes.begin(); i != m_Routes.end(); i++)
+    {
+      EosAddr dstAddr = i->dst.addr;
+      if (dstAddr.port == 0)
+        dstAddr.port = i->src.addr.port;
+      if (i->dst.options.hasDestinationOptions() && m_OutputOptions.find(dstAddr) == m_OutputOptions.end())
+        m_OutputOptions[dstAddr] = i->dst.options;
+      if (i->dst.options.priority == EosOutputOptions::PRIORITY_HIGH)
+        m_UrgentAddrs.insert(dstAddr);
+    }
+
     // create TCP threads
     for (Router::CONNECTIONS::const_iterator i = m_TcpConnections.begin(); i != m_TcpConnections.end(); i++)
     {
@@ -1119,13 +1471,15 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
             {
               EosTcpServerThread *thread = new EosTcpServerThread();
               tcpServerThreads[tcpAddr] = thread;
-              thread->Start(tcpAddr, tcpConnection.itemStateTableId, tcpConnection.frameMode, m_ReconnectDelay);
+              thread->Start(tcpAddr, tcpConnection.itemStateTableId, tcpConnection.frameMode, tcpConnection.options, m_ReconnectDelay);
             }
             else
             {
               EosTcpClientThread *thread = new EosTcpClientThread();
               tcpClientThreads[tcpAddr] = thread;
-              thread->Start(tcpAddr, tcpConnection.itemStateTableId, tcpConnection.frameMode, m_ReconnectDelay);
+              thread->SetRouterWake(&m_Wake);
+              thread->SetUrgent(IsUrgentAddr(tcpAddr));
+              thread->Start(tcpAddr, tcpConnection.itemStateTableId, tcpConnection.frameMode, tcpConnection.options, m_ReconnectDelay);
             }
           }
         }
@@ -1133,17 +1487,31 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
         {
           EosTcpServerThread *thread = new EosTcpServerThread();
           tcpServerThreads[tcpConnection.addr] = thread;
-          thread->Start(tcpConnection.addr, tcpConnection.itemStateTableId, tcpConnection.frameMode, m_ReconnectDelay);
+          thread->Start(tcpConnection.addr, tcpConnection.itemStateTableId, tcpConnection.frameMode, tcpConnection.options, m_ReconnectDelay);
         }
         else
         {
           EosTcpClientThread *thread = new EosTcpClientThread();
           tcpClientThreads[tcpConnection.addr] = thread;
-          thread->Start(tcpConnection.addr, tcpConnection.itemStateTableId, tcpConnection.frameMode, m_ReconnectDelay);
+          thread->SetRouterWake(&m_Wake);
+          thread->SetUrgent(IsUrgentAddr(tcpConnection.addr));
+          thread->Start(tcpConnection.addr, tcpConnection.itemStateTableId, tcpConnection.frameMode, tcpConnection.options, m_ReconnectDelay);
         }
       }
     }
 
+    // a psn input makes the fields and messages wanted by any route from its port, and nothing else
+    PSN_FAN_OUTS psnFanOuts;
+    for (Router::ROUTES::const_iterator i = m_Routes.begin(); i != m_Routes.end(); i++)
+    {
+      if (i->src.protocol == Protocol::kPSN)
+      {
+        sPSNFanOut &fanOut = psnFanOuts[i->src.addr.port];
+        fanOut.fields |= i->dst.options.psnFields;
+        fanOut.forms |= i->dst.options.psnForms;
+      }
+    }
+
     QHostAddress localHost(QHostAddress::LocalHost);
     for (Router::ROUTES::const_iterator i = m_Routes.begin(); i != m_Routes.end(); i++)
     {
@@ -1160,6 +1528,10 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
           {
             EosUdpInThread *thread = new EosUdpInThread();
             udpInThreads[inAddr] = thread;
+            thread->SetRouterWake(&m_Wake);
+            PSN_FAN_OUTS::const_iterator fanOut = psnFanOuts.find(route.src.addr.port);
+            if (fanOut != psnFanOuts.end())
+              thread->SetPSNFanOut(fanOut->second.fields, fanOut->second.forms);
             thread->Start(inAddr, route.src.multicastIP, route.src.protocol, route.srcItemStateTableId, m_ReconnectDelay);
           }
         }
@@ -1174,7 +1546,10 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
 
       // add entry to main routing table...
 
-      // sorted 1st by port
+      // split 1st into priority lanes
+      ROUTES_BY_PORT &routesByPort = routesByLane[route.dst.options.priority];
+
+      // sorted 2nd by port
       ROUTES_BY_PORT::iterator portIter = routesByPort.find(route.src.addr.port);
       if (portIter == routesByPort.end())
       {
@@ -1182,7 +1557,7 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
         portIter = routesByPort.insert(ROUTES_BY_PORT_PAIR(route.src.addr.port, empty)).first;
       }
 
-      // sorted 2nd by ip
+      // sorted 3rd by ip
       unsigned int srcIp = route.src.addr.toUInt();
       ROUTES_BY_IP &routesByIp = portIter->second;
       ROUTES_BY_IP::iterator ipIter = routesByIp.find(srcIp);
@@ -1192,7 +1567,7 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
         ipIter = routesByIp.insert(ROUTES_BY_IP_PAIR(srcIp, empty)).first;
       }
 
-      // sorted 3rd by path
+      // sorted 4th by path
       ROUTES_BY_PATH &routesByPath = (route.src.path.contains('*') ? ipIter->second.routesByWildcardPath : ipIter->second.routesByPath);
       ROUTES_BY_PATH::iterator pathIter = routesByPath.find(route.src.path);
       if (pathIter == routesByPath.end())
@@ -1207,6 +1582,20 @@ void RouterThread::BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udp
       routeDst.dst = route.dst;
       routeDst.srcItemStateTableId = route.srcItemStateTableId;
       routeDst.dstItemStateTableId = route.dstItemStateTableId;
+      if (route.dst.options.changeOnly)
+      {
+        // change-only state is per route
+        sChangeFilter changeFilter;
+        changeFilter.filter = routeDst.changeFilter = new ChangeFilter(route.dst.options.changeOnlyKeepAliveMS);
+        changeFilter.itemStateTableId = route.dstItemStateTableId;
+        m_ChangeFilters.push_back(changeFilter);
+      }
+      if (route.dst.options.hasPSNTransform())
+      {
+        // so is the last frame a psn transform mapped
+        routeDst.psnTransform = new sPSNTransform(route.dst.options.psnMatrix);
+        m_PSNTransforms.push_back(routeDst.psnTransform);
+      }
       destinations.push_back(routeDst);
     }
   }
@@ -1221,9 +1610,17 @@ EosUdpOutThread *RouterThread::CreateUdpOutThread(const EosAddr &addr, ItemState
     UDP_OUT_THREADS::iterator i = udpOutThreads.find(addr);
     if (i == udpOutThreads.end())
     {
+      // destinations without an explicit ip share the options of their route
+      EosOutputOptions options;
+      OUTPUT_OPTIONS::const_iterator j = m_OutputOptions.find(addr);
+      if (j == m_OutputOptions.end())
+        j = m_OutputOptions.find(EosAddr(QString(), addr.port));
+      if (j != m_OutputOptions.end())
+        options = j->second;
+
       EosUdpOutThread *thread = new EosUdpOutThread();
       udpOutThreads[addr] = thread;
-      thread->Start(addr, itemStateTableId, m_ReconnectDelay);
+      thread->Start(addr, itemStateTableId, options, m_ReconnectDelay);
       return thread;
     }
     else
@@ -1265,62 +1662,536 @@ void RouterThread::AddRoutingDestinations(bool isOSC, const QString &path, const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void RouterThread::ProcessRecvQ(OSCParser &oscBundleParser, ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads,
-                                TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr, EosUdpInThread::RECV_Q &recvQ)
+void RouterThread::AddRoutingDestinations(sAddress *address, const sRoutesByIp &routesByIp, DESTINATIONS_LIST &destinations)
+{
+  // route matches only depend on the address, so they are resolved once per address
+  for (ADDRESS_ROUTES::const_iterator i = address->routes.begin(); i != address->routes.end(); i++)
+  {
+    if (i->routesByIp == &routesByIp)
+    {
+      destinations.insert(destinations.end(), i->destinations.begin(), i->destinations.end());
+      return;
+    }
+  }
+
+  sAddressRoutes addressRoutes;
+  addressRoutes.routesByIp = &routesByIp;
+  AddRoutingDestinations(/*isOSC*/ true, address->path, routesByIp, addressRoutes.destinations);
+  destinations.insert(destinations.end(), addressRoutes.destinations.begin(), addressRoutes.destinations.end());
+  address->routes.push_back(addressRoutes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+RouterThread::sAddress *RouterThread::InternAddress(const char *path, size_t pathLen)
+{
+  OSCAddressTable::ID id = m_AddressTable.Intern(path, pathLen);
+  if (id == OSCAddressTable::sm_Invalid_Id)
+    return nullptr;
+
+  if (id < m_Addresses.size())
+    return &m_Addresses[id];
+
+  m_Addresses.emplace_back();
+  sAddress &address = m_Addresses.back();
+  MakeAddress(path, pathLen, address);
+  address.id = id;
+  return &address;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::MakeAddress(const char *path, size_t pathLen, sAddress &address)
+{
+  address.id = OSCAddressTable::sm_Invalid_Id;
+  address.path = QString::fromUtf8(path, static_cast<qsizetype>(pathLen));
+  address.parts.clear();
+  address.routes.clear();
+
+  OSCAddressTable::SEGMENTS segments;
+  const OSCAddressTable::sEntry *entry = m_AddressTable.GetEntry(m_AddressTable.Find(path, pathLen));
+  if (entry)
+    segments = entry->segments;
+  else
+    OSCAddressTable::Split(path, pathLen, segments);
+
+  for (OSCAddressTable::SEGMENTS::const_iterator i = segments.begin(); i != segments.end(); i++)
+    address.parts << QString::fromUtf8(&path[i->offset], static_cast<qsizetype>(i->size));
+  if (address.parts.isEmpty())
+    address.parts << address.path;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RouterThread::IsBundled(const sRouteDst &routeDst) const
 {
-  for (EosUdpInThread::RECV_Q::iterator i = recvQ.begin(); i != recvQ.end(); i++)
+  if (m_InFrameBundle)
+    return ((routeDst.dst.options.psnForms & EosOutputOptions::PSN_FORM_BUNDLE) != 0);
+
+  return (m_InBundle && routeDst.dst.options.keepBundles);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::AddToBundle(const EosAddr &addr, EosUdpOutThread *udpThread, EosTcpClientThread *tcpThread, EosOutputOptions::EnumPriority priority, EosPacket &&packet)
+{
+  sBundleOut *bundleOut = nullptr;
+  for (size_t i = 0; i < m_BundleOutCount; ++i)
   {
-    EosUdpInThread::sRecvPacket &recvPacket = *i;
+    if (m_BundleOuts[i].addr == addr && m_BundleOuts[i].priority == priority)
+    {
+      bundleOut = &m_BundleOuts[i];
+      break;
+    }
+  }
 
-    char *buf = recvPacket.packet.GetData();
-    size_t packetSize = static_cast<size_t>(std::max(0, recvPacket.packet.GetSize()));
-    if (OSCParser::IsOSCPacket(buf, packetSize))
+  if (!bundleOut)
+  {
+    if (m_BundleOutCount == m_BundleOuts.size())
+      m_BundleOuts.resize(m_BundleOutCount + 1);
+    bundleOut = &m_BundleOuts[m_BundleOutCount++];
+    bundleOut->addr = addr;
+    bundleOut->udpThread = udpThread;
+    bundleOut->tcpThread = tcpThread;
+    bundleOut->priority = priority;
+    bundleOut->elements.clear();
+    bundleOut->elementsSize = 0;
+  }
+
+  bundleOut->elementsSize += static_cast<size_t>(qMax(0, packet.GetSize()));
+  bundleOut->elements.push_back(std::move(packet));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::FlushBundles()
+{
+  // one bundle per destination, carrying the time tag it arrived with
+  for (size_t i = 0; i < m_BundleOutCount; ++i)
+  {
+    sBundleOut &bundleOut = m_BundleOuts[i];
+    size_t bundleSize = OSCBundleWriter::GetMaxSize(bundleOut.elements.size(), bundleOut.elementsSize);
+    bool sent = false;
+    if (bundleOut.tcpThread || bundleSize <= sm_Max_Datagram_Size)
     {
-      OSCBundleMethod *bundleHandler = static_cast<OSCBundleMethod *>(oscBundleParser.GetRoot());
-      bundleHandler->SetIP(recvPacket.ip);
-      oscBundleParser.ProcessPacket(*this, recvPacket.packet.GetData(), static_cast<size_t>(qMax(0, recvPacket.packet.GetSize())));
-      EosUdpInThread::RECV_Q bundleQ;
-      bundleHandler->Flush(bundleQ);
-      if (!bundleQ.empty())
+      EosPacket packet;
+      OSCBundleWriter writer(packet.Reserve(static_cast<int>(bundleSize)), bundleSize);
+      writer.Begin(m_BundleTimeTag);
+      for (EosPacket::Q::const_iterator j = bundleOut.elements.begin(); j != bundleOut.elements.end(); j++)
+        writer.Add(j->GetDataConst(), static_cast<size_t>(qMax(0, j->GetSize())));
+      packet.Resize(static_cast<int>(writer.GetSize()));
+
+      if (bundleOut.tcpThread)
       {
-        for (EosUdpInThread::RECV_Q::iterator j = bundleQ.begin(); j != bundleQ.end(); j++)
-          ProcessRecvPacket(routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, addr, /*isOSC*/ true, *j);
+        sent = bundleOut.tcpThread->Send(packet, bundleOut.priority);
+        if (sent && bundleOut.tcpThread->GetOutputOptions().replayState)
+        {
+          for (EosPacket::Q::const_iterator j = bundleOut.elements.begin(); j != bundleOut.elements.end(); j++)
+          {
+            OSCPacketInfo elementInfo;
+            if (OSCPacketInfo::Parse(j->GetDataConst(), static_cast<size_t>(qMax(0, j->GetSize())), elementInfo))
+              UpdateState(*bundleOut.tcpThread, *j, elementInfo);
+          }
+        }
+      }
+      else
+        sent = bundleOut.udpThread->Send(packet, bundleOut.priority);
+    }
+    else
+    {
+      // grew past what one datagram can carry, so the messages go out one by one
+      for (EosPacket::Q::const_iterator j = bundleOut.elements.begin(); j != bundleOut.elements.end(); j++)
+      {
+        if (bundleOut.udpThread->Send(*j, bundleOut.priority))
+          sent = true;
+      }
+    }
 
+    if (sent)
+      SetItemActivity(bundleOut.tcpThread ? bundleOut.tcpThread->GetItemStateTableId() : bundleOut.udpThread->GetItemStateTableId());
+
+    bundleOut.elements.clear();
+    bundleOut.elementsSize = 0;
+  }
+
+  m_BundleOutCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::HoldTimeTagged(const EosAddr &addr, EosUdpInThread::RECV_Q &recvQ, uint64_t nowUS)
+{
+  // bundles dated in the future leave the queue, their messages come back once their time tag arrives
+  size_t kept = 0;
+  for (size_t i = 0; i < recvQ.size(); ++i)
+  {
+    EosUdpInThread::sRecvPacket &recvPacket = recvQ[i];
+    if (recvPacket.info.kind == OSCPacketInfo::KIND_BUNDLE)
+    {
+      size_t size = ((recvPacket.packet.GetSize() > 0) ? static_cast<size_t>(recvPacket.packet.GetSize()) : 0);
+      if (m_Scheduler.Hold(addr, recvPacket.ip, recvPacket.packet.GetDataConst(), size, nowUS))
         continue;
+    }
+
+    if (kept != i)
+      recvQ[kept] = std::move(recvPacket);
+    ++kept;
+  }
+
+  recvQ.erase(recvQ.begin() + static_cast<std::ptrdiff_t>(kept), recvQ.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::ReleaseTimeTagged(INPUT_QS &inputQs, size_t &inputCount, uint64_t nowUS)
+{
+  m_SchedulerEvents.clear();
+  m_Scheduler.Release(nowUS, m_SchedulerEvents);
+
+  // released messages are routed this cycle like any other input, grouped by the input they arrived on
+  sInputQ *inputQ = nullptr;
+  for (size_t i = 0; i < m_SchedulerEvents.size();)
+  {
+    OSCScheduler::sEvent &event = m_SchedulerEvents[i];
+    if (!inputQ || inputQ->addr != event.addr)
+    {
+      if (inputCount == inputQs.size())
+        inputQs.resize(inputCount + 1);
+      inputQ = &inputQs[inputCount++];
+      inputQ->addr = event.addr;
+    }
+
+    size_t end = (i + 1);
+    size_t elementsSize = static_cast<size_t>(qMax(0, event.packet.GetSize()));
+    while (end < m_SchedulerEvents.size() && m_SchedulerEvents[end].bundle == event.bundle && m_SchedulerEvents[end].dueUS == event.dueUS)
+      elementsSize += static_cast<size_t>(qMax(0, m_SchedulerEvents[end++].packet.GetSize()));
+
+    if ((end - i) == 1)
+      inputQ->recvQ.push_back(EosUdpInThread::sRecvPacket(std::move(event.packet), event.ip, event.info));
+    else
+    {
+      // messages released together from one bundle are bundled again, so routes that keep bundles still see one
+      size_t bundleSize = OSCBundleWriter::GetMaxSize(end - i, elementsSize);
+      EosPacket packet;
+      OSCBundleWriter writer(packet.Reserve(static_cast<int>(bundleSize)), bundleSize);
+      writer.Begin();
+      for (size_t j = i; j < end; ++j)
+        writer.Add(m_SchedulerEvents[j].packet.GetDataConst(), static_cast<size_t>(qMax(0, m_SchedulerEvents[j].packet.GetSize())));
+      packet.Resize(static_cast<int>(writer.GetSize()));
+
+      OSCPacketInfo info;
+      OSCPacketInfo::Parse(packet.GetDataConst(), writer.GetSize(), info);
+      inputQ->recvQ.push_back(EosUdpInThread::sRecvPacket(std::move(packet), event.ip, info));
+    }
+
+    i = end;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::LogSchedulerStats()
+{
+  const OSCScheduler::sStats &stats = m_Scheduler.GetStats();
+  if (stats.released == m_SchedulerLoggedStats.released && stats.overflow == m_SchedulerLoggedStats.overflow && stats.tooFar == m_SchedulerLoggedStats.tooFar)
+    return;
+
+  unsigned long long released = (stats.released - m_SchedulerLoggedStats.released);
+  unsigned long long lateTotalUS = (stats.lateTotalUS - m_SchedulerLoggedStats.lateTotalUS);
+  unsigned long long onTime = (stats.lateHistogram[0] + stats.lateHistogram[1] + stats.lateHistogram[2] + stats.lateHistogram[3]);
+  onTime -= (m_SchedulerLoggedStats.lateHistogram[0] + m_SchedulerLoggedStats.lateHistogram[1] + m_SchedulerLoggedStats.lateHistogram[2] + m_SchedulerLoggedStats.lateHistogram[3]);
+
+  QString msg = QString("time tags: %1 messages sent on schedule, %2 waiting, %3 within 1 ms").arg(released).arg(m_Scheduler.size()).arg(onTime);
+  if (released != 0)
+    msg += QString(", %1 us late on average, %2 us at most").arg(lateTotalUS / released).arg(stats.lateMaxUS);
+  if (stats.overflow != m_SchedulerLoggedStats.overflow)
+    msg += QString(", %1 bundles sent early, too many waiting").arg(stats.overflow - m_SchedulerLoggedStats.overflow);
+  if (stats.tooFar != m_SchedulerLoggedStats.tooFar)
+    msg += QString(", %1 bundles sent early, dated too far ahead").arg(stats.tooFar - m_SchedulerLoggedStats.tooFar);
+  m_PrivateLog.AddInfo(msg.toUtf8().constData());
+
+  m_SchedulerLoggedStats = stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::ProcessRecvQ(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
+                                const EosUdpInThread::RECV_Q &recvQ)
+{
+  for (EosUdpInThread::RECV_Q::const_iterator i = recvQ.begin(); i != recvQ.end(); i++)
+  {
+    const EosUdpInThread::sRecvPacket &recvPacket = *i;
+    const char *buf = recvPacket.packet.GetDataConst();
+    size_t size = ((recvPacket.packet.GetSize() > 0) ? static_cast<size_t>(recvPacket.packet.GetSize()) : 0);
+
+    if (recvPacket.info.kind == OSCPacketInfo::KIND_BUNDLE)
+    {
+      // route each message in place, nested bundles included
+      // routes that keep bundles collect their messages per destination until the whole bundle is routed
+      OSCBundleIterator bundle(buf, size);
+      const char *element = nullptr;
+      size_t elementSize = 0;
+      OSCPacketInfo elementInfo;
+      bool routed = false;
+      m_InBundle = true;
+      m_BundleTimeTag = bundle.GetTimeTag();
+      while (bundle.Next(element, elementSize, elementInfo))
+      {
+        ProcessRecvPacket(routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, addr, /*isOSC*/ true, recvPacket, element, elementSize, elementInfo);
+        routed = true;
       }
+      m_InBundle = false;
+
+      if (m_BundleOutCount != 0)
+        FlushBundles();
+
+      if (routed)
+        continue;
     }
 
-    ProcessRecvPacket(routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, addr, /*isOSC*/ false, recvPacket);
+    bool isOSC = (recvPacket.info.kind == OSCPacketInfo::KIND_MESSAGE);
+    ProcessRecvPacket(routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, addr, isOSC, recvPacket, buf, size, recvPacket.info);
   }
-  recvQ.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void RouterThread::ProcessRecvPacket(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
-                                     bool isOSC, EosUdpInThread::sRecvPacket &recvPacket)
+                                     bool isOSC, const EosUdpInThread::sRecvPacket &recvPacket, const char *buf, size_t packetSize, const OSCPacketInfo &info)
 {
+  // osc path was located when the packet was received
+  sAddress uninternedAddress;
+  sAddress *address = nullptr;
+
+  if (isOSC && info.pathLen != 0)
+  {
+    address = InternAddress(buf, info.pathLen);
+    if (!address)
+    {
+      // address table is full
+      MakeAddress(buf, info.pathLen, uninternedAddress);
+      address = &uninternedAddress;
+    }
+  }
+  else
+    address = &uninternedAddress;
+
+  FindRoutingDestinations(routesByPort, addr, recvPacket.ip, isOSC, *address, routingDestinationList);
+
+  if (!routingDestinationList.empty())
+  {
+    OSCArgsView args;
+    if (isOSC)
+      args = OSCArgsView(buf, packetSize, info);
+
+    for (DESTINATIONS_LIST::const_iterator i = routingDestinationList.begin(); i != routingDestinationList.end(); i++)
+    {
+      const ROUTE_DESTINATIONS &destinations = **i;
+      for (ROUTE_DESTINATIONS::const_iterator j = destinations.begin(); j != destinations.end(); j++)
+      {
+        // "/psn/<id>/..." messages are mapped for routes with a psn transform, anything else passes as is
+        EosPacket transformedOSC;
+        OSCPacketInfo transformedInfo;
+        if (isOSC && j->psnTransform && TransformPSNMessage(*j, buf, packetSize, info, transformedOSC, transformedInfo))
+        {
+          // fields are rewritten in psn order, so the address only changes when the sender used another order
+          sAddress reorderedAddress;
+          const sAddress *transformedAddress = address;
+          if (transformedInfo.pathLen != info.pathLen || memcmp(transformedOSC.GetDataConst(), buf, info.pathLen) != 0)
+          {
+            MakeAddress(transformedOSC.GetDataConst(), transformedInfo.pathLen, reorderedAddress);
+            transformedAddress = &reorderedAddress;
+          }
+
+          OSCArgsView transformedArgs(transformedOSC.GetDataConst(), static_cast<size_t>(transformedOSC.GetSize()), transformedInfo);
+          RouteToDestination(udpOutThreads, tcpClientThreads, *j, *transformedAddress, isOSC, transformedArgs, recvPacket.ip, transformedOSC);
+          continue;
+        }
+
+        RouteToDestination(udpOutThreads, tcpClientThreads, *j, *address, isOSC, args, recvPacket.ip, recvPacket.packet);
+      }
+    }
+  }
+
   routingDestinationList.clear();
+}
 
-  // find osc path null terminator
-  char *buf = recvPacket.packet.GetData();
-  size_t packetSize = ((recvPacket.packet.GetSize() > 0) ? static_cast<size_t>(recvPacket.packet.GetSize()) : 0);
-  QString path;
+////////////////////////////////////////////////////////////////////////////////
 
-  if (isOSC)
+void RouterThread::ProcessTrackerQ(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
+                                   const EosUdpInThread::TRACKER_Q &trackerQ)
+{
+  for (size_t i = 0; i < trackerQ.size(); ++i)
   {
-    // get OSC path
-    for (size_t i = 0; i < packetSize; i++)
+    const EosUdpInThread::sRecvTracker &recvTracker = trackerQ[i];
+
+    // psn transforms map the trackers of a whole frame at once, the first time a route needs one of them
+    if (i == 0 || trackerQ[i - 1].frame != recvTracker.frame)
     {
-      if (buf[i] == 0)
+      ++m_TrackerFrame;
+      m_TrackerFrameBegin = i;
+      m_TrackerFrameEnd = (i + 1);
+      while (m_TrackerFrameEnd < trackerQ.size() && trackerQ[m_TrackerFrameEnd].frame == recvTracker.frame)
+        ++m_TrackerFrameEnd;
+    }
+
+    // routes that ask for it get the messages of a frame as one bundle per destination, the others one by one
+    bool frameBundle = ((recvTracker.forms & EosOutputOptions::PSN_FORM_BUNDLE) != 0);
+    if (frameBundle && !m_InFrameBundle)
+    {
+      m_InFrameBundle = true;
+      m_BundleTimeTag = OSCBundleWriter::sm_Time_Tag_Immediate;
+    }
+
+    // each field on its own address, then all of them on one
+    size_t fieldCount = 0;
+    for (int field = 0; field < PSNTracker::FIELD_COUNT; ++field)
+    {
+      uint32_t fieldBit = PSNTracker::FieldBit(static_cast<PSNTracker::EnumField>(field));
+      if ((recvTracker.tracker.fields & fieldBit) != 0)
       {
-        if (i != 0)
-          path = QString::fromUtf8(buf);
-        break;
+        if ((recvTracker.forms & EosOutputOptions::PSN_FORM_FIELDS) != 0)
+          ProcessTracker(routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, addr, trackerQ, i, fieldBit);
+        ++fieldCount;
+      }
+    }
+
+    // with a single field the combined address is the field address, so it is only routed once
+    if ((recvTracker.forms & EosOutputOptions::PSN_FORM_COMBINED) != 0 && (fieldCount > 1 || (recvTracker.forms & EosOutputOptions::PSN_FORM_FIELDS) == 0))
+      ProcessTracker(routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, addr, trackerQ, i, recvTracker.tracker.fields);
+
+    if (frameBundle && ((i + 1) == trackerQ.size() || trackerQ[i + 1].frame != recvTracker.frame))
+    {
+      m_InFrameBundle = false;
+      if (m_BundleOutCount != 0)
+        FlushBundles();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::ProcessTracker(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
+                                  const EosUdpInThread::TRACKER_Q &trackerQ, size_t index, uint32_t fieldMask)
+{
+  const EosUdpInThread::sRecvTracker &recvTracker = trackerQ[index];
+
+  char path[128];
+  size_t pathLen = recvTracker.tracker.MakePath(fieldMask, path, sizeof(path));
+  if (pathLen == 0)
+    return;
+
+  sAddress uninternedAddress;
+  sAddress *address = InternAddress(path, pathLen);
+  if (!address)
+  {
+    // address table is full
+    MakeAddress(path, pathLen, uninternedAddress);
+    address = &uninternedAddress;
+  }
+
+  FindRoutingDestinations(routesByPort, addr, recvTracker.ip, /*isOSC*/ true, *address, routingDestinationList);
+
+  // osc is written the first time a destination needs it
+  EosPacket osc;
+  OSCArgsView args;
+  bool hasOSC = false;
+
+  for (DESTINATIONS_LIST::const_iterator i = routingDestinationList.begin(); i != routingDestinationList.end(); i++)
+  {
+    const ROUTE_DESTINATIONS &destinations = **i;
+    for (ROUTE_DESTINATIONS::const_iterator j = destinations.begin(); j != destinations.end(); j++)
+    {
+      const PSNTracker &tracker = (j->psnTransform ? GetTransformedTracker(*j, trackerQ, index) : recvTracker.tracker);
+      if (RouteTrackerToDestination(udpOutThreads, tcpClientThreads, *j, tracker, fieldMask, recvTracker.ip))
+        continue;
+
+      if (j->psnTransform)
+      {
+        // mapped values are written as osc for this route alone
+        EosPacket transformedOSC;
+        OSCPacketInfo transformedInfo;
+        if (MakeTrackerOSC(tracker, fieldMask, transformedOSC, transformedInfo))
+        {
+          OSCArgsView transformedArgs(transformedOSC.GetDataConst(), static_cast<size_t>(transformedOSC.GetSize()), transformedInfo);
+          RouteToDestination(udpOutThreads, tcpClientThreads, *j, *address, /*isOSC*/ true, transformedArgs, recvTracker.ip, transformedOSC);
+        }
+        continue;
       }
+
+      if (!hasOSC)
+      {
+        OSCPacketInfo info;
+        if (!MakeTrackerOSC(recvTracker.tracker, fieldMask, osc, info))
+        {
+          routingDestinationList.clear();
+          return;
+        }
+
+        args = OSCArgsView(osc.GetDataConst(), static_cast<size_t>(osc.GetSize()), info);
+        hasOSC = true;
+      }
+
+      RouteToDestination(udpOutThreads, tcpClientThreads, *j, *address, /*isOSC*/ true, args, recvTracker.ip, osc);
     }
   }
 
+  routingDestinationList.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const PSNTracker &RouterThread::GetTransformedTracker(const sRouteDst &routeDst, const EosUdpInThread::TRACKER_Q &trackerQ, size_t index)
+{
+  sPSNTransform &psnTransform = *routeDst.psnTransform;
+  if (psnTransform.frame != m_TrackerFrame)
+  {
+    psnTransform.trackers.resize(m_TrackerFrameEnd - m_TrackerFrameBegin);
+    for (size_t i = m_TrackerFrameBegin; i < m_TrackerFrameEnd; ++i)
+      psnTransform.trackers[i - m_TrackerFrameBegin] = trackerQ[i].tracker;
+    psnTransform.transform.Apply(psnTransform.trackers.data(), psnTransform.trackers.size());
+    psnTransform.frame = m_TrackerFrame;
+  }
+
+  return psnTransform.trackers[index - m_TrackerFrameBegin];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RouterThread::TransformPSNMessage(const sRouteDst &routeDst, const char *buf, size_t size, const OSCPacketInfo &info, EosPacket &osc, OSCPacketInfo &oscInfo)
+{
+  PSNTracker tracker;
+  if (!PSNTracker::FromOSC(buf, size, info, tracker))
+    return false;
+
+  // nothing to map without float3 fields
+  if ((tracker.fields & ~(PSNTracker::FieldBit(PSNTracker::FIELD_STATUS) | PSNTracker::FieldBit(PSNTracker::FIELD_TIMESTAMP))) == 0)
+    return false;
+
+  routeDst.psnTransform->transform.Apply(&tracker, 1);
+  return MakeTrackerOSC(tracker, tracker.fields, osc, oscInfo);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RouterThread::MakeTrackerOSC(const PSNTracker &tracker, uint32_t fieldMask, EosPacket &osc, OSCPacketInfo &oscInfo)
+{
+  size_t size = 0;
+  if (!tracker.MakeOSC(fieldMask, osc.Reserve(static_cast<int>(PSNTracker::sm_Max_OSC_Size)), PSNTracker::sm_Max_OSC_Size, size))
+    return false;
+
+  osc.Resize(static_cast<int>(size));
+  return OSCPacketInfo::Parse(osc.GetDataConst(), size, oscInfo);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::FindRoutingDestinations(ROUTES_BY_PORT &routesByPort, const EosAddr &addr, unsigned int senderIp, bool isOSC, sAddress &address, DESTINATIONS_LIST &routingDestinationList)
+{
+  routingDestinationList.clear();
+
+  bool cacheRoutes = (isOSC && address.id != OSCAddressTable::sm_Invalid_Id);
+
   // send to matching ports
   ROUTES_BY_PORT_RANGE portsRange = routesByPort.equal_range(addr.port);
   for (; portsRange.first != portsRange.second; portsRange.first++)
@@ -1328,303 +2199,512 @@ void RouterThread::ProcessRecvPacket(ROUTES_BY_PORT &routesByPort, DESTINATIONS_
     const ROUTES_BY_IP &routesByIp = portsRange.first->second;
 
     // send to matching ips
-    ROUTES_BY_IP_RANGE ipsRange = routesByIp.equal_range(recvPacket.ip);
+    ROUTES_BY_IP_RANGE ipsRange = routesByIp.equal_range(senderIp);
     for (; ipsRange.first != ipsRange.second; ipsRange.first++)
-      AddRoutingDestinations(isOSC, path, ipsRange.first->second, routingDestinationList);
+    {
+      if (cacheRoutes)
+        AddRoutingDestinations(&address, ipsRange.first->second, routingDestinationList);
+      else
+        AddRoutingDestinations(isOSC, address.path, ipsRange.first->second, routingDestinationList);
+    }
 
     // send to unspecified ips
-    if (recvPacket.ip != 0)
+    if (senderIp != 0)
     {
       ipsRange = routesByIp.equal_range(0);
       for (; ipsRange.first != ipsRange.second; ipsRange.first++)
-        AddRoutingDestinations(isOSC, path, ipsRange.first->second, routingDestinationList);
+      {
+        if (cacheRoutes)
+          AddRoutingDestinations(&address, ipsRange.first->second, routingDestinationList);
+        else
+          AddRoutingDestinations(isOSC, address.path, ipsRange.first->second, routingDestinationList);
+      }
     }
   }
+}
 
-  if (!routingDestinationList.empty())
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::RouteToDestination(UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const sRouteDst &routeDst, const sAddress &address, bool isOSC, const OSCArgsView &args,
+                                      unsigned int senderIp, const EosPacket &rawPacket)
+{
+  EosAddr dstAddr(routeDst.dst.addr);
+  if (dstAddr.ip.isEmpty())
+    EosAddr::UIntToIP(senderIp, dstAddr.ip);
+
+  // send UDP or TCP?
+  TCP_CLIENT_THREADS::const_iterator k = tcpClientThreads.find(dstAddr);
+  if (k != tcpClientThreads.end())
   {
-    size_t argsCount = 0;
-    OSCArgument *args = 0;
+    EosTcpClientThread *thread = k->second;
     if (isOSC)
     {
-      argsCount = 0xffffffff;
-      args = OSCArgument::GetArgs(buf, packetSize, argsCount);
+      EosPacket packet;
+      OSCPacketInfo packetInfo;
+      if (MakeOSCPacket(address, routeDst.dst, args, packet, packetInfo) && PassChangeFilter(routeDst, senderIp, packet, packetInfo))
+      {
+        if (IsBundled(routeDst))
+        {
+          AddToBundle(dstAddr, nullptr, thread, routeDst.dst.options.priority, std::move(packet));
+          SetItemActivity(routeDst.srcItemStateTableId);
+        }
+        else if (thread->Send(packet, routeDst.dst.options.priority))
+        {
+          UpdateState(*thread, packet, packetInfo);
+          SetItemActivity(routeDst.srcItemStateTableId);
+          SetItemActivity(thread->GetItemStateTableId());
+        }
+      }
+    }
+    else if (thread->Send(rawPacket, routeDst.dst.options.priority))
+    {
+      SetItemActivity(routeDst.srcItemStateTableId);
+      SetItemActivity(thread->GetItemStateTableId());
     }
+  }
+  else
+  {
+    EosUdpOutThread *thread = CreateUdpOutThread(dstAddr, routeDst.dstItemStateTableId, udpOutThreads);
+    if (thread)
+    {
+      if (isOSC)
+      {
+        EosPacket oscPacket;
+        OSCPacketInfo oscPacketInfo;
+        if (MakeOSCPacket(address, routeDst.dst, args, oscPacket, oscPacketInfo) && PassChangeFilter(routeDst, senderIp, oscPacket, oscPacketInfo))
+        {
+          bool sent = false;
+          if (routeDst.dst.protocol == Protocol::kPSN)
+          {
+            if (routeDst.dst.options.psnRateHz != 0)
+            {
+              PSNTracker tracker;
+              if (PSNTracker::FromOSC(oscPacket.GetDataConst(), static_cast<size_t>(qMax(0, oscPacket.GetSize())), oscPacketInfo, tracker))
+              {
+                UpdatePSNOutput(dstAddr, routeDst.dst.options, tracker, tracker.fields);
+                SetItemActivity(routeDst.srcItemStateTableId);
+              }
+            }
+            else
+            {
+              EosPacket psnPacket;
+              if (MakePSNPacket(oscPacket, oscPacketInfo, psnPacket) && thread->Send(psnPacket, routeDst.dst.options.priority))
+                sent = true;
+            }
+          }
+          else if (IsBundled(routeDst))
+          {
+            AddToBundle(dstAddr, thread, nullptr, routeDst.dst.options.priority, std::move(oscPacket));
+            SetItemActivity(routeDst.srcItemStateTableId);
+          }
+          else if (thread->Send(oscPacket, routeDst.dst.options.priority))
+            sent = true;
+
+          if (sent)
+          {
+            SetItemActivity(routeDst.srcItemStateTableId);
+            SetItemActivity(thread->GetItemStateTableId());
+          }
+        }
+      }
+      else if (thread->Send(rawPacket, routeDst.dst.options.priority))
+      {
+        SetItemActivity(routeDst.srcItemStateTableId);
+        SetItemActivity(thread->GetItemStateTableId());
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RouterThread::RouteTrackerToDestination(UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const sRouteDst &routeDst, const PSNTracker &tracker, uint32_t fieldMask,
+                                             unsigned int senderIp)
+{
+  // psn to psn without a path, script, transform or change filter never needs osc
+  const EosRouteDst &dst = routeDst.dst;
+  if (dst.protocol != Protocol::kPSN || dst.script || !dst.path.isEmpty() || dst.hasAnyTransforms() || routeDst.changeFilter)
+    return false;
+
+  EosAddr dstAddr(dst.addr);
+  if (dstAddr.ip.isEmpty())
+    EosAddr::UIntToIP(senderIp, dstAddr.ip);
+
+  if (tcpClientThreads.find(dstAddr) != tcpClientThreads.end())
+    return false;
+
+  EosUdpOutThread *thread = CreateUdpOutThread(dstAddr, routeDst.dstItemStateTableId, udpOutThreads);
+  if (thread)
+  {
+    if (dst.options.psnRateHz != 0)
+    {
+      UpdatePSNOutput(dstAddr, dst.options, tracker, fieldMask);
+      SetItemActivity(routeDst.srcItemStateTableId);
+    }
+    else
+    {
+      EosPacket psnPacket;
+      if (MakePSNPacket(tracker, fieldMask, psnPacket) && thread->Send(psnPacket, dst.options.priority))
+      {
+        SetItemActivity(routeDst.srcItemStateTableId);
+        SetItemActivity(thread->GetItemStateTableId());
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RouterThread::PassChangeFilter(const sRouteDst &routeDst, unsigned int senderIp, const EosPacket &packet, const OSCPacketInfo &packetInfo)
+{
+  if (!routeDst.changeFilter)
+    return true;
+
+  // a route only sends to more than one address when the destination ip is taken from the sender
+  unsigned int ip = (routeDst.dst.addr.ip.isEmpty() ? senderIp : 0);
+  size_t size = ((packet.GetSize() > 0) ? static_cast<size_t>(packet.GetSize()) : 0);
+  return routeDst.changeFilter->Pass(ip, routeDst.dst.addr.port, packet.GetDataConst(), size, packetInfo, m_ChangeFilterTimer.elapsed());
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-    for (DESTINATIONS_LIST::const_iterator i = routingDestinationList.begin(); i != routingDestinationList.end(); i++)
-    {
-      const ROUTE_DESTINATIONS &destinations = **i;
-      for (ROUTE_DESTINATIONS::const_iterator j = destinations.begin(); j != destinations.end(); j++)
-      {
-        const sRouteDst &routeDst = *j;
+void RouterThread::UpdateState(EosTcpClientThread &thread, const EosPacket &packet, const OSCPacketInfo &packetInfo)
+{
+  if (!thread.GetOutputOptions().replayState)
+    return;
 
-        EosAddr dstAddr(routeDst.dst.addr);
-        if (dstAddr.ip.isEmpty())
-          EosAddr::UIntToIP(recvPacket.ip, dstAddr.ip);
+  const EosAddr &addr = thread.GetAddr();
+  uint64_t dst = ((static_cast<uint64_t>(addr.toUInt()) << 16) | addr.port);
+  m_StateStore.Update(dst, packet.GetDataConst(), static_cast<size_t>(qMax(0, packet.GetSize())), packetInfo);
+}
 
-        // send UDP or TCP?
-        TCP_CLIENT_THREADS::const_iterator k = tcpClientThreads.find(dstAddr);
-        if (k != tcpClientThreads.end())
-        {
-          EosTcpClientThread *thread = k->second;
-          if (isOSC)
-          {
-            EosPacket packet;
-            if (MakeOSCPacket(path, routeDst.dst, args, argsCount, packet) && thread->SendFramed(packet))
-            {
-              SetItemActivity(routeDst.srcItemStateTableId);
-              SetItemActivity(thread->GetItemStateTableId());
-            }
-          }
-          else if (thread->Send(recvPacket.packet))
-          {
-            SetItemActivity(routeDst.srcItemStateTableId);
-            SetItemActivity(thread->GetItemStateTableId());
-          }
-        }
-        else
-        {
-          EosUdpOutThread *thread = CreateUdpOutThread(dstAddr, routeDst.dstItemStateTableId, udpOutThreads);
-          if (thread)
-          {
-            if (isOSC)
-            {
-              EosPacket oscPacket;
-              if (MakeOSCPacket(path, routeDst.dst, args, argsCount, oscPacket))
-              {
-                bool sent = false;
-                if (routeDst.dst.protocol == Protocol::kPSN)
-                {
-                  EosPacket psnPacket;
-                  if (MakePSNPacket(oscPacket, psnPacket) && thread->Send(psnPacket))
-                    sent = true;
-                }
-                else if (thread->Send(oscPacket))
-                  sent = true;
+////////////////////////////////////////////////////////////////////////////////
 
-                if (sent)
-                {
-                  SetItemActivity(routeDst.srcItemStateTableId);
-                  SetItemActivity(thread->GetItemStateTableId());
-                }
-              }
-            }
-            else if (thread->Send(recvPacket.packet))
-            {
-              SetItemActivity(routeDst.srcItemStateTableId);
-              SetItemActivity(thread->GetItemStateTableId());
-            }
-          }
-        }
-      }
-    }
+void RouterThread::ReplayState(EosTcpClientThread &thread)
+{
+  const EosOutputOptions &options = thread.GetOutputOptions();
+  if (!options.replayState)
+    return;
+
+  const EosAddr &addr = thread.GetAddr();
+  uint64_t dst = ((static_cast<uint64_t>(addr.toUInt()) << 16) | addr.port);
+  EosPacket::Q packets;
+  size_t count = m_StateStore.Snapshot(dst, options.bundleMTU, packets);
+  if (count == 0)
+    return;
 
-    if (args)
-      delete[] args;
+  size_t sent = 0;
+  for (EosPacket::Q::const_iterator i = packets.begin(); i != packets.end(); i++)
+  {
+    if (thread.Send(*i, EosOutputOptions::PRIORITY_NORMAL))
+      ++sent;
   }
 
-  routingDestinationList.clear();
+  QString msg = QString("tcp %1:%2 connected, replayed %3 last values in %4 packets").arg(addr.ip).arg(addr.port).arg(count).arg(sent);
+  if (sent != packets.size())
+    msg += QString(", %1 packets not queued").arg(packets.size() - sent);
+  m_PrivateLog.AddInfo(msg.toUtf8().constData());
+  SetItemActivity(thread.GetItemStateTableId());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool RouterThread::MakeOSCPacket(const QString &srcPath, const EosRouteDst &dst, OSCArgument *args, size_t argsCount, EosPacket &packet)
+bool RouterThread::MakeOSCPacket(const sAddress &srcAddress, const EosRouteDst &dst, const OSCArgsView &args, EosPacket &packet, OSCPacketInfo &packetInfo)
 {
   QString sendPath;
   if (dst.script)
   {
-    QString error = m_ScriptEngine->evaluate(dst.scriptText, srcPath, args, argsCount, &packet);
+    QString error = m_ScriptEngine->evaluate(dst.scriptText, srcAddress.path, args, &packet);
     if (error.isEmpty())
+    {
+      OSCPacketInfo::Parse(packet.GetDataConst(), static_cast<size_t>(packet.GetSize()), packetInfo);
       return true;
+    }
 
     OSCParserClient_Log(error.toStdString());
     return false;
   }
 
-  MakeSendPath(srcPath, dst.path, args, argsCount, sendPath);
-  if (!sendPath.isEmpty())
-  {
-    size_t oscPacketSize = 0;
-    char *oscPacketData = nullptr;
+  MakeSendPath(srcAddress, dst.path, args, sendPath);
+  if (sendPath.isEmpty())
+    return false;
 
-    int index = sendPath.indexOf('=');
-    if (index > 0)
-    {
-      oscPacketData = OSCPacketWriter::CreateForString(sendPath.toUtf8().constData(), oscPacketSize);
+  QByteArray sendPathUtf8 = sendPath.toUtf8();
+  size_t sendPathLen = static_cast<size_t>(sendPathUtf8.size());
+  size_t packetSize = 0;
 
-      if (oscPacketData && oscPacketSize && dst.hasAnyTransforms())
-      {
-        argsCount = 1;
-        args = OSCArgument::GetArgs(oscPacketData, oscPacketSize, argsCount);
-        if (args)
-        {
-          OSCPacketWriter oscPacket(sendPath.left(index).toUtf8().constData());
+  int index = sendPathUtf8.indexOf('=');
+  if (index > 0)
+  {
+    OSCBufferWriter oscPacket(packet.Reserve(static_cast<int>(OSCBufferWriter::GetMaxSizeForString(sendPathLen))), static_cast<size_t>(packet.GetCapacity()));
+    if (!oscPacket.WriteForString(sendPathUtf8.constData(), sendPathLen, packetSize))
+      return false;
 
-          if (ApplyTransform(args[0], dst, oscPacket))
-          {
-            delete[] oscPacketData;
-            oscPacketData = oscPacket.Create(oscPacketSize);
-          }
+    packet.Resize(static_cast<int>(packetSize));
+    oscPacket.GetInfo(packetInfo);
 
-          delete[] args;
-        }
-      }
-    }
-    else
+    if (dst.hasAnyTransforms())
     {
-      OSCPacketWriter oscPacket(sendPath.toUtf8().constData());
-
-      if (dst.hasAnyTransforms())
+      OSCArgView arg;
+      if (OSCArgsView(packet.GetDataConst(), packetSize).GetArg(0, arg))
       {
-        if (args && argsCount != 0)
+        EosPacket transformedPacket;
+        OSCBufferWriter transformedOscPacket(transformedPacket.Reserve(static_cast<int>(OSCBufferWriter::GetMaxSize(static_cast<size_t>(index), 1, 4))),
+                                             static_cast<size_t>(transformedPacket.GetCapacity()));
+        if (transformedOscPacket.Begin(sendPathUtf8.constData(), static_cast<size_t>(index), 1) && ApplyTransform(arg, dst, transformedOscPacket) && transformedOscPacket.End(packetSize))
         {
-          if (!ApplyTransform(args[0], dst, oscPacket))
-            return false;
+          transformedPacket.Resize(static_cast<int>(packetSize));
+          transformedOscPacket.GetInfo(packetInfo);
+          packet = std::move(transformedPacket);
         }
-        else
-          return false;
       }
-      else
-        oscPacket.AddOSCArgList(args, argsCount);
-
-      oscPacketData = oscPacket.Create(oscPacketSize);
     }
 
-    if (oscPacketData && oscPacketSize)
+    return true;
+  }
+
+  if (dst.hasAnyTransforms())
+  {
+    OSCArgView arg;
+    if (!args.GetArg(0, arg))
+      return false;
+
+    OSCBufferWriter oscPacket(packet.Reserve(static_cast<int>(OSCBufferWriter::GetMaxSize(sendPathLen, 1, 4))), static_cast<size_t>(packet.GetCapacity()));
+    if (!oscPacket.Begin(sendPathUtf8.constData(), sendPathLen, 1) || !ApplyTransform(arg, dst, oscPacket) || !oscPacket.End(packetSize))
+      return false;
+
+    oscPacket.GetInfo(packetInfo);
+  }
+  else
+  {
+    // arguments are passed through untouched
+    OSCBufferWriter oscPacket(packet.Reserve(static_cast<int>(OSCBufferWriter::GetMaxSize(sendPathLen, args.size(), args.GetArgsDataSize()))), static_cast<size_t>(packet.GetCapacity()));
+    if (!oscPacket.Begin(sendPathUtf8.constData(), sendPathLen, args.size()) || !oscPacket.AddArgs(args) || !oscPacket.End(packetSize))
+      return false;
+
+    oscPacket.GetInfo(packetInfo);
+  }
+
+  packet.Resize(static_cast<int>(packetSize));
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// psn encoder sinks, called with each packet of a frame
+struct PSNPacketCopy
+{
+  PSNPacketCopy(EosPacket &Packet)
+    : packet(Packet)
+  {
+  }
+
+  void operator()(const char *data, size_t size)
+  {
+    if (!copied && size != 0)
     {
-      packet = EosPacket(oscPacketData, static_cast<int>(oscPacketSize));
-      delete[] oscPacketData;
-      return true;
+      packet = EosPacket(data, static_cast<int>(size));
+      copied = true;
     }
   }
 
-  return false;
+  EosPacket &packet;
+  bool copied = false;
+};
+
+struct PSNPacketSender
+{
+  PSNPacketSender(EosUdpOutThread &Thread, EosOutputOptions::EnumPriority Priority)
+    : thread(Thread)
+    , priority(Priority)
+  {
+  }
+
+  void operator()(const char *data, size_t size)
+  {
+    if (size != 0 && thread.Send(EosPacket(data, static_cast<int>(size)), priority))
+      sent = true;
+  }
+
+  EosUdpOutThread &thread;
+  EosOutputOptions::EnumPriority priority;
+  bool sent = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+psn::float3 MakeFloat3(const float *values)
+{
+  return psn::float3(values[0], values[1], values[2]);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool GetFloat3(OSCArgument *args, size_t argCount, size_t index, psn::float3 &f3)
+void MakePSNTracker(const PSNTracker &tracker, uint32_t fieldMask, psn::tracker &psnTracker)
 {
-  if (!args || (index + 2) >= argCount)
-    return false;
+  // psn::tracker starts with pos set, only fields in the mask may be encoded
+  psnTracker = psn::tracker(tracker.id);
+  psnTracker.unset_pos();
 
-  if (!args[index].GetFloat(f3.x))
-    return false;
+  fieldMask &= tracker.fields;
+  if ((fieldMask & PSNTracker::FieldBit(PSNTracker::FIELD_POS)) != 0)
+    psnTracker.set_pos(MakeFloat3(tracker.float3[PSNTracker::FIELD_POS]));
+  if ((fieldMask & PSNTracker::FieldBit(PSNTracker::FIELD_SPEED)) != 0)
+    psnTracker.set_speed(MakeFloat3(tracker.float3[PSNTracker::FIELD_SPEED]));
+  if ((fieldMask & PSNTracker::FieldBit(PSNTracker::FIELD_ORIENTATION)) != 0)
+    psnTracker.set_ori(MakeFloat3(tracker.float3[PSNTracker::FIELD_ORIENTATION]));
+  if ((fieldMask & PSNTracker::FieldBit(PSNTracker::FIELD_ACCELERATION)) != 0)
+    psnTracker.set_accel(MakeFloat3(tracker.float3[PSNTracker::FIELD_ACCELERATION]));
+  if ((fieldMask & PSNTracker::FieldBit(PSNTracker::FIELD_TARGET)) != 0)
+    psnTracker.set_target_pos(MakeFloat3(tracker.float3[PSNTracker::FIELD_TARGET]));
+  if ((fieldMask & PSNTracker::FieldBit(PSNTracker::FIELD_STATUS)) != 0)
+    psnTracker.set_status(tracker.status);
+  if ((fieldMask & PSNTracker::FieldBit(PSNTracker::FIELD_TIMESTAMP)) != 0)
+    psnTracker.set_timestamp(tracker.timestamp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-  if (!args[index + 1].GetFloat(f3.y))
+bool RouterThread::MakePSNPacket(const EosPacket &osc, const OSCPacketInfo &oscInfo, EosPacket &psn)
+{
+  PSNTracker tracker;
+  if (!PSNTracker::FromOSC(osc.GetDataConst(), static_cast<size_t>(qMax(0, osc.GetSize())), oscInfo, tracker))
     return false;
 
-  return args[index + 2].GetFloat(f3.z);
+  return MakePSNPacket(tracker, tracker.fields, psn);
 }
 
-bool RouterThread::MakePSNPacket(EosPacket &osc, EosPacket &psn)
+////////////////////////////////////////////////////////////////////////////////
+
+bool RouterThread::MakePSNPacket(const PSNTracker &tracker, uint32_t fieldMask, EosPacket &psn)
 {
-  char *data = osc.GetData();
-  if (!data || osc.GetSize() < 1)
-    return false;
+  psn::tracker trackers[1];
+  MakePSNTracker(tracker, fieldMask, trackers[0]);
+
+  uint64_t timestamp = 0;
+  if (m_PSNEncoderTimer.isValid())
+    timestamp = m_PSNEncoderTimer.elapsed();
+  else
+    m_PSNEncoderTimer.start();
+
+  // only the first packet is kept, a single tracker always fits in one
+  char buffer[psn::MAX_UDP_PACKET_SIZE];
+  PSNPacketCopy copy(psn);
+  m_PSNEncoder->encode_data(trackers, trackers[0].is_timestamp_set() ? trackers[0].get_timestamp() : timestamp, buffer, sizeof(buffer), copy);
+  return copy.copied;
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-  // find osc path null terminator
-  for (int i = 0; i < osc.GetSize(); i++)
+void RouterThread::UpdatePSNOutput(const EosAddr &addr, const EosOutputOptions &options, const PSNTracker &tracker, uint32_t fieldMask)
+{
+  PSN_OUTPUTS::iterator i = m_PSNOutputs.find(addr);
+  if (i == m_PSNOutputs.end())
   {
-    if (data[i] == 0)
-    {
-      if (i < 1)
-        break;
+    i = m_PSNOutputs.insert(PSN_OUTPUTS::value_type(addr, sPSNOutput())).first;
+    i->second.aggregator = PSNFrameAggregator(options.psnRateHz, options.psnPredict);
+    i->second.encoder = new psn::psn_encoder("OSCRouter");
+    i->second.priority = options.priority;
+  }
 
-      QString path = QString::fromUtf8(data[0] == '/' ? &data[1] : &data[0]);
-      QStringList parts = path.split(QLatin1Char('/'));
-      if (parts.size() < 2)
-        break;
+  uint64_t nowUS = static_cast<uint64_t>(m_SchedulerClock.nsecsElapsed() / 1000);
+  i->second.aggregator.Update(tracker, fieldMask, nowUS);
+}
 
-      if (parts[0] != QLatin1String("psn"))
-        break;
+////////////////////////////////////////////////////////////////////////////////
 
-      psn::tracker tracker(parts[1].toUShort());
+void RouterThread::FlushPSNOutputs(UDP_OUT_THREADS &udpOutThreads, uint64_t nowUS)
+{
+  for (PSN_OUTPUTS::iterator i = m_PSNOutputs.begin(); i != m_PSNOutputs.end(); i++)
+  {
+    sPSNOutput &output = i->second;
+    int due = output.aggregator.Poll(nowUS, m_PSNFrameTrackers);
+    if (due == PSNFrameAggregator::DUE_NONE)
+      continue;
 
-      if (parts.size() > 2)
-      {
-        size_t argCount = 0xffffffff;
-        OSCArgument *args = OSCArgument::GetArgs(&data[i], static_cast<size_t>(osc.GetSize()), argCount);
-        size_t argIndex = 0;
-        psn::float3 f3;
-        for (int part = 2; part < parts.size(); ++part)
-        {
-          if (parts[part] == QLatin1String("pos"))
-          {
-            if (GetFloat3(args, argCount, argIndex, f3))
-              tracker.set_pos(f3);
-            argIndex += 3;
-          }
-          else if (parts[part] == QLatin1String("speed"))
-          {
-            if (GetFloat3(args, argCount, argIndex, f3))
-              tracker.set_speed(f3);
-            argIndex += 3;
-          }
-          else if (parts[part] == QLatin1String("orientation"))
-          {
-            if (GetFloat3(args, argCount, argIndex, f3))
-              tracker.set_ori(f3);
-            argIndex += 3;
-          }
-          else if (parts[part] == QLatin1String("acceleration"))
-          {
-            if (GetFloat3(args, argCount, argIndex, f3))
-              tracker.set_accel(f3);
-            argIndex += 3;
-          }
-          else if (parts[part] == QLatin1String("target"))
-          {
-            if (GetFloat3(args, argCount, argIndex, f3))
-              tracker.set_target_pos(f3);
-            argIndex += 3;
-          }
-          else if (parts[part] == QLatin1String("status"))
-          {
-            float f = 0;
-            if (args && argIndex < argCount && args[argIndex].GetFloat(f))
-              tracker.set_status(f);
-            ++argIndex;
-          }
-          else if (parts[part] == QLatin1String("timestamp"))
-          {
-            uint64_t u = 0;
-            if (args && argIndex < argCount && args[argIndex].GetUInt64(u))
-              tracker.set_timestamp(u);
-            ++argIndex;
-          }
-        }
+    UDP_OUT_THREADS::const_iterator threadIter = udpOutThreads.find(i->first);
+    if (threadIter == udpOutThreads.end())
+      continue;
 
-        if (args)
-          delete[] args;
-      }
+    EosUdpOutThread *thread = threadIter->second;
+
+    m_PSNFrame.resize(m_PSNFrameTrackers.size());
+    for (size_t j = 0; j < m_PSNFrameTrackers.size(); ++j)
+    {
+      const PSNTracker &tracker = m_PSNFrameTrackers[j];
+      MakePSNTracker(tracker, tracker.fields, m_PSNFrame[j]);
+      if (due & PSNFrameAggregator::DUE_INFO)
+        m_PSNFrame[j].set_name("Tracker " + std::to_string(tracker.id));
+    }
 
-      psn::tracker_map trackers;
-      trackers[tracker.get_id()] = tracker;
+    // each packet is encoded into the same buffer and sent before the next, a frame larger than one datagram shares its frame id
+    char buffer[psn::MAX_UDP_PACKET_SIZE];
+    PSNPacketSender sender(*thread, output.priority);
+    if (due & PSNFrameAggregator::DUE_INFO)
+      output.encoder->encode_info(m_PSNFrame, nowUS, buffer, sizeof(buffer), sender);
+    if (due & PSNFrameAggregator::DUE_DATA)
+      output.encoder->encode_data(m_PSNFrame, nowUS, buffer, sizeof(buffer), sender);
 
-      uint64_t timestamp = 0;
-      if (m_PSNEncoderTimer.isValid())
-        timestamp = m_PSNEncoderTimer.elapsed();
-      else
-        m_PSNEncoderTimer.start();
+    if (sender.sent)
+      SetItemActivity(thread->GetItemStateTableId());
+  }
+}
 
-      std::list<std::string> packets = m_PSNEncoder->encode_data(trackers, tracker.is_timestamp_set() ? tracker.get_timestamp() : timestamp);
-      if (!packets.empty() && packets.front().data() && packets.front().size() != 0)
-      {
-        psn = EosPacket(packets.front().data(), static_cast<int>(packets.front().size()));
-        return true;
-      }
+////////////////////////////////////////////////////////////////////////////////
 
-      break;
+void RouterThread::LogPSNPredictionStats()
+{
+  for (PSN_OUTPUTS::const_iterator i = m_PSNOutputs.begin(); i != m_PSNOutputs.end(); i++)
+  {
+    i->second.aggregator.GetPredictionStats(m_PSNPredictionStats);
+    if (m_PSNPredictionStats.empty())
+      continue;
+
+    // one line per destination: the average over its trackers, and the one that strayed furthest
+    double sum = 0;
+    uint64_t count = 0;
+    PSNFrameAggregator::PREDICTION_STATS::const_iterator worst = m_PSNPredictionStats.begin();
+    for (PSNFrameAggregator::PREDICTION_STATS::const_iterator j = m_PSNPredictionStats.begin(); j != m_PSNPredictionStats.end(); j++)
+    {
+      sum += j->second.sum;
+      count += j->second.count;
+      if (j->second.max > worst->second.max)
+        worst = j;
     }
+
+    QString msg = QString("psn output %1:%2 prediction error over %3 trackers: mean %4 mm, worst tracker %5 max %6 mm")
+                    .arg(i->first.ip)
+                    .arg(i->first.port)
+                    .arg(m_PSNPredictionStats.size())
+                    .arg((count == 0) ? 0.0 : (sum * 1000.0 / count), 0, 'f', 1)
+                    .arg(worst->first)
+                    .arg(worst->second.max * 1000.0, 0, 'f', 1);
+    m_PrivateLog.AddInfo(msg.toUtf8().constData());
   }
+}
 
-  return false;
+////////////////////////////////////////////////////////////////////////////////
+
+void RouterThread::ClearPSNOutputs()
+{
+  for (PSN_OUTPUTS::const_iterator i = m_PSNOutputs.begin(); i != m_PSNOutputs.end(); i++)
+    delete i->second.encoder;
+  m_PSNOutputs.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RouterThread::IsUrgentAddr(const EosAddr &addr) const
+{
+  // like output options, a route without a destination ip matches any ip on its port
+  return (m_UrgentAddrs.find(addr) != m_UrgentAddrs.end() || m_UrgentAddrs.find(EosAddr(QString(), addr.port)) != m_UrgentAddrs.end());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void RouterThread::ProcessTcpConnectionQ(TCP_CLIENT_THREADS &tcpClientThreads, OSCStream::EnumFrameMode frameMode, EosTcpServerThread::CONNECTION_Q &tcpConnectionQ)
+void RouterThread::ProcessTcpConnectionQ(TCP_CLIENT_THREADS &tcpClientThreads, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options, EosTcpServerThread::CONNECTION_Q &tcpConnectionQ)
 {
   for (EosTcpServerThread::CONNECTION_Q::const_iterator i = tcpConnectionQ.begin(); i != tcpConnectionQ.end(); i++)
   {
@@ -1641,13 +2721,15 @@ void RouterThread::ProcessTcpConnectionQ(TCP_CLIENT_THREADS &tcpClientThreads, O
 
     EosTcpClientThread *thread = new EosTcpClientThread();
     tcpClientThreads[tcpConnection.addr] = thread;
-    thread->Start(tcpConnection.tcp, tcpConnection.addr, ItemStateTable::sm_Invalid_Id, frameMode, m_ReconnectDelay);
+    thread->SetRouterWake(&m_Wake);
+    thread->SetUrgent(IsUrgentAddr(tcpConnection.addr));
+    thread->Start(tcpConnection.tcp, tcpConnection.addr, ItemStateTable::sm_Invalid_Id, frameMode, options, m_ReconnectDelay);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool RouterThread::ApplyTransform(OSCArgument &arg, const EosRouteDst &dst, OSCPacketWriter &packet)
+bool RouterThread::ApplyTransform(const OSCArgView &arg, const EosRouteDst &dst, OSCBufferWriter &packet)
 {
   float f;
   if (arg.GetFloat(f))
@@ -1692,8 +2774,11 @@ bool RouterThread::ApplyTransform(OSCArgument &arg, const EosRouteDst &dst, OSCP
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void RouterThread::MakeSendPath(const QString &srcPath, const QString &dstPath, const OSCArgument *args, size_t argsCount, QString &sendPath)
+void RouterThread::MakeSendPath(const sAddress &srcAddress, const QString &dstPath, const OSCArgsView &args, QString &sendPath)
 {
+  const QString &srcPath = srcAddress.path;
+  const QStringList &srcPathParts = srcAddress.parts;
+
   if (dstPath.isEmpty())
   {
     sendPath = srcPath;
@@ -1711,9 +2796,6 @@ void RouterThread::MakeSendPath(const QString &srcPath, const QString &dstPath,
       // %%1 => %1
       // %A  => %A
 
-      QStringList srcPathParts;
-      bool srcPathPartsInitialized = false;
-
       // look for all instances of '%' follow by a number
       int digitCount = 0;
       for (int i = 0; i <= sendPath.size(); i++)
@@ -1741,28 +2823,18 @@ void RouterThread::MakeSendPath(const QString &srcPath, const QString &dstPath,
 
               int srcPathIndex = (sendPath.mid(startIndex + 1, digitCount).toInt() - 1);
 
-              if (!srcPathPartsInitialized)
-              {
-                srcPathParts = srcPath.split(OSC_ADDR_SEPARATOR, Qt::SkipEmptyParts);
-                if (srcPathParts.isEmpty())
-                  srcPathParts << srcPath;
-                srcPathPartsInitialized = true;
-              }
-
               QString insertStr;
               if (srcPathIndex >= 0)
               {
                 if (srcPathIndex >= srcPathParts.size())
                 {
-                  if (args)
+                  srcPathIndex -= srcPathParts.size();
+                  OSCArgView arg;
+                  if (srcPathIndex >= 0 && args.GetArg(static_cast<size_t>(srcPathIndex), arg))
                   {
-                    srcPathIndex -= srcPathParts.size();
-                    if (srcPathIndex >= 0 && static_cast<size_t>(srcPathIndex) < argsCount)
-                    {
-                      std::string argStr;
-                      if (args[srcPathIndex].GetString(argStr))
-                        insertStr = QString::fromStdString(argStr);
-                    }
+                    std::string argStr;
+                    if (arg.GetString(argStr))
+                      insertStr = QString::fromStdString(argStr);
                   }
                 }
                 else
@@ -1838,6 +2910,21 @@ void RouterThread::SetItemActivity(ItemStateTable::ID id)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void RouterThread::SetItemOutputStats(ItemStateTable::ID id, const ItemState::sOutputStats &stats)
+{
+  m_Mutex.lock();
+  const ItemState *itemState = m_ItemStateTable.GetItemState(id);
+  if (itemState && itemState->output != stats)
+  {
+    ItemState newItemState(*itemState);
+    newItemState.output = stats;
+    m_ItemStateTable.Update(id, newItemState);
+  }
+  m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void RouterThread::run()
 {
   m_PrivateLog.AddInfo("router thread started");
@@ -1846,39 +2933,45 @@ void RouterThread::run()
   m_ScriptEngine = new ScriptEngine();
   m_PSNEncoder = new psn::psn_encoder("OSCRouter");
   m_PSNEncoderTimer.invalidate();
+  m_ChangeFilterTimer.start();
+  m_SchedulerClock.start();
+  m_SchedulerLogTimer.start();
 
   UDP_IN_THREADS udpInThreads;
   UDP_OUT_THREADS udpOutThreads;
   TCP_CLIENT_THREADS tcpClientThreads;
   TCP_SERVER_THREADS tcpServerThreads;
-  ROUTES_BY_PORT routesByPort;
+  ROUTES_BY_LANE routesByLane(EosOutputOptions::PRIORITY_COUNT);
   DESTINATIONS_LIST routingDestinationList;
   EosUdpInThread::RECV_Q recvQ;
+  INPUT_QS inputQs;
   EosTcpServerThread::CONNECTION_Q tcpConnectionQ;
   EosLog::LOG_Q tempLogQ;
 
-  OSCParser oscBundleParser;
-  oscBundleParser.SetRoot(new OSCBundleMethod());
-
-  BuildRoutes(routesByPort, udpInThreads, udpOutThreads, tcpClientThreads, tcpServerThreads);
+  BuildRoutes(routesByLane, udpInThreads, udpOutThreads, tcpClientThreads, tcpServerThreads);
 
   while (m_Run)
   {
+    // every input is drained before anything is routed, so each lane sees all waiting packets
+    size_t inputCount = 0;
+
     // UDP input
     for (UDP_IN_THREADS::iterator i = udpInThreads.begin(); i != udpInThreads.end();)
     {
       EosUdpInThread *thread = i->second;
       bool running = thread->isRunning();
-      thread->Flush(tempLogQ, recvQ);
+      if (inputCount == inputQs.size())
+        inputQs.resize(inputCount + 1);
+      sInputQ &inputQ = inputQs[inputCount++];
+      inputQ.addr = thread->GetAddr();
+      thread->Flush(tempLogQ, inputQ.recvQ, inputQ.trackerQ);
       m_PrivateLog.AddQ(tempLogQ);
       tempLogQ.clear();
 
       SetItemState(thread->GetItemStateTableId(), thread->GetState());
-      if (!recvQ.empty())
+      if (!inputQ.recvQ.empty() || !inputQ.trackerQ.empty())
         SetItemActivity(thread->GetItemStateTableId());
 
-      ProcessRecvQ(oscBundleParser, routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, thread->GetAddr(), recvQ);
-
       if (!running)
       {
         delete thread;
@@ -1902,7 +2995,7 @@ void RouterThread::run()
       if (!tcpConnectionQ.empty())
       {
         SetItemActivity(thread->GetItemStateTableId());
-        ProcessTcpConnectionQ(tcpClientThreads, thread->GetFrameMode(), tcpConnectionQ);
+        ProcessTcpConnectionQ(tcpClientThreads, thread->GetFrameMode(), thread->GetOutputOptions(), tcpConnectionQ);
       }
 
       if (!running)
@@ -1915,19 +3008,33 @@ void RouterThread::run()
     }
 
     // TCP clients
+    m_OutputStats.assign(m_ItemStateTable.GetList().size(), ItemState::sOutputStats());
     for (TCP_CLIENT_THREADS::iterator i = tcpClientThreads.begin(); i != tcpClientThreads.end();)
     {
       EosTcpClientThread *thread = i->second;
       bool running = thread->isRunning();
-      thread->Flush(tempLogQ, recvQ);
+      if (inputCount == inputQs.size())
+        inputQs.resize(inputCount + 1);
+      sInputQ &inputQ = inputQs[inputCount++];
+      inputQ.addr = thread->GetAddr();
+      thread->Flush(tempLogQ, inputQ.recvQ);
       m_PrivateLog.AddQ(tempLogQ);
       tempLogQ.clear();
 
       SetItemState(thread->GetItemStateTableId(), thread->GetState());
-      if (!recvQ.empty())
+      if (!inputQ.recvQ.empty())
         SetItemActivity(thread->GetItemStateTableId());
 
-      ProcessRecvQ(oscBundleParser, routesByPort, routingDestinationList, udpOutThreads, tcpClientThreads, thread->GetAddr(), recvQ);
+      // a peer that has just (re)connected is brought up to date before anything new is routed to it
+      if (thread->TakeConnected())
+        ReplayState(*thread);
+
+      if (thread->GetItemStateTableId() < m_OutputStats.size())
+      {
+        ItemState::sOutputStats stats;
+        thread->GetOutputStats(stats);
+        m_OutputStats[thread->GetItemStateTableId()].add(stats);
+      }
 
       if (!running)
       {
@@ -1938,6 +3045,41 @@ void RouterThread::run()
         i++;
     }
 
+    // future dated bundles wait for their time tag, messages whose time has come join this cycle's input
+    uint64_t nowUS = static_cast<uint64_t>(m_SchedulerClock.nsecsElapsed() / 1000);
+    for (size_t i = 0; i < inputCount; ++i)
+    {
+      if (!inputQs[i].recvQ.empty())
+        HoldTimeTagged(inputQs[i].addr, inputQs[i].recvQ, nowUS);
+    }
+
+    if (!m_Scheduler.empty())
+      ReleaseTimeTagged(inputQs, inputCount, nowUS);
+
+    // route lane by lane, a higher lane is sent in full before a lower one is looked at
+    for (ROUTES_BY_LANE::iterator lane = routesByLane.begin(); lane != routesByLane.end(); lane++)
+    {
+      if (lane->empty())
+        continue;
+
+      for (size_t i = 0; i < inputCount; ++i)
+      {
+        if (!inputQs[i].recvQ.empty())
+          ProcessRecvQ(*lane, routingDestinationList, udpOutThreads, tcpClientThreads, inputQs[i].addr, inputQs[i].recvQ);
+        if (!inputQs[i].trackerQ.empty())
+          ProcessTrackerQ(*lane, routingDestinationList, udpOutThreads, tcpClientThreads, inputQs[i].addr, inputQs[i].trackerQ);
+      }
+    }
+
+    for (size_t i = 0; i < inputCount; ++i)
+    {
+      inputQs[i].recvQ.clear();
+      inputQs[i].trackerQ.clear();
+    }
+
+    if (!m_PSNOutputs.empty())
+      FlushPSNOutputs(udpOutThreads, static_cast<uint64_t>(m_SchedulerClock.nsecsElapsed() / 1000));
+
     // UDP output
     for (UDP_OUT_THREADS::iterator i = udpOutThreads.begin(); i != udpOutThreads.end();)
     {
@@ -1949,6 +3091,14 @@ void RouterThread::run()
 
       SetItemState(thread->GetItemStateTableId(), thread->GetState());
 
+      // several threads may share one item when the destination ip is taken from the sender
+      if (thread->GetItemStateTableId() < m_OutputStats.size())
+      {
+        ItemState::sOutputStats stats;
+        thread->GetOutputStats(stats);
+        m_OutputStats[thread->GetItemStateTableId()].add(stats);
+      }
+
       if (!running)
       {
         delete thread;
@@ -1958,9 +3108,44 @@ void RouterThread::run()
         i++;
     }
 
+    for (CHANGE_FILTERS::const_iterator i = m_ChangeFilters.begin(); i != m_ChangeFilters.end(); i++)
+    {
+      if (i->itemStateTableId < m_OutputStats.size())
+      {
+        ItemState::sOutputStats &stats = m_OutputStats[i->itemStateTableId];
+        stats.suppressed += i->filter->GetSuppressed();
+        stats.suppressedBytes += i->filter->GetSuppressedBytes();
+      }
+    }
+
+    for (ItemStateTable::ID id = 0; id < m_OutputStats.size(); ++id)
+    {
+      if (m_OutputStats[id] != ItemState::sOutputStats())
+        SetItemOutputStats(id, m_OutputStats[id]);
+    }
+
+    if (m_SchedulerLogTimer.elapsed() >= 10000)
+    {
+      LogSchedulerStats();
+      LogPSNPredictionStats();
+      m_SchedulerLogTimer.restart();
+    }
+
     UpdateLog();
 
-    msleep(1);
+    // input threads wake the router as soon as they queue packets, held bundles and psn frames when they are due
+    uint64_t waitUS = 1000;
+    uint64_t dueUS = 0;
+    nowUS = static_cast<uint64_t>(m_SchedulerClock.nsecsElapsed() / 1000);
+    if (m_Scheduler.GetNextDue(dueUS))
+      waitUS = ((dueUS > nowUS) ? qMin<uint64_t>(dueUS - nowUS, waitUS) : 0);
+    for (PSN_OUTPUTS::const_iterator i = m_PSNOutputs.begin(); i != m_PSNOutputs.end() && waitUS != 0; i++)
+    {
+      if (i->second.aggregator.GetNextDue(dueUS))
+        waitUS = ((dueUS > nowUS) ? qMin<uint64_t>(dueUS - nowUS, waitUS) : 0);
+    }
+    if (waitUS != 0)
+      m_Wake.Wait(waitUS);
   }
 
   // shutdown
@@ -2008,8 +3193,17 @@ void RouterThread::run()
 
   m_ItemStateTable.Deactivate();
 
+  for (CHANGE_FILTERS::const_iterator i = m_ChangeFilters.begin(); i != m_ChangeFilters.end(); i++)
+    delete i->filter;
+  m_ChangeFilters.clear();
+
+  for (PSN_TRANSFORMS::const_iterator i = m_PSNTransforms.begin(); i != m_PSNTransforms.end(); i++)
+    delete *i;
+  m_PSNTransforms.clear();
+
   delete m_PSNEncoder;
   m_PSNEncoder = nullptr;
+  ClearPSNOutputs();
 
   delete m_ScriptEngine;
   m_ScriptEngine = nullptr;
@@ -2031,19 +3225,63 @@ void RouterThread::OSCParserClient_Send(const char * /*buf*/, size_t /*size*/) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-QString ScriptEngine::evaluate(const QString &script, const QString &path /*= QString()*/, const OSCArgument *args /*= nullptr*/, size_t argsCount /*= 0*/, EosPacket *packet /*= nullptr*/)
+QString ScriptEngine::evaluate(const QString &script, const QString &path /*= QString()*/, const OSCArgsView &args /*= OSCArgsView()*/, EosPacket *packet /*= nullptr*/)
 {
   // set globals
   m_JS.globalObject().setProperty(QLatin1String("OSC"), path);
 
-  quint32 count = static_cast<quint32>(argsCount);
-  if (!args)
-    count = 0;
+  quint32 count = static_cast<quint32>(args.size());
 
   QJSValue jsarray = m_JS.newArray(count);
-  for (quint32 i = 0; i < count; ++i)
+  OSCArgView oscArg;
+  for (quint32 i = 0; i < count && args.GetArg(i, oscArg); ++i)
   {
-    switch (args[i].GetType())
+    // convert runs of numeric arguments in one pass
+    const quint32 MaxRun = 64;
+    quint32 run = static_cast<quint32>(qMin(args.GetRunLength(i), static_cast<size_t>(MaxRun)));
+    if (run > 1)
+    {
+      bool converted = true;
+      switch (oscArg.GetTag())
+      {
+        case 'i':
+        {
+          int32_t n[MaxRun];
+          converted = args.GetInts(i, n, run);
+          for (quint32 j = 0; converted && j < run; ++j)
+            jsarray.setProperty(i + j, n[j]);
+        }
+        break;
+
+        case 'f':
+        {
+          float n[MaxRun];
+          converted = args.GetFloats(i, n, run);
+          for (quint32 j = 0; converted && j < run; ++j)
+            jsarray.setProperty(i + j, n[j]);
+        }
+        break;
+
+        case 'd':
+        {
+          double n[MaxRun];
+          converted = args.GetDoubles(i, n, run);
+          for (quint32 j = 0; converted && j < run; ++j)
+            jsarray.setProperty(i + j, n[j]);
+        }
+        break;
+
+        default: converted = false; break;
+      }
+
+      if (converted)
+      {
+        i += (run - 1);
+        continue;
+      }
+    }
+
+    switch (oscArg.GetType())
     {
       case OSCArgument::OSC_TYPE_INT32:
       case OSCArgument::OSC_TYPE_INT64:
@@ -2052,7 +3290,7 @@ QString ScriptEngine::evaluate(const QString &script, const QString &path /*= QS
       case OSCArgument::OSC_TYPE_MIDI:
       {
         int n = 0;
-        if (args[i].GetInt(n))
+        if (oscArg.GetInt(n))
           jsarray.setProperty(i, n);
       }
       break;
@@ -2060,7 +3298,7 @@ QString ScriptEngine::evaluate(const QString &script, const QString &path /*= QS
       case OSCArgument::OSC_TYPE_FLOAT32:
       {
         float n = 0;
-        if (args[i].GetFloat(n))
+        if (oscArg.GetFloat(n))
           jsarray.setProperty(i, n);
       }
       break;
@@ -2068,7 +3306,7 @@ QString ScriptEngine::evaluate(const QString &script, const QString &path /*= QS
       case OSCArgument::OSC_TYPE_FLOAT64:
       {
         double n = 0;
-        if (args[i].GetDouble(n))
+        if (oscArg.GetDouble(n))
           jsarray.setProperty(i, n);
       }
       break;
@@ -2080,7 +3318,7 @@ QString ScriptEngine::evaluate(const QString &script, const QString &path /*= QS
       default:
       {
         std::string str;
-        if (args[i].GetString(str))
+        if (oscArg.GetString(str))
           jsarray.setProperty(i, QString::fromStdString(str));
       }
       break;
@@ -2114,29 +3352,49 @@ QString ScriptEngine::evaluate(const QString &script, const QString &path /*= QS
   if (sendPath.isEmpty())
     sendPath = path;
 
-  OSCPacketWriter osc(sendPath.toUtf8().constData());
+  QByteArray sendPathUtf8 = sendPath.toUtf8();
 
   jsarray = m_JS.globalObject().property(QLatin1String("ARGS"));
   count = static_cast<quint32>(qMax(0, jsarray.property(QLatin1String("length")).toInt()));
+
+  // size the output first, so it can be encoded in place
+  size_t argsDataSize = 0;
   for (quint32 i = 0; i < count; ++i)
   {
     QJSValue arg = jsarray.property(i);
     switch (arg.toPrimitive().type())
     {
-      case QJSPrimitiveValue::Boolean: osc.AddBool(arg.toBool()); break;
-      case QJSPrimitiveValue::Integer: osc.AddInt32(arg.toInt()); break;
-      case QJSPrimitiveValue::Double: osc.AddFloat32(static_cast<float>(arg.toNumber())); break;
-      case QJSPrimitiveValue::String: osc.AddString(arg.toString().toStdString()); break;
+      case QJSPrimitiveValue::Integer:
+      case QJSPrimitiveValue::Double: argsDataSize += 4; break;
+      case QJSPrimitiveValue::String: argsDataSize += (static_cast<size_t>(arg.toString().toUtf8().size()) + 4); break;
       default: break;
     }
   }
 
-  size_t packetSize = 0;
-  char *packetData = osc.Create(packetSize);
-  if (packetData && packetSize)
+  size_t packetSize = OSCBufferWriter::GetMaxSize(static_cast<size_t>(sendPathUtf8.size()), count, argsDataSize);
+  OSCBufferWriter osc(packet->Reserve(static_cast<int>(packetSize)), static_cast<size_t>(packet->GetCapacity()));
+  if (osc.Begin(sendPathUtf8.constData(), static_cast<size_t>(sendPathUtf8.size()), count))
   {
-    *packet = EosPacket(packetData, static_cast<int>(packetSize));
-    delete[] packetData;
+    for (quint32 i = 0; i < count; ++i)
+    {
+      QJSValue arg = jsarray.property(i);
+      switch (arg.toPrimitive().type())
+      {
+        case QJSPrimitiveValue::Boolean: osc.AddBool(arg.toBool()); break;
+        case QJSPrimitiveValue::Integer: osc.AddInt32(arg.toInt()); break;
+        case QJSPrimitiveValue::Double: osc.AddFloat32(static_cast<float>(arg.toNumber())); break;
+        case QJSPrimitiveValue::String:
+        {
+          QByteArray str = arg.toString().toUtf8();
+          osc.AddString(str.constData(), static_cast<size_t>(str.size()));
+        }
+        break;
+        default: break;
+      }
+    }
+
+    if (osc.End(packetSize))
+      packet->Resize(static_cast<int>(packetSize));
   }
 
   return QString();
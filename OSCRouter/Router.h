@@ -38,16 +38,37 @@
 #include "ItemState.h"
 #endif
 
+#ifndef OSC_UTILS_H
+#include "OSCUtils.h"
+#endif
+
+#ifndef OUTPUT_STAGES_H
+#include "OutputStages.h"
+#endif
+
+#ifndef OSC_SCHEDULER_H
+#include "OSCScheduler.h"
+#endif
+
+#ifndef PSN_UTILS_H
+#include "PSNUtils.h"
+#endif
+
 #ifndef NETWORK_UTILS_H
 #include "NetworkUtils.h"
 #endif
 
+#include <deque>
+#include <set>
+
 class EosTcp;
+class ChangeFilter;
 
 namespace psn
 {
 class psn_decoder;
 class psn_encoder;
+struct tracker;
 };  // namespace psn
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -58,7 +79,7 @@ public:
   ScriptEngine() = default;
 
   QJSEngine &js() { return m_JS; }
-  QString evaluate(const QString &script, const QString &path = QString(), const OSCArgument *args = nullptr, size_t argsCount = 0, EosPacket *packet = nullptr);
+  QString evaluate(const QString &script, const QString &path = QString(), const OSCArgsView &args = OSCArgsView(), EosPacket *packet = nullptr);
 
 private:
   QJSEngine m_JS;
@@ -75,6 +96,7 @@ public:
     bool server = false;
     OSCStream::EnumFrameMode frameMode = OSCStream::FRAME_MODE_DEFAULT;
     EosAddr addr;
+    EosOutputOptions options;
     ItemStateTable::ID itemStateTableId = ItemStateTable::sm_Invalid_Id;
   };
 
@@ -111,6 +133,7 @@ public:
   virtual void OSCParserClient_Log(const std::string &message);
   virtual void OSCParserClient_Send(const char *, size_t) {}
   virtual void PrintPacket(OSCParser &oscParser, const char *packet, size_t size);
+  virtual void PrintPSNTracker(const PSNTracker &tracker);
 
 protected:
   EosLog::EnumLogMsgType m_LogType;
@@ -121,6 +144,26 @@ protected:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// lets one thread sleep until another has work for it, wakes are not lost if they come before the wait
+class ThreadWake
+{
+public:
+  ThreadWake()
+    : m_Wake(false)
+  {
+  }
+
+  virtual void Wake();
+  virtual void Wait(uint64_t timeoutUS);
+
+private:
+  QMutex m_Mutex;
+  QWaitCondition m_Condition;
+  bool m_Wake;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class EosUdpInThread : public QThread
 {
 public:
@@ -129,25 +172,59 @@ public:
     sRecvPacket(const char *data, int size, unsigned int Ip)
       : packet(data, size)
       , ip(Ip)
+    {
+      OSCPacketInfo::Parse(data, static_cast<size_t>(qMax(0, size)), info);
+    }
+    sRecvPacket(EosPacket &&Packet, unsigned int Ip, const OSCPacketInfo &Info)
+      : packet(std::move(Packet))
+      , ip(Ip)
+      , info(Info)
     {
     }
     EosPacket packet;
     unsigned int ip;
+    OSCPacketInfo info;
   };
   typedef std::vector<sRecvPacket> RECV_Q;
 
+  struct sRecvTracker
+  {
+    PSNTracker tracker;
+    unsigned int ip = 0;
+    uint32_t frame = 0;  // counts psn frames received by the input
+    uint16_t forms = 0;  // EosOutputOptions::EnumPSNForm bits
+  };
+  typedef std::vector<sRecvTracker> TRACKER_Q;
+
   EosUdpInThread();
   virtual ~EosUdpInThread();
 
   virtual void Start(const EosAddr &addr, QString multicastIP, Protocol protocol, ItemStateTable::ID itemStateTableId, unsigned int reconnectDelayMS);
   virtual void Stop();
+  void SetRouterWake(ThreadWake *routerWake) { m_RouterWake = routerWake; }
+  void SetPSNFanOut(unsigned int fields, unsigned int forms)
+  {
+    m_PSNFields = fields;
+    m_PSNForms = forms;
+  }
   const EosAddr &GetAddr() const { return m_Addr; }
   Protocol GetProtocol() const { return m_Protocol; }
   ItemStateTable::ID GetItemStateTableId() const { return m_ItemStateTableId; }
   ItemState::EnumState GetState();
-  virtual void Flush(EosLog::LOG_Q &logQ, RECV_Q &recvQ);
+  virtual void Flush(EosLog::LOG_Q &logQ, RECV_Q &recvQ, TRACKER_Q &trackerQ);
 
 protected:
+  // each psn server sending to the input gets its own decoder, so frames from different servers never mix
+  struct sPSNSource
+  {
+    psn::psn_decoder *decoder = nullptr;
+    uint64_t loggedIncomplete = 0;
+    uint64_t loggedDuplicates = 0;
+    QString systemName;
+  };
+
+  typedef std::map<uint64_t, sPSNSource> PSN_SOURCES;  // by sender (ip << 16) | port
+
   EosAddr m_Addr;
   QString m_MulticastIP;
   Protocol m_Protocol = Protocol::kDefault;
@@ -158,15 +235,29 @@ protected:
   EosLog m_Log;
   EosLog m_PrivateLog;
   RECV_Q m_Q;
+  TRACKER_Q m_TrackerQ;
+  TRACKER_Q m_DecodedTrackers;
   QRecursiveMutex m_Mutex;
-  psn::psn_decoder *m_PSNDecoder = nullptr;
-  std::optional<uint8_t> m_PSNFrame;
+  ThreadWake *m_RouterWake = nullptr;
+  PSN_SOURCES m_PSNSources;
+  QElapsedTimer m_PSNStatsTimer;
+  uint32_t m_PSNFrameCount = 0;
+  unsigned int m_PSNFields = EosOutputOptions::PSN_FIELDS_ALL;
+  unsigned int m_PSNForms = (EosOutputOptions::PSN_FORM_FIELDS | EosOutputOptions::PSN_FORM_COMBINED);
+  std::optional<unsigned int> m_LogPrefixIp;
 
   virtual void run();
   virtual void UpdateLog();
   virtual void SetState(ItemState::EnumState state);
-  virtual void RecvPacket(const QHostAddress &host, const char *data, int len, OSCParser &logParser, PacketLogger &packetLogger);
+  virtual void RecvPacket(const QHostAddress &host, unsigned short port, const char *data, int len, OSCParser &logParser, PacketLogger &packetLogger);
+  virtual sPSNSource *GetPSNSource(unsigned int ip, unsigned short port);
+  virtual void DecodePSNFrame(unsigned int ip, const psn::psn_decoder &decoder);
+  virtual void LogPSNStats();
+  virtual void ClearPSNSources();
   virtual void QueuePacket(const QHostAddress &host, const char *data, int len, OSCParser &logParser, PacketLogger &packetLogger);
+  virtual void SetLogPrefix(const QHostAddress &host, unsigned int ip, PacketLogger &packetLogger);
+
+  static const size_t sm_Max_PSN_Sources;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -177,29 +268,42 @@ public:
   EosUdpOutThread();
   virtual ~EosUdpOutThread();
 
-  virtual void Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, unsigned int reconnectDelayMS);
+  virtual void Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, const EosOutputOptions &options, unsigned int reconnectDelayMS);
   virtual void Stop();
   const EosAddr &GetAddr() const { return m_Addr; }
   ItemStateTable::ID GetItemStateTableId() const { return m_ItemStateTableId; }
   ItemState::EnumState GetState();
-  virtual bool Send(const EosPacket &packet);
+  virtual void GetOutputStats(ItemState::sOutputStats &stats);
+  virtual bool Send(const EosPacket &packet, EosOutputOptions::EnumPriority priority = EosOutputOptions::PRIORITY_NORMAL);
   virtual void Flush(EosLog::LOG_Q &logQ);
 
 protected:
   EosAddr m_Addr;
   ItemStateTable::ID m_ItemStateTableId;
   ItemState::EnumState m_State;
+  EosOutputOptions m_Options;
+  ItemState::sOutputStats m_OutputStats;
   unsigned int m_ReconnectDelay;
   bool m_Run;
   EosLog m_Log;
   EosLog m_PrivateLog;
-  EosPacket::Q m_Q;
+  OutputQueue m_Q[EosOutputOptions::PRIORITY_COUNT];  // one lane per priority class
   bool m_QEnabled;
   QRecursiveMutex m_Mutex;
+  ThreadWake m_Wake;
+
+  enum EnumTimer
+  {
+    TIMER_COALESCE = 0,
+    TIMER_BUNDLE_WINDOW,
+    TIMER_PACING
+  };
 
   virtual void run();
   virtual void UpdateLog();
   virtual void SetState(ItemState::EnumState state);
+
+  static const uint64_t sm_Max_Wait_US;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -210,14 +314,18 @@ public:
   EosTcpClientThread();
   virtual ~EosTcpClientThread();
 
-  virtual void Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, unsigned int reconnectDelayMS);
-  virtual void Start(EosTcp *tcp, const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, unsigned int reconnectDelayMS);
+  virtual void Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options, unsigned int reconnectDelayMS);
+  virtual void Start(EosTcp *tcp, const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options, unsigned int reconnectDelayMS);
   virtual void Stop();
+  void SetRouterWake(ThreadWake *routerWake) { m_RouterWake = routerWake; }
+  void SetUrgent(bool urgent) { m_Urgent = urgent; }  // before Start
   const EosAddr &GetAddr() const { return m_Addr; }
   ItemStateTable::ID GetItemStateTableId() const { return m_ItemStateTableId; }
   ItemState::EnumState GetState();
-  virtual bool Send(const EosPacket &packet);
-  virtual bool SendFramed(const EosPacket &packet);
+  const EosOutputOptions &GetOutputOptions() const { return m_Options; }
+  virtual bool TakeConnected();  // true once after each (re)connect
+  virtual void GetOutputStats(ItemState::sOutputStats &stats);
+  virtual bool Send(const EosPacket &packet, EosOutputOptions::EnumPriority priority = EosOutputOptions::PRIORITY_NORMAL);  // framed as it is written
   virtual void Flush(EosLog::LOG_Q &logQ, EosUdpInThread::RECV_Q &recvQ);
 
 protected:
@@ -226,17 +334,31 @@ protected:
   ItemStateTable::ID m_ItemStateTableId;
   ItemState::EnumState m_State;
   OSCStream::EnumFrameMode m_FrameMode;
+  EosOutputOptions m_Options;
+  ItemState::sOutputStats m_OutputStats;
   unsigned int m_ReconnectDelay;
   bool m_Run;
   EosLog m_Log;
   EosLog m_PrivateLog;
   EosUdpInThread::RECV_Q m_RecvQ;
-  EosPacket::Q m_SendQ;
+  OutputQueue m_SendQ[EosOutputOptions::PRIORITY_COUNT];  // one lane per priority class
+  bool m_Urgent;                                         // high priority routes send here, poll every millisecond
+  bool m_Connected;                                      // connected since the last TakeConnected
   QRecursiveMutex m_Mutex;
+  ThreadWake *m_RouterWake = nullptr;
+
+  enum EnumTimer
+  {
+    TIMER_PACING = 0,
+    TIMER_CORK
+  };
 
   virtual void run();
   virtual void UpdateLog();
   virtual void SetState(ItemState::EnumState state);
+  virtual bool SendBatch(EosTcp &tcp, OutputFrameBatch &batch);
+
+  static const size_t sm_Max_Batch_Size;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -258,12 +380,13 @@ public:
   EosTcpServerThread();
   virtual ~EosTcpServerThread();
 
-  virtual void Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, unsigned int reconnectDelayMS);
+  virtual void Start(const EosAddr &addr, ItemStateTable::ID itemStateTableId, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options, unsigned int reconnectDelayMS);
   virtual void Stop();
   const EosAddr &GetAddr() const { return m_Addr; }
   ItemStateTable::ID GetItemStateTableId() const { return m_ItemStateTableId; }
   ItemState::EnumState GetState();
   OSCStream::EnumFrameMode GetFrameMode() const { return m_FrameMode; }
+  const EosOutputOptions &GetOutputOptions() const { return m_Options; }
   virtual void Flush(EosLog::LOG_Q &logQ, CONNECTION_Q &connectionQ);
 
 protected:
@@ -271,6 +394,7 @@ protected:
   ItemStateTable::ID m_ItemStateTableId;
   ItemState::EnumState m_State;
   OSCStream::EnumFrameMode m_FrameMode;
+  EosOutputOptions m_Options;
   unsigned int m_ReconnectDelay;
   bool m_Run;
   EosLog m_Log;
@@ -285,20 +409,6 @@ protected:
 
 ////////////////////////////////////////////////////////////////////////////////
 
-class OSCBundleMethod : public OSCMethod
-{
-public:
-  virtual void SetIP(unsigned int ip) { m_IP = ip; }
-  virtual bool ProcessPacket(OSCParserClient &client, char *buf, size_t size);
-  virtual void Flush(EosUdpInThread::RECV_Q &q);
-
-private:
-  unsigned int m_IP = 0u;
-  EosUdpInThread::RECV_Q m_Q;
-};
-
-////////////////////////////////////////////////////////////////////////////////
-
 class RouterThread : public QThread, private OSCParserClient
 {
 public:
@@ -309,11 +419,27 @@ public:
   virtual void Flush(EosLog::LOG_Q &logQ, ItemStateTable &itemStateTable);
 
 protected:
+  // a route's psn transform, with the psn input frame it last mapped so each frame is mapped once per route
+  struct sPSNTransform
+  {
+    sPSNTransform(const float *matrix)
+      : transform(matrix)
+    {
+    }
+    PSNTransform transform;
+    PSNFrameAggregator::TRACKERS trackers;
+    uint64_t frame = 0;
+  };
+
+  typedef std::vector<sPSNTransform *> PSN_TRANSFORMS;
+
   struct sRouteDst
   {
     EosRouteDst dst;
     ItemStateTable::ID srcItemStateTableId;
     ItemStateTable::ID dstItemStateTableId;
+    ChangeFilter *changeFilter = nullptr;
+    sPSNTransform *psnTransform = nullptr;
   };
 
   typedef std::vector<sRouteDst> ROUTE_DESTINATIONS;
@@ -336,6 +462,8 @@ protected:
   typedef std::pair<unsigned short, ROUTES_BY_IP> ROUTES_BY_PORT_PAIR;
   typedef std::pair<ROUTES_BY_PORT::const_iterator, ROUTES_BY_PORT::const_iterator> ROUTES_BY_PORT_RANGE;
 
+  typedef std::vector<ROUTES_BY_PORT> ROUTES_BY_LANE;  // indexed by EosOutputOptions::EnumPriority
+
   typedef std::map<EosAddr, EosUdpInThread *> UDP_IN_THREADS;
   typedef std::map<EosAddr, EosUdpOutThread *> UDP_OUT_THREADS;
 
@@ -344,6 +472,78 @@ protected:
 
   typedef std::vector<const ROUTE_DESTINATIONS *> DESTINATIONS_LIST;
 
+  // packets flushed from one input this cycle, routed once per lane
+  struct sInputQ
+  {
+    EosAddr addr;
+    EosUdpInThread::RECV_Q recvQ;
+    EosUdpInThread::TRACKER_Q trackerQ;  // psn inputs only
+  };
+
+  typedef std::vector<sInputQ> INPUT_QS;
+
+  struct sAddressRoutes
+  {
+    const sRoutesByIp *routesByIp = nullptr;
+    DESTINATIONS_LIST destinations;
+  };
+
+  typedef std::vector<sAddressRoutes> ADDRESS_ROUTES;
+
+  // everything derived from an osc address, built once per distinct address
+  struct sAddress
+  {
+    OSCAddressTable::ID id = OSCAddressTable::sm_Invalid_Id;
+    QString path;
+    QStringList parts;
+    ADDRESS_ROUTES routes;
+  };
+
+  typedef std::deque<sAddress> ADDRESSES;
+
+  typedef std::map<EosAddr, EosOutputOptions> OUTPUT_OPTIONS;
+  typedef std::set<EosAddr> ADDR_SET;
+
+  // what a psn input turns into osc, everything any of its routes asks for
+  struct sPSNFanOut
+  {
+    unsigned int fields = 0;
+    unsigned int forms = 0;
+  };
+
+  typedef std::map<unsigned short, sPSNFanOut> PSN_FAN_OUTS;  // by input port
+
+  // psn destination sent whole frames at a fixed rate, set up by the first route that sends to it
+  struct sPSNOutput
+  {
+    PSNFrameAggregator aggregator;
+    psn::psn_encoder *encoder = nullptr;
+    EosOutputOptions::EnumPriority priority = EosOutputOptions::PRIORITY_NORMAL;
+  };
+
+  typedef std::map<EosAddr, sPSNOutput> PSN_OUTPUTS;
+
+  struct sChangeFilter
+  {
+    ChangeFilter *filter = nullptr;
+    ItemStateTable::ID itemStateTableId = ItemStateTable::sm_Invalid_Id;
+  };
+
+  typedef std::vector<sChangeFilter> CHANGE_FILTERS;
+
+  // messages from the bundle being routed that are on their way to one destination
+  struct sBundleOut
+  {
+    EosAddr addr;
+    EosUdpOutThread *udpThread = nullptr;
+    EosTcpClientThread *tcpThread = nullptr;
+    EosOutputOptions::EnumPriority priority = EosOutputOptions::PRIORITY_NORMAL;
+    EosPacket::Q elements;
+    size_t elementsSize = 0;
+  };
+
+  typedef std::vector<sBundleOut> BUNDLE_OUTS;
+
   bool m_Run;
   unsigned int m_ReconnectDelay;
   Router::ROUTES m_Routes;
@@ -352,28 +552,88 @@ protected:
   EosLog m_PrivateLog;
   ItemStateTable m_ItemStateTable;
   QRecursiveMutex m_Mutex;
+  ThreadWake m_Wake;
   ScriptEngine *m_ScriptEngine = nullptr;
   psn::psn_encoder *m_PSNEncoder = nullptr;
   QElapsedTimer m_PSNEncoderTimer;
+  PSN_OUTPUTS m_PSNOutputs;
+  PSNFrameAggregator::TRACKERS m_PSNFrameTrackers;
+  std::vector<psn::tracker> m_PSNFrame;
+  PSNFrameAggregator::PREDICTION_STATS m_PSNPredictionStats;
+  PSN_TRANSFORMS m_PSNTransforms;
+  uint64_t m_TrackerFrame = 0;  // counts tracker q frames routed, tells psn transforms a new frame has started
+  size_t m_TrackerFrameBegin = 0;
+  size_t m_TrackerFrameEnd = 0;
+  OSCAddressTable m_AddressTable;
+  ADDRESSES m_Addresses;
+  OUTPUT_OPTIONS m_OutputOptions;
+  ADDR_SET m_UrgentAddrs;  // destinations of high priority routes
+  std::vector<ItemState::sOutputStats> m_OutputStats;
+  CHANGE_FILTERS m_ChangeFilters;
+  QElapsedTimer m_ChangeFilterTimer;
+  BUNDLE_OUTS m_BundleOuts;
+  size_t m_BundleOutCount = 0;
+  bool m_InBundle = false;       // routing the messages of an osc bundle
+  bool m_InFrameBundle = false;  // routing the messages of a psn frame sent as one bundle
+  uint64_t m_BundleTimeTag = 0;
+  OSCScheduler m_Scheduler;
+  OSCScheduler::EVENTS m_SchedulerEvents;
+  OSCScheduler::sStats m_SchedulerLoggedStats;
+  QElapsedTimer m_SchedulerClock;
+  QElapsedTimer m_SchedulerLogTimer;
+  StateStore m_StateStore;
 
   virtual void run();
-  virtual void BuildRoutes(ROUTES_BY_PORT &routesByPort, UDP_IN_THREADS &udpInThreads, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, TCP_SERVER_THREADS &tcpServerThreads);
+  virtual void BuildRoutes(ROUTES_BY_LANE &routesByLane, UDP_IN_THREADS &udpInThreads, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, TCP_SERVER_THREADS &tcpServerThreads);
   virtual EosUdpOutThread *CreateUdpOutThread(const EosAddr &addr, ItemStateTable::ID itemStateTableId, UDP_OUT_THREADS &udpOutThreads);
   virtual void AddRoutingDestinations(bool isOSC, const QString &path, const sRoutesByIp &routesByIp, DESTINATIONS_LIST &destinations);
-  virtual void ProcessRecvQ(OSCParser &oscBundleParser, ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads,
-                            const EosAddr &addr, EosUdpInThread::RECV_Q &recvQ);
+  virtual void AddRoutingDestinations(sAddress *address, const sRoutesByIp &routesByIp, DESTINATIONS_LIST &destinations);
+  virtual sAddress *InternAddress(const char *path, size_t pathLen);
+  virtual void MakeAddress(const char *path, size_t pathLen, sAddress &address);
+  virtual bool IsBundled(const sRouteDst &routeDst) const;
+  virtual void AddToBundle(const EosAddr &addr, EosUdpOutThread *udpThread, EosTcpClientThread *tcpThread, EosOutputOptions::EnumPriority priority, EosPacket &&packet);
+  virtual void FlushBundles();
+  virtual void HoldTimeTagged(const EosAddr &addr, EosUdpInThread::RECV_Q &recvQ, uint64_t nowUS);
+  virtual void ReleaseTimeTagged(INPUT_QS &inputQs, size_t &inputCount, uint64_t nowUS);
+  virtual void LogSchedulerStats();
+  virtual void ProcessRecvQ(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
+                            const EosUdpInThread::RECV_Q &recvQ);
   virtual void ProcessRecvPacket(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
-                                 bool isOSC, EosUdpInThread::sRecvPacket &recvPacket);
-  virtual bool MakeOSCPacket(const QString &srcPath, const EosRouteDst &dst, OSCArgument *args, size_t argsCount, EosPacket &packet);
-  virtual bool MakePSNPacket(EosPacket &osc, EosPacket &psn);
-  virtual void ProcessTcpConnectionQ(TCP_CLIENT_THREADS &tcpClientThreads, OSCStream::EnumFrameMode frameMode, EosTcpServerThread::CONNECTION_Q &tcpConnectionQ);
-  virtual bool ApplyTransform(OSCArgument &arg, const EosRouteDst &dst, OSCPacketWriter &packet);
-  virtual void MakeSendPath(const QString &srcPath, const QString &dstPath, const OSCArgument *args, size_t argsCount, QString &sendPath);
+                                 bool isOSC, const EosUdpInThread::sRecvPacket &recvPacket, const char *buf, size_t packetSize, const OSCPacketInfo &info);
+  virtual void ProcessTrackerQ(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
+                               const EosUdpInThread::TRACKER_Q &trackerQ);
+  virtual void ProcessTracker(ROUTES_BY_PORT &routesByPort, DESTINATIONS_LIST &routingDestinationList, UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const EosAddr &addr,
+                              const EosUdpInThread::TRACKER_Q &trackerQ, size_t index, uint32_t fieldMask);
+  virtual const PSNTracker &GetTransformedTracker(const sRouteDst &routeDst, const EosUdpInThread::TRACKER_Q &trackerQ, size_t index);
+  virtual bool TransformPSNMessage(const sRouteDst &routeDst, const char *buf, size_t size, const OSCPacketInfo &info, EosPacket &osc, OSCPacketInfo &oscInfo);
+  virtual bool MakeTrackerOSC(const PSNTracker &tracker, uint32_t fieldMask, EosPacket &osc, OSCPacketInfo &oscInfo);
+  virtual void FindRoutingDestinations(ROUTES_BY_PORT &routesByPort, const EosAddr &addr, unsigned int senderIp, bool isOSC, sAddress &address, DESTINATIONS_LIST &routingDestinationList);
+  virtual void RouteToDestination(UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const sRouteDst &routeDst, const sAddress &address, bool isOSC, const OSCArgsView &args,
+                                  unsigned int senderIp, const EosPacket &packet);
+  virtual bool RouteTrackerToDestination(UDP_OUT_THREADS &udpOutThreads, TCP_CLIENT_THREADS &tcpClientThreads, const sRouteDst &routeDst, const PSNTracker &tracker, uint32_t fieldMask,
+                                         unsigned int senderIp);
+  virtual bool MakeOSCPacket(const sAddress &srcAddress, const EosRouteDst &dst, const OSCArgsView &args, EosPacket &packet, OSCPacketInfo &packetInfo);
+  virtual bool MakePSNPacket(const EosPacket &osc, const OSCPacketInfo &oscInfo, EosPacket &psn);
+  virtual bool MakePSNPacket(const PSNTracker &tracker, uint32_t fieldMask, EosPacket &psn);
+  virtual void UpdatePSNOutput(const EosAddr &addr, const EosOutputOptions &options, const PSNTracker &tracker, uint32_t fieldMask);
+  virtual void FlushPSNOutputs(UDP_OUT_THREADS &udpOutThreads, uint64_t nowUS);
+  virtual void LogPSNPredictionStats();
+  virtual void ClearPSNOutputs();
+  virtual bool PassChangeFilter(const sRouteDst &routeDst, unsigned int senderIp, const EosPacket &packet, const OSCPacketInfo &packetInfo);
+  virtual void UpdateState(EosTcpClientThread &thread, const EosPacket &packet, const OSCPacketInfo &packetInfo);
+  virtual void ReplayState(EosTcpClientThread &thread);
+  virtual bool IsUrgentAddr(const EosAddr &addr) const;
+  virtual void ProcessTcpConnectionQ(TCP_CLIENT_THREADS &tcpClientThreads, OSCStream::EnumFrameMode frameMode, const EosOutputOptions &options, EosTcpServerThread::CONNECTION_Q &tcpConnectionQ);
+  virtual bool ApplyTransform(const OSCArgView &arg, const EosRouteDst &dst, OSCBufferWriter &packet);
+  virtual void MakeSendPath(const sAddress &srcAddress, const QString &dstPath, const OSCArgsView &args, QString &sendPath);
   virtual void UpdateLog();
   virtual void SetItemState(ItemStateTable::ID id, ItemState::EnumState state);
   virtual void SetItemActivity(ItemStateTable::ID id);
+  virtual void SetItemOutputStats(ItemStateTable::ID id, const ItemState::sOutputStats &stats);
   virtual void OSCParserClient_Log(const std::string &message);
   virtual void OSCParserClient_Send(const char *buf, size_t size);
+
+  static const size_t sm_Max_Datagram_Size;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,437 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SimdUtils.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_UTILS_X86
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_UTILS_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_UTILS_AVX2
+#define SIMD_UTILS_AVX2_FUNC
+#elif defined(__GNUC__)
+#include <immintrin.h>
+#define SIMD_UTILS_AVX2
+#define SIMD_UTILS_AVX2_FUNC __attribute__((target("avx2")))
+#endif
+#ifdef SIMD_UTILS_SSE2
+#include <emmintrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+#define SIMD_UTILS_NEON
+#include <arm_neon.h>
+#endif
+
+// must be last include
+#include "LeakWatcher.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+inline uint32_t ByteSwap32(uint32_t n)
+{
+#ifdef _MSC_VER
+  return _byteswap_ulong(n);
+#else
+  return __builtin_bswap32(n);
+#endif
+}
+
+inline uint64_t ByteSwap64(uint64_t n)
+{
+#ifdef _MSC_VER
+  return _byteswap_uint64(n);
+#else
+  return __builtin_bswap64(n);
+#endif
+}
+
+inline void SwapBytes32_Run(const char *s, char *d, size_t count)
+{
+  for (size_t i = 0; i < count; ++i, s += 4, d += 4)
+  {
+    uint32_t n;
+    memcpy(&n, s, 4);
+    n = ByteSwap32(n);
+    memcpy(d, &n, 4);
+  }
+}
+
+inline void SwapBytes64_Run(const char *s, char *d, size_t count)
+{
+  for (size_t i = 0; i < count; ++i, s += 8, d += 8)
+  {
+    uint64_t n;
+    memcpy(&n, s, 8);
+    n = ByteSwap64(n);
+    memcpy(d, &n, 8);
+  }
+}
+
+inline unsigned int CountTrailingZeros(unsigned int n)
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+  _BitScanForward(&index, n);
+  return static_cast<unsigned int>(index);
+#else
+  return static_cast<unsigned int>(__builtin_ctz(n));
+#endif
+}
+
+#ifdef SIMD_UTILS_SSE2
+
+// SSE2 has no byte shuffle, so swap bytes within 16-bit words then reorder the words
+inline __m128i SwapBytes32_SSE2(__m128i v)
+{
+  v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+inline __m128i SwapBytes64_SSE2(__m128i v)
+{
+  v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+  return _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+#endif
+
+#ifdef SIMD_UTILS_AVX2
+
+SIMD_UTILS_AVX2_FUNC size_t SwapBytes_AVX2(const char *src, char *dst, size_t size, bool swap64)
+{
+  const __m256i mask32 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  const __m256i mask64 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  const __m256i mask = (swap64 ? mask64 : mask32);
+
+  size_t i = 0;
+  for (; (i + 32) <= size; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(v, mask));
+  }
+
+  return i;
+}
+
+SIMD_UTILS_AVX2_FUNC size_t Extrapolate_AVX2(const float *pos, const float *speed, const float *accel, const float *dt, float *out, size_t count)
+{
+  const __m256 half = _mm256_set1_ps(0.5f);
+
+  size_t i = 0;
+  for (; (i + 8) <= count; i += 8)
+  {
+    __m256 t = _mm256_loadu_ps(dt + i);
+    __m256 v = _mm256_add_ps(_mm256_loadu_ps(speed + i), _mm256_mul_ps(_mm256_mul_ps(t, half), _mm256_loadu_ps(accel + i)));
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(pos + i), _mm256_mul_ps(t, v)));
+  }
+
+  return i;
+}
+
+SIMD_UTILS_AVX2_FUNC size_t TransformAffine_AVX2(const float *matrix, float *x, float *y, float *z, const float *w, size_t count)
+{
+  __m256 m[12];
+  for (int j = 0; j < 12; ++j)
+    m[j] = _mm256_set1_ps(matrix[j]);
+
+  size_t i = 0;
+  for (; (i + 8) <= count; i += 8)
+  {
+    __m256 vx = _mm256_loadu_ps(x + i);
+    __m256 vy = _mm256_loadu_ps(y + i);
+    __m256 vz = _mm256_loadu_ps(z + i);
+    __m256 vw = _mm256_loadu_ps(w + i);
+    _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0], vx), _mm256_mul_ps(m[1], vy)), _mm256_add_ps(_mm256_mul_ps(m[2], vz), _mm256_mul_ps(m[3], vw))));
+    _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[4], vx), _mm256_mul_ps(m[5], vy)), _mm256_add_ps(_mm256_mul_ps(m[6], vz), _mm256_mul_ps(m[7], vw))));
+    _mm256_storeu_ps(z + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[8], vx), _mm256_mul_ps(m[9], vy)), _mm256_add_ps(_mm256_mul_ps(m[10], vz), _mm256_mul_ps(m[11], vw))));
+  }
+
+  return i;
+}
+
+bool DetectAVX2()
+{
+#ifdef _MSC_VER
+  int info[4] = {0};
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+
+  __cpuid(info, 1);
+  bool osxsave = ((info[2] & (1 << 27)) != 0);
+  bool avx = ((info[2] & (1 << 28)) != 0);
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    return false;
+
+  __cpuidex(info, 7, 0);
+  return ((info[1] & (1 << 5)) != 0);
+#else
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("avx2") != 0);
+#endif
+}
+
+#endif
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SimdUtils::HasAVX2()
+{
+#ifdef SIMD_UTILS_AVX2
+  static const bool hasAVX2 = DetectAVX2();
+  return hasAVX2;
+#else
+  return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::SwapBytes32_Scalar(const void *src, void *dst, size_t count)
+{
+  SwapBytes32_Run(static_cast<const char *>(src), static_cast<char *>(dst), count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::SwapBytes64_Scalar(const void *src, void *dst, size_t count)
+{
+  SwapBytes64_Run(static_cast<const char *>(src), static_cast<char *>(dst), count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::SwapBytes32(const void *src, void *dst, size_t count)
+{
+  // short runs never reach the vector setup
+  if (count < sm_Min_Swap32_Count)
+    SwapBytes32_Run(static_cast<const char *>(src), static_cast<char *>(dst), count);
+  else
+    SwapBytes32_Simd(static_cast<const char *>(src), static_cast<char *>(dst), count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::SwapBytes32_Simd(const char *s, char *d, size_t count)
+{
+  size_t size = (count * 4);
+  size_t i = 0;
+
+#ifdef SIMD_UTILS_AVX2
+  if (size >= 64 && HasAVX2())
+    i = SwapBytes_AVX2(s, d, size, /*swap64*/ false);
+#endif
+
+#ifdef SIMD_UTILS_SSE2
+  for (; (i + 16) <= size; i += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), SwapBytes32_SSE2(v));
+  }
+#elif defined(SIMD_UTILS_NEON)
+  for (; (i + 16) <= size; i += 16)
+    vst1q_u8(reinterpret_cast<uint8_t *>(d + i), vrev32q_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(s + i))));
+#endif
+
+  SwapBytes32_Run(s + i, d + i, (size - i) / 4);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::SwapBytes64(const void *src, void *dst, size_t count)
+{
+  // short runs never reach the vector setup
+  if (count < sm_Min_Swap64_Count)
+    SwapBytes64_Run(static_cast<const char *>(src), static_cast<char *>(dst), count);
+  else
+    SwapBytes64_Simd(static_cast<const char *>(src), static_cast<char *>(dst), count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::SwapBytes64_Simd(const char *s, char *d, size_t count)
+{
+  size_t size = (count * 8);
+  size_t i = 0;
+
+#ifdef SIMD_UTILS_AVX2
+  if (size >= 64 && HasAVX2())
+    i = SwapBytes_AVX2(s, d, size, /*swap64*/ true);
+#endif
+
+#ifdef SIMD_UTILS_SSE2
+  for (; (i + 16) <= size; i += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), SwapBytes64_SSE2(v));
+  }
+#elif defined(SIMD_UTILS_NEON)
+  for (; (i + 16) <= size; i += 16)
+    vst1q_u8(reinterpret_cast<uint8_t *>(d + i), vrev64q_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(s + i))));
+#endif
+
+  SwapBytes64_Run(s + i, d + i, (size - i) / 8);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char *SimdUtils::FindByte(const char *data, size_t size, char c)
+{
+  if (!data)
+    return nullptr;
+
+  size_t i = 0;
+
+#ifdef SIMD_UTILS_SSE2
+  const __m128i needle = _mm_set1_epi8(c);
+  for (; (i + 16) <= size; i += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+    if (mask != 0)
+      return (data + i + CountTrailingZeros(mask));
+  }
+#elif defined(SIMD_UTILS_NEON)
+  const uint8x16_t needle = vdupq_n_u8(static_cast<uint8_t>(c));
+  for (; (i + 16) <= size; i += 16)
+  {
+    uint8x16_t eq = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(data + i)), needle);
+    uint64x2_t halves = vreinterpretq_u64_u8(eq);
+    if ((vgetq_lane_u64(halves, 0) | vgetq_lane_u64(halves, 1)) != 0)
+      break;  // found in this block, scalar scan below pins it down
+  }
+#endif
+
+  for (; i < size; ++i)
+  {
+    if (data[i] == c)
+      return (data + i);
+  }
+
+  return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::Extrapolate_Scalar(const float *pos, const float *speed, const float *accel, const float *dt, float *out, size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+    out[i] = (pos[i] + dt[i] * (speed[i] + dt[i] * 0.5f * accel[i]));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::Extrapolate(const float *pos, const float *speed, const float *accel, const float *dt, float *out, size_t count)
+{
+  size_t i = 0;
+
+#ifdef SIMD_UTILS_AVX2
+  if (count >= 8 && HasAVX2())
+    i = Extrapolate_AVX2(pos, speed, accel, dt, out, count);
+#endif
+
+#ifdef SIMD_UTILS_SSE2
+  const __m128 half = _mm_set1_ps(0.5f);
+  for (; (i + 4) <= count; i += 4)
+  {
+    __m128 t = _mm_loadu_ps(dt + i);
+    __m128 v = _mm_add_ps(_mm_loadu_ps(speed + i), _mm_mul_ps(_mm_mul_ps(t, half), _mm_loadu_ps(accel + i)));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(pos + i), _mm_mul_ps(t, v)));
+  }
+#elif defined(SIMD_UTILS_NEON)
+  for (; (i + 4) <= count; i += 4)
+  {
+    float32x4_t t = vld1q_f32(dt + i);
+    float32x4_t v = vaddq_f32(vld1q_f32(speed + i), vmulq_f32(vmulq_n_f32(t, 0.5f), vld1q_f32(accel + i)));
+    vst1q_f32(out + i, vaddq_f32(vld1q_f32(pos + i), vmulq_f32(t, v)));
+  }
+#endif
+
+  Extrapolate_Scalar(pos + i, speed + i, accel + i, dt + i, out + i, count - i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::TransformAffine_Scalar(const float *matrix, float *x, float *y, float *z, const float *w, size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    float vx = x[i];
+    float vy = y[i];
+    float vz = z[i];
+    x[i] = (matrix[0] * vx + matrix[1] * vy + matrix[2] * vz + matrix[3] * w[i]);
+    y[i] = (matrix[4] * vx + matrix[5] * vy + matrix[6] * vz + matrix[7] * w[i]);
+    z[i] = (matrix[8] * vx + matrix[9] * vy + matrix[10] * vz + matrix[11] * w[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimdUtils::TransformAffine(const float *matrix, float *x, float *y, float *z, const float *w, size_t count)
+{
+  size_t i = 0;
+
+#ifdef SIMD_UTILS_AVX2
+  if (count >= 8 && HasAVX2())
+    i = TransformAffine_AVX2(matrix, x, y, z, w, count);
+#endif
+
+#ifdef SIMD_UTILS_SSE2
+  __m128 m[12];
+  for (int j = 0; j < 12; ++j)
+    m[j] = _mm_set1_ps(matrix[j]);
+
+  for (; (i + 4) <= count; i += 4)
+  {
+    __m128 vx = _mm_loadu_ps(x + i);
+    __m128 vy = _mm_loadu_ps(y + i);
+    __m128 vz = _mm_loadu_ps(z + i);
+    __m128 vw = _mm_loadu_ps(w + i);
+    _mm_storeu_ps(x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], vx), _mm_mul_ps(m[1], vy)), _mm_add_ps(_mm_mul_ps(m[2], vz), _mm_mul_ps(m[3], vw))));
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[4], vx), _mm_mul_ps(m[5], vy)), _mm_add_ps(_mm_mul_ps(m[6], vz), _mm_mul_ps(m[7], vw))));
+    _mm_storeu_ps(z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[8], vx), _mm_mul_ps(m[9], vy)), _mm_add_ps(_mm_mul_ps(m[10], vz), _mm_mul_ps(m[11], vw))));
+  }
+#elif defined(SIMD_UTILS_NEON)
+  for (; (i + 4) <= count; i += 4)
+  {
+    float32x4_t vx = vld1q_f32(x + i);
+    float32x4_t vy = vld1q_f32(y + i);
+    float32x4_t vz = vld1q_f32(z + i);
+    float32x4_t vw = vld1q_f32(w + i);
+    vst1q_f32(x + i, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, matrix[0]), vy, matrix[1]), vz, matrix[2]), vw, matrix[3]));
+    vst1q_f32(y + i, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, matrix[4]), vy, matrix[5]), vz, matrix[6]), vw, matrix[7]));
+    vst1q_f32(z + i, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vx, matrix[8]), vy, matrix[9]), vz, matrix[10]), vw, matrix[11]));
+  }
+#endif
+
+  TransformAffine_Scalar(matrix, x + i, y + i, z + i, w + i, count - i);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef SIMD_UTILS_H
+#define SIMD_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// vectorized helpers for the packet hot paths, with a scalar fallback on every platform
+// AVX2 is selected at runtime, SSE2 and NEON at compile time
+class SimdUtils
+{
+public:
+  // reverse the byte order of count consecutive 4 or 8 byte values, src and dst may be the same buffer
+  static void SwapBytes32(const void *src, void *dst, size_t count);
+  static void SwapBytes64(const void *src, void *dst, size_t count);
+
+  static void SwapBytes32_Scalar(const void *src, void *dst, size_t count);
+  static void SwapBytes64_Scalar(const void *src, void *dst, size_t count);
+
+  // shorter runs are swapped one value at a time, vector setup costs more than it saves on a PSN xyz
+  static const size_t sm_Min_Swap32_Count = 32;
+  static const size_t sm_Min_Swap64_Count = 32;
+
+  // first occurrence of c in data, or nullptr
+  static const char *FindByte(const char *data, size_t size, char c);
+
+  // out[i] = pos[i] + dt[i] * (speed[i] + dt[i] * accel[i] / 2), arrays hold one axis of count trackers, out may be pos
+  static void Extrapolate(const float *pos, const float *speed, const float *accel, const float *dt, float *out, size_t count);
+  static void Extrapolate_Scalar(const float *pos, const float *speed, const float *accel, const float *dt, float *out, size_t count);
+
+  // x, y and z hold one axis of count vectors each and are transformed in place by a row major 3x4 affine matrix,
+  // its translation column is scaled by w[i]: 1 for points, 0 for directions
+  static void TransformAffine(const float *matrix, float *x, float *y, float *z, const float *w, size_t count);
+  static void TransformAffine_Scalar(const float *matrix, float *x, float *y, float *z, const float *w, size_t count);
+
+  static bool HasAVX2();
+
+private:
+  static void SwapBytes32_Simd(const char *s, char *d, size_t count);
+  static void SwapBytes64_Simd(const char *s, char *d, size_t count);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
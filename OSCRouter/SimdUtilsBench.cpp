@@ -0,0 +1,102 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Standalone benchmark of the SimdUtils byte swap kernels against the scalar path, not part of the app build:
+//   g++ -O2 -std=c++17 SimdUtilsBench.cpp SimdUtils.cpp -o SimdUtilsBench && ./SimdUtilsBench
+//   cl /O2 /EHsc SimdUtilsBench.cpp SimdUtils.cpp
+// Run lengths match OSC argument runs, from a single float3 up to a large blob of values.
+// Exits with 1 if a kernel does not match the scalar path.
+
+#include "SimdUtils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+typedef void (*SWAP_FUNC)(const void *src, void *dst, size_t count);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// nanoseconds per value, best of several rounds so a single preemption does not count
+double TimeSwap(SWAP_FUNC swap, const std::vector<unsigned char> &src, std::vector<unsigned char> &dst, size_t count)
+{
+  size_t repeat = ((1 << 24) / (count + 8));
+  double best = 0;
+  for (int round = 0; round < 5; ++round)
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repeat; ++i)
+      swap(src.data(), dst.data(), count);
+    std::chrono::duration<double, std::nano> elapsed = (std::chrono::steady_clock::now() - start);
+    double ns = (elapsed.count() / static_cast<double>(repeat * count));
+    if (round == 0 || ns < best)
+      best = ns;
+  }
+
+  return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool BenchSwap(const char *name, size_t valueSize, SWAP_FUNC swap, SWAP_FUNC swapScalar)
+{
+  static const size_t sizes[] = {3, 8, 16, 64, 256, 4096};
+
+  bool ok = true;
+  printf("%s\n", name);
+  printf("  %8s %12s %12s %8s\n", "values", "scalar ns", "simd ns", "speedup");
+  for (size_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); ++i)
+  {
+    size_t count = sizes[i];
+    std::vector<unsigned char> src(count * valueSize);
+    for (size_t j = 0; j < src.size(); ++j)
+      src[j] = static_cast<unsigned char>(j * 7 + 1);
+    std::vector<unsigned char> dst(src.size());
+    std::vector<unsigned char> expected(src.size());
+
+    swapScalar(src.data(), expected.data(), count);
+    swap(src.data(), dst.data(), count);
+    if (memcmp(dst.data(), expected.data(), dst.size()) != 0)
+    {
+      printf("  %8zu mismatch\n", count);
+      ok = false;
+      continue;
+    }
+
+    double scalarNS = TimeSwap(swapScalar, src, dst, count);
+    double simdNS = TimeSwap(swap, src, dst, count);
+    printf("  %8zu %12.3f %12.3f %7.2fx\n", count, scalarNS, simdNS, (simdNS > 0) ? (scalarNS / simdNS) : 0.0);
+  }
+
+  return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+  printf("AVX2 %s\n", SimdUtils::HasAVX2() ? "available" : "not available");
+
+  bool ok = BenchSwap("SwapBytes32 (int32, float32)", 4, SimdUtils::SwapBytes32, SimdUtils::SwapBytes32_Scalar);
+  ok = (BenchSwap("SwapBytes64 (int64, double)", 8, SimdUtils::SwapBytes64, SimdUtils::SwapBytes64_Scalar) && ok);
+
+  return (ok ? 0 : 1);
+}
@@ -0,0 +1,259 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "TimerWheel.h"
+
+// must be last include
+#include "LeakWatcher.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+const uint64_t TimerWheel::sm_Default_Tick_US = 100;
+const uint32_t TimerWheel::sm_Invalid_Node = 0xffffffff;
+
+////////////////////////////////////////////////////////////////////////////////
+
+TimerWheel::TimerWheel(uint64_t tickUS, uint64_t nowUS)
+  : m_TickUS((tickUS == 0) ? 1 : tickUS)
+{
+  m_Tick = (nowUS / m_TickUS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimerWheel::Clear(uint64_t nowUS)
+{
+  m_Tick = (nowUS / m_TickUS);
+  m_Count = 0;
+  m_Nodes.clear();
+  m_Free = sm_Invalid_Node;
+
+  for (size_t level = 0; level < LEVELS; ++level)
+  {
+    for (size_t slot = 0; slot < SLOTS; ++slot)
+      m_Slots[level][slot] = sSlot();
+  }
+
+  m_Overdue = sSlot();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimerWheel::Add(uint64_t dueUS, uint64_t data)
+{
+  uint32_t node = m_Free;
+  if (node == sm_Invalid_Node)
+  {
+    node = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.emplace_back();
+  }
+  else
+    m_Free = m_Nodes[node].next;
+
+  sNode &n = m_Nodes[node];
+  n.timer.dueUS = dueUS;
+  n.timer.data = data;
+  n.tick = ((dueUS + m_TickUS - 1) / m_TickUS);  // never expire early
+  Insert(node);
+  ++m_Count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimerWheel::Insert(uint32_t node)
+{
+  sNode &n = m_Nodes[node];
+  n.next = sm_Invalid_Node;
+
+  uint64_t tick = n.tick;
+  if (tick < m_Tick)
+  {
+    Append(m_Overdue, node);
+    return;
+  }
+
+  // lowest level whose span from the current tick still covers the timer
+  size_t level = 0;
+  for (; level < (LEVELS - 1); ++level)
+  {
+    size_t shift = (level * SLOT_BITS);
+    if (((tick >> shift) - (m_Tick >> shift)) < SLOTS)
+      break;
+  }
+
+  size_t shift = (level * SLOT_BITS);
+  if (((tick >> shift) - (m_Tick >> shift)) >= SLOTS)
+  {
+    // beyond the top level, park in its furthest slot and re-insert when that slot cascades
+    tick = (((m_Tick >> shift) + (SLOTS - 1)) << shift);
+  }
+
+  Append(m_Slots[level][(tick >> shift) & SLOT_MASK], node);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimerWheel::Append(sSlot &slot, uint32_t node)
+{
+  if (slot.tail == sm_Invalid_Node)
+    slot.head = node;
+  else
+    m_Nodes[slot.tail].next = node;
+  slot.tail = node;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t TimerWheel::Expire(sSlot &slot, TIMERS &expired)
+{
+  size_t count = 0;
+  uint32_t node = slot.head;
+  slot = sSlot();
+
+  while (node != sm_Invalid_Node)
+  {
+    sNode &n = m_Nodes[node];
+    expired.push_back(n.timer);
+    ++count;
+
+    uint32_t next = n.next;
+    n.next = m_Free;
+    m_Free = node;
+    node = next;
+  }
+
+  m_Count -= count;
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimerWheel::Cascade(size_t level)
+{
+  size_t shift = (level * SLOT_BITS);
+  sSlot &slot = m_Slots[level][(m_Tick >> shift) & SLOT_MASK];
+  uint32_t node = slot.head;
+  slot = sSlot();
+
+  while (node != sm_Invalid_Node)
+  {
+    uint32_t next = m_Nodes[node].next;
+    Insert(node);
+    node = next;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t TimerWheel::Advance(uint64_t nowUS, TIMERS &expired)
+{
+  uint64_t now = (nowUS / m_TickUS);
+  size_t count = Expire(m_Overdue, expired);
+
+  while (m_Count != 0 && m_Tick <= now)
+  {
+    sSlot &slot = m_Slots[0][m_Tick & SLOT_MASK];
+    if (slot.head == sm_Invalid_Node)
+    {
+      // jump over empty slots, no higher level slot comes due before the next timer could
+      uint64_t dueUS = 0;
+      GetNextDue(dueUS);
+      uint64_t tick = (dueUS / m_TickUS);
+      if (tick > m_Tick)
+      {
+        if (tick > now)
+        {
+          m_Tick = (now + 1);
+          CascadeAt(m_Tick);
+          break;
+        }
+
+        m_Tick = tick;
+        CascadeAt(m_Tick);
+        continue;
+      }
+    }
+
+    count += Expire(slot, expired);
+    ++m_Tick;
+    CascadeAt(m_Tick);
+  }
+
+  // nothing left to expire, skip idle time
+  if (m_Tick <= now)
+    m_Tick = (now + 1);
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimerWheel::CascadeAt(uint64_t tick)
+{
+  // refill lower levels as each higher level slot comes due
+  for (size_t level = 1; level < LEVELS; ++level)
+  {
+    if ((tick & ((static_cast<uint64_t>(1) << (level * SLOT_BITS)) - 1)) != 0)
+      break;
+    Cascade(level);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TimerWheel::GetNextDue(uint64_t &dueUS) const
+{
+  if (m_Count == 0)
+    return false;
+
+  if (m_Overdue.head != sm_Invalid_Node)
+  {
+    dueUS = m_Nodes[m_Overdue.head].timer.dueUS;
+    return true;
+  }
+
+  // a higher level slot can start before the last slots of the level below it, so check every level
+  uint64_t next = UINT64_MAX;
+  for (size_t level = 0; level < LEVELS; ++level)
+  {
+    size_t shift = (level * SLOT_BITS);
+    uint64_t base = (m_Tick >> shift);
+    for (uint64_t i = ((level == 0) ? 0 : 1); i < SLOTS; ++i)
+    {
+      if (m_Slots[level][(base + i) & SLOT_MASK].head != sm_Invalid_Node)
+      {
+        uint64_t tick = ((base + i) << shift);
+        if (tick < m_Tick)
+          tick = m_Tick;
+        if (tick < next)
+          next = tick;
+        break;
+      }
+    }
+  }
+
+  if (next == UINT64_MAX)
+    next = m_Tick;
+
+  dueUS = (next * m_TickUS);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
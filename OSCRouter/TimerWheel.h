@@ -0,0 +1,101 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// hierarchical timing wheel, O(1) to add a timer and O(1) per timer to expire it
+// times are in microseconds on any monotonic clock, timers expire up to one tick late but never early
+class TimerWheel
+{
+public:
+  struct sTimer
+  {
+    uint64_t dueUS = 0;
+    uint64_t data = 0;
+  };
+
+  typedef std::vector<sTimer> TIMERS;
+
+  TimerWheel(uint64_t tickUS = sm_Default_Tick_US, uint64_t nowUS = 0);
+
+  bool empty() const { return (m_Count == 0); }
+  size_t size() const { return m_Count; }
+  uint64_t GetTickUS() const { return m_TickUS; }
+  void Clear(uint64_t nowUS = 0);
+  void Add(uint64_t dueUS, uint64_t data);
+  size_t Advance(uint64_t nowUS, TIMERS &expired);
+
+  // earliest time a timer could be due, may be early for timers far in the future
+  bool GetNextDue(uint64_t &dueUS) const;
+
+  static const uint64_t sm_Default_Tick_US;
+
+private:
+  enum EnumConstants
+  {
+    SLOT_BITS = 6,
+    SLOTS = (1 << SLOT_BITS),
+    SLOT_MASK = (SLOTS - 1),
+    LEVELS = 4
+  };
+
+  struct sNode
+  {
+    sTimer timer;
+    uint64_t tick = 0;
+    uint32_t next = 0;
+  };
+
+  struct sSlot
+  {
+    uint32_t head = sm_Invalid_Node;
+    uint32_t tail = sm_Invalid_Node;
+  };
+
+  typedef std::vector<sNode> NODES;
+
+  uint64_t m_TickUS;
+  uint64_t m_Tick = 0;  // next tick to expire
+  size_t m_Count = 0;
+  NODES m_Nodes;
+  uint32_t m_Free = sm_Invalid_Node;
+  sSlot m_Slots[LEVELS][SLOTS];
+  sSlot m_Overdue;  // added after their tick had already expired
+
+  void Insert(uint32_t node);
+  void Append(sSlot &slot, uint32_t node);
+  size_t Expire(sSlot &slot, TIMERS &expired);
+  void Cascade(size_t level);
+  void CascadeAt(uint64_t tick);
+
+  static const uint32_t sm_Invalid_Node;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
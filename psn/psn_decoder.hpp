@@ -32,11 +32,86 @@
 #include <functional>
 #include <map>
 #include <string>
+#include <vector>
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 namespace psn
 {
 
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// tracker_store
+// Flat alternative to tracker_map: each field lives in its own array indexed by 
+// tracker id. Frames are decoded into pending arrays and the trackers of a frame 
+// are copied to the committed arrays when it completes, so the last complete 
+// frame stays as it was while the next one is decoded, even when both happen in 
+// one packet. A tracker's field mask only counts while its stamp matches the 
+// frame, so nothing is cleared between frames, and once every id has been seen 
+// decoding allocates nothing.
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+class tracker_store
+{
+public:
+    typedef ::std::vector< uint16_t >::const_iterator const_iterator ;
+
+    tracker_store( void ) ;
+
+    void reserve( size_t tracker_count ) ;
+
+    // Ids of the trackers in the last complete frame, in the order they were decoded
+    const_iterator begin( void ) const { return updated_.begin() ; }
+    const_iterator end( void ) const { return updated_.end() ; }
+    size_t updated_count( void ) const { return updated_.size() ; }
+
+    // Field ids are the DATA_TRACKER_ chunk ids
+    uint32_t get_fields( uint16_t id ) const { return ( id < committed_stamps_.size() && committed_stamps_[ id ] == committed_generation_ ) ? committed_.fields[ id ] : 0 ; }
+    bool is_field_set( uint16_t id , uint16_t field ) const { return ( get_fields( id ) & ( 1 << field ) ) != 0 ; }
+
+    const float3 & get_pos( uint16_t id ) const { return committed_.pos[ id ] ; }
+    const float3 & get_speed( uint16_t id ) const { return committed_.speed[ id ] ; }
+    const float3 & get_ori( uint16_t id ) const { return committed_.ori[ id ] ; }
+    float get_status( uint16_t id ) const { return committed_.status[ id ] ; }
+    const float3 & get_accel( uint16_t id ) const { return committed_.accel[ id ] ; }
+    const float3 & get_target_pos( uint16_t id ) const { return committed_.target_pos[ id ] ; }
+    uint64_t get_timestamp( uint16_t id ) const { return committed_.timestamp[ id ] ; }
+
+private:
+    friend class psn_decoder ;
+
+    struct values_t
+    {
+        void reserve( size_t tracker_count ) ;
+        void resize( size_t tracker_count ) ;
+        void copy( uint16_t id , const values_t & other ) ;
+
+        ::std::vector< float3 > pos ;
+        ::std::vector< float3 > speed ;
+        ::std::vector< float3 > ori ;
+        ::std::vector< float > status ;
+        ::std::vector< float3 > accel ;
+        ::std::vector< float3 > target_pos ;
+        ::std::vector< uint64_t > timestamp ;
+        ::std::vector< uint32_t > fields ;
+    } ;
+
+    void begin_frame( void ) ;
+    void end_frame( void ) ;
+    void begin_tracker( uint16_t id ) ;
+    void set_field( uint16_t id , uint16_t field ) { pending_values_.fields[ id ] |= 1 << field ; }
+
+    static void next_generation( uint32_t & generation , ::std::vector< uint32_t > & stamps ) ;
+
+    values_t pending_values_ ;
+    ::std::vector< uint32_t > pending_stamps_ ;
+    ::std::vector< uint16_t > pending_ ;
+    uint32_t generation_ ;
+
+    values_t committed_ ;
+    ::std::vector< uint32_t > committed_stamps_ ;
+    ::std::vector< uint16_t > updated_ ;
+    uint32_t committed_generation_ ;
+} ;
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 class psn_decoder
 {
 public:
@@ -53,13 +128,37 @@ public:
         tracker_map trackers ;
     } ;
 
+    struct stats_t
+    {
+        stats_t( void ) : data_frames( 0 ) , incomplete_frames( 0 ) , duplicate_frames( 0 ) , duplicate_packets( 0 ) {}
+
+        uint64_t data_frames ;          // complete data frames, get_data() changes with each one
+        uint64_t incomplete_frames ;    // data frames replaced by a new frame before all their packets arrived
+        uint64_t duplicate_frames ;     // data packets of the frame just completed, ignored
+        uint64_t duplicate_packets ;    // data packets identical to one already decoded in the same frame, ignored
+    } ;
+
+    enum mode_t
+    {
+        MODE_TRACKER_MAP ,    // data_t::trackers holds the trackers of the last frame
+        MODE_TRACKER_STORE    // get_tracker_store() does, data_t::trackers is left empty
+    } ;
+
+    // Called each time a data frame is committed, while get_data() and get_tracker_store() 
+    // hold it. One decode() can commit two frames when a frame is closed early
+    typedef ::std::function< void( const psn_decoder & ) > frame_handler_t ;
+
 public :
-    psn_decoder( void ) ;
+    psn_decoder( mode_t mode = MODE_TRACKER_MAP ) ;
 
     bool decode( const char * packet , size_t packet_size ) ;
 
     const info_t & get_info( void ) const { return info_ ; }
     const data_t & get_data( void ) const { return data_ ; }
+    const tracker_store & get_tracker_store( void ) const { return tracker_store_ ; }
+    const stats_t & get_stats( void ) const { return stats_ ; }
+
+    void set_frame_handler( const frame_handler_t & handler ) { frame_handler_ = handler ; }
 
 private:
     typedef ::psn::packet< const char > packet_t ;
@@ -76,6 +175,9 @@ private:
     bool decode_data_header( packet_t packet ) ;
     bool decode_data_tracker_list( packet_t packet , const chunk_header & header ) ;
     bool decode_data_tracker( packet_t packet , const chunk_header & header ) ;
+    bool decode_data_tracker_to_store( packet_t packet , const chunk_header & header ) ;
+    bool place_data_packet( packet_t packet , const chunk_header & header ) ;
+    void commit_data( void ) ;
 
     // Generic
     template< typename type >
@@ -84,6 +186,8 @@ private:
     bool decode_children( packet_t packet , const chunk_header & header , const decode_child_t & decode_child ) ;
 
 private:
+    mode_t mode_ ;
+
     size_t info_packet_count_ ;
     info_t info_ ;
     info_t info_to_commit_ ;
@@ -91,6 +195,11 @@ private:
     size_t data_packet_count_ ;
     data_t data_ ;
     data_t data_to_commit_ ;
+    uint32_t data_packet_hashes_[ 256 ] ; // packets of data_to_commit_, frame_packet_count is 8 bits
+
+    tracker_store tracker_store_ ;
+    stats_t stats_ ;
+    frame_handler_t frame_handler_ ;
 } ;
 
 } // namespace psn
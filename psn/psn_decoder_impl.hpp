@@ -34,10 +34,145 @@
 namespace psn
 {
     
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::values_t::
+reserve( size_t tracker_count )
+{
+    pos.reserve( tracker_count ) ;
+    speed.reserve( tracker_count ) ;
+    ori.reserve( tracker_count ) ;
+    status.reserve( tracker_count ) ;
+    accel.reserve( tracker_count ) ;
+    target_pos.reserve( tracker_count ) ;
+    timestamp.reserve( tracker_count ) ;
+    fields.reserve( tracker_count ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::values_t::
+resize( size_t tracker_count )
+{
+    pos.resize( tracker_count ) ;
+    speed.resize( tracker_count ) ;
+    ori.resize( tracker_count ) ;
+    status.resize( tracker_count , 0 ) ;
+    accel.resize( tracker_count ) ;
+    target_pos.resize( tracker_count ) ;
+    timestamp.resize( tracker_count , 0 ) ;
+    fields.resize( tracker_count , 0 ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::values_t::
+copy( uint16_t id , const values_t & other )
+{
+    pos[ id ] = other.pos[ id ] ;
+    speed[ id ] = other.speed[ id ] ;
+    ori[ id ] = other.ori[ id ] ;
+    status[ id ] = other.status[ id ] ;
+    accel[ id ] = other.accel[ id ] ;
+    target_pos[ id ] = other.target_pos[ id ] ;
+    timestamp[ id ] = other.timestamp[ id ] ;
+    fields[ id ] = other.fields[ id ] ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+tracker_store::
+tracker_store( void )
+    : generation_( 0 )
+    , committed_generation_( 0 )
+{
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::
+reserve( size_t tracker_count )
+{
+    pending_values_.reserve( tracker_count ) ;
+    pending_stamps_.reserve( tracker_count ) ;
+    pending_.reserve( tracker_count ) ;
+    committed_.reserve( tracker_count ) ;
+    committed_stamps_.reserve( tracker_count ) ;
+    updated_.reserve( tracker_count ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::
+next_generation( uint32_t & generation , ::std::vector< uint32_t > & stamps )
+{
+    // Generation 0 is never current, so it is what every stamp is reset to on wrap around
+    if ( ++generation == 0 )
+    {
+        ::std::fill( stamps.begin() , stamps.end() , 0 ) ;
+        generation = 1 ;
+    }
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::
+begin_frame( void )
+{
+    pending_.clear() ;
+    next_generation( generation_ , pending_stamps_ ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::
+end_frame( void )
+{
+    // Only the trackers of the frame are copied, the others stop counting with the new generation
+    next_generation( committed_generation_ , committed_stamps_ ) ;
+    if ( committed_stamps_.size() < pending_stamps_.size() )
+    {
+        committed_.resize( pending_stamps_.size() ) ;
+        committed_stamps_.resize( pending_stamps_.size() , 0 ) ;
+    }
+
+    for ( size_t i = 0 ; i < pending_.size() ; ++i )
+    {
+        uint16_t id = pending_[ i ] ;
+        committed_.copy( id , pending_values_ ) ;
+        committed_stamps_[ id ] = committed_generation_ ;
+    }
+
+    updated_.swap( pending_ ) ;
+    pending_.clear() ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+tracker_store::
+begin_tracker( uint16_t id )
+{
+    if ( id >= pending_stamps_.size() )
+    {
+        size_t size = (size_t)id + 1 ;
+        pending_values_.resize( size ) ;
+        pending_stamps_.resize( size , 0 ) ;
+    }
+
+    if ( pending_stamps_[ id ] != generation_ )
+    {
+        pending_stamps_[ id ] = generation_ ;
+        pending_.push_back( id ) ;
+    }
+
+    // A tracker sent twice in one frame keeps only its last chunk, as in tracker_map
+    pending_values_.fields[ id ] = 0 ;
+}
+
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 psn_decoder::
-psn_decoder( void )
-    : info_packet_count_( 0 )
+psn_decoder( mode_t mode /*= MODE_TRACKER_MAP*/ )
+    : mode_( mode )
+    , info_packet_count_( 0 )
     , data_packet_count_( 0 )
 {
 }
@@ -146,6 +281,9 @@ bool
 psn_decoder::
 decode_data( packet_t packet , const chunk_header & header )
 {
+    if ( !place_data_packet( packet , header ) )
+        return true ;
+
     bool success = decode_children( packet , header ,
         [this]( packet_t packet , const chunk_header & child_header )
         {
@@ -158,11 +296,7 @@ decode_data( packet_t packet , const chunk_header & header )
         } ) ;
 
     if ( ++data_packet_count_ >= data_to_commit_.header.frame_packet_count )
-    {
-        data_ = ::std::move( data_to_commit_ ) ;
-        data_to_commit_.trackers.clear() ;
-        data_packet_count_ = 0 ;
-    }
+        commit_data() ;
 
     return success ;
 }
@@ -170,29 +304,101 @@ decode_data( packet_t packet , const chunk_header & header )
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 bool
 psn_decoder::
-decode_data_header( packet_t packet )
+place_data_packet( packet_t packet , const chunk_header & header )
 {
-    uint8_t last_frame_id = data_to_commit_.header.frame_id ;
-    bool expect_new_frame = ( data_packet_count_ == 0 ) ;
-                
-    if ( !decode_type( packet , data_to_commit_.header ) )
-        return false ;
-
-    // Backup solution in case frame_packet_count is bad or we missed a packet
-    if ( data_to_commit_.header.frame_id != last_frame_id && !expect_new_frame )
+    // Packets of a frame carry no index, so a packet is told apart from a copy of 
+    // one already decoded by a hash of its bytes (FNV-1a)
+    uint32_t hash = 2166136261u ;
+    size_t size = ::std::min( packet.size , (size_t)header.data_len ) ;
+    for ( size_t i = 0 ; i < size ; ++i )
+        hash = ( hash ^ (uint8_t)packet.buffer[ i ] ) * 16777619u ;
+
+    // The packet header is the first child chunk
+    packet_t header_packet = packet ;
+    auto child_header = header_packet.cast_to< const chunk_header >() ;
+    if ( child_header && child_header->id == DATA_PACKET_HEADER )
     {
-        data_ = data_to_commit_ ;
-        data_packet_count_ = 0 ;
+        header_packet.apply_offset( sizeof( chunk_header ) ) ;
+        packet_header frame_header ;
+
+        if ( decode_type( header_packet , frame_header ) )
+        {
+            if ( data_packet_count_ > 0 )
+            {
+                if ( frame_header.frame_id == data_to_commit_.header.frame_id )
+                {
+                    for ( size_t i = 0 ; i < data_packet_count_ && i < 256 ; ++i )
+                    {
+                        if ( data_packet_hashes_[ i ] == hash )
+                        {
+                            ++stats_.duplicate_packets ;
+                            return false ;
+                        }
+                    }
+                }
+                else
+                {
+                    // Backup solution in case frame_packet_count is bad or we missed a packet
+                    ++stats_.incomplete_frames ;
+                    commit_data() ;
+                }
+            }
+            else if ( stats_.data_frames != 0 && frame_header.frame_id == data_.header.frame_id )
+            {
+                ++stats_.duplicate_frames ;
+                return false ;
+            }
+        }
     }
 
+    if ( data_packet_count_ == 0 && mode_ == MODE_TRACKER_STORE )
+        tracker_store_.begin_frame() ;
+
+    if ( data_packet_count_ < 256 )
+        data_packet_hashes_[ data_packet_count_ ] = hash ;
+
     return true ;
 }
 
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void
+psn_decoder::
+commit_data( void )
+{
+    data_ = ::std::move( data_to_commit_ ) ;
+    data_to_commit_.trackers.clear() ;
+    data_packet_count_ = 0 ;
+    ++stats_.data_frames ;
+
+    if ( mode_ == MODE_TRACKER_STORE )
+        tracker_store_.end_frame() ;
+
+    if ( frame_handler_ )
+        frame_handler_( *this ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+bool
+psn_decoder::
+decode_data_header( packet_t packet )
+{
+    return decode_type( packet , data_to_commit_.header ) ;
+}
+
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 bool
 psn_decoder::
 decode_data_tracker_list( packet_t packet , const chunk_header & header )
 {
+    if ( mode_ == MODE_TRACKER_STORE )
+    {
+        return decode_children( packet , header ,
+            [this]( packet_t packet , const chunk_header & child_header )
+            {
+                return decode_data_tracker_to_store( packet , child_header ) ;
+            } ) ;
+    }
+
     return decode_children( packet , header ,
         [this]( packet_t packet , const chunk_header & child_header )
         {
@@ -226,6 +432,36 @@ decode_data_tracker( packet_t packet , const chunk_header & header )
         } ) ;
 }
 
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+bool
+psn_decoder::
+decode_data_tracker_to_store( packet_t packet , const chunk_header & header )
+{
+    uint16_t id = header.id ;
+    tracker_store_.begin_tracker( id ) ;
+
+    return decode_children( packet , header ,
+        [this , id]( packet_t packet , const chunk_header & child_header )
+        {
+            tracker_store & store = tracker_store_ ;
+            bool success = true ;
+            switch( child_header.id )
+            {
+            case DATA_TRACKER_POS:       success = decode_type( packet , store.pending_values_.pos[ id ] ) ; break ;
+            case DATA_TRACKER_SPEED:     success = decode_type( packet , store.pending_values_.speed[ id ] ) ; break ;
+            case DATA_TRACKER_ORI:       success = decode_type( packet , store.pending_values_.ori[ id ] ) ; break ;
+            case DATA_TRACKER_STATUS:    success = decode_type( packet , store.pending_values_.status[ id ] ) ; break ;
+            case DATA_TRACKER_ACCEL:     success = decode_type( packet , store.pending_values_.accel[ id ] ) ; break ;
+            case DATA_TRACKER_TRGTPOS:   success = decode_type( packet , store.pending_values_.target_pos[ id ] ) ; break ;
+            case DATA_TRACKER_TIMESTAMP: success = decode_type( packet , store.pending_values_.timestamp[ id ] ) ; break ;
+            default:                     return true ;
+            }
+            if ( success )
+                store.set_field( id , child_header.id ) ;
+            return success ;
+        } ) ;
+}
+
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 template< typename type >
 bool
@@ -0,0 +1,212 @@
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Standalone decoder checks, no test framework needed:
+//   g++ -std=c++17 -O2 -I. psn_decoder_test.cpp -o psn_decoder_test && ./psn_decoder_test
+// Exits with 0 when every check passes.
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+#include "psn_lib.hpp"
+
+#include <cstdio>
+#include <list>
+#include <string>
+
+namespace
+{
+
+int failures = 0 ;
+
+#define CHECK( condition ) check( ( condition ) , #condition , __LINE__ )
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void check( bool condition , const char * text , int line )
+{
+    if ( condition )
+        return ;
+
+    ::std::printf( "line %d: %s\n" , line , text ) ;
+    ++failures ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Enough trackers for a frame of several packets, each frame with its own values
+::std::list< ::std::string > make_frame( ::psn::psn_encoder & encoder , uint64_t timestamp , float value )
+{
+    ::psn::tracker_map trackers ;
+    for ( uint16_t id = 0 ; id < 300 ; ++id )
+    {
+        ::psn::tracker tracker( id ) ;
+        tracker.set_pos( ::psn::float3( value , (float)id , 0 ) ) ;
+        tracker.set_speed( ::psn::float3( 0 , value , (float)id ) ) ;
+        trackers[ id ] = tracker ;
+    }
+
+    return encoder.encode_data( trackers , timestamp ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Counts the trackers of the last complete frame holding pos and speed made from value
+size_t count_store_trackers( const ::psn::tracker_store & store , float value )
+{
+    size_t count = 0 ;
+    for ( ::psn::tracker_store::const_iterator it = store.begin() ; it != store.end() ; ++it )
+    {
+        uint16_t id = *it ;
+        if ( !store.is_field_set( id , ::psn::DATA_TRACKER_POS ) || !store.is_field_set( id , ::psn::DATA_TRACKER_SPEED ) )
+            continue ;
+        if ( store.get_pos( id ).x == value && store.get_pos( id ).y == (float)id && store.get_speed( id ).y == value )
+            ++count ;
+    }
+
+    return count ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// A frame missing its last packet is closed by the first packet of the next one.
+// It must be readable right after that packet is decoded, even though the same
+// packet already started filling the next frame.
+void test_early_closed_frame( void )
+{
+    ::psn::psn_encoder encoder( "test" ) ;
+    ::std::list< ::std::string > first = make_frame( encoder , 1 , 1.0f ) ;
+    ::std::list< ::std::string > second = make_frame( encoder , 2 , 2.0f ) ;
+    CHECK( first.size() >= 3 && second.size() >= 3 ) ;
+
+    // The map decoder is the reference for which trackers make up the closed frame
+    ::psn::psn_decoder decoder( ::psn::psn_decoder::MODE_TRACKER_STORE ) ;
+    ::psn::psn_decoder reference( ::psn::psn_decoder::MODE_TRACKER_MAP ) ;
+    const ::psn::tracker_store & store = decoder.get_tracker_store() ;
+
+    // Every packet of the first frame but the last
+    ::std::list< ::std::string >::const_iterator last = --first.end() ;
+    for ( ::std::list< ::std::string >::const_iterator it = first.begin() ; it != last ; ++it )
+    {
+        CHECK( decoder.decode( it->data() , it->size() ) ) ;
+        reference.decode( it->data() , it->size() ) ;
+        CHECK( decoder.get_stats().data_frames == 0 ) ;
+    }
+
+    CHECK( decoder.decode( second.front().data() , second.front().size() ) ) ;
+    reference.decode( second.front().data() , second.front().size() ) ;
+    CHECK( decoder.get_stats().data_frames == 1 ) ;
+    CHECK( decoder.get_stats().incomplete_frames == 1 ) ;
+
+    size_t first_trackers = reference.get_data().trackers.size() ;
+    CHECK( first_trackers > 0 && first_trackers < 300 ) ;
+    CHECK( store.updated_count() == first_trackers ) ;
+    CHECK( count_store_trackers( store , 1.0f ) == first_trackers ) ;
+    CHECK( count_store_trackers( store , 2.0f ) == 0 ) ;
+
+    // The second frame replaces it once all its packets are in
+    for ( ::std::list< ::std::string >::const_iterator it = ++second.begin() ; it != second.end() ; ++it )
+    {
+        CHECK( count_store_trackers( store , 1.0f ) == first_trackers ) ;
+        CHECK( decoder.decode( it->data() , it->size() ) ) ;
+    }
+
+    CHECK( decoder.get_stats().data_frames == 2 ) ;
+    CHECK( store.updated_count() == 300 ) ;
+    CHECK( count_store_trackers( store , 2.0f ) == 300 ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// A frame closed early by a one packet frame is committed in the same decode()
+// as that frame, the handler must see both of them in order
+void test_two_frames_in_one_decode( void )
+{
+    ::psn::psn_encoder encoder( "test" ) ;
+    ::std::list< ::std::string > first = make_frame( encoder , 1 , 1.0f ) ;
+    CHECK( first.size() >= 2 ) ;
+
+    ::psn::tracker_map small ;
+    small[ 7 ] = ::psn::tracker( 7 ) ;
+    small[ 7 ].set_pos( ::psn::float3( 3.0f , 7 , 0 ) ) ;
+    small[ 7 ].set_speed( ::psn::float3( 0 , 3.0f , 7 ) ) ;
+    ::std::list< ::std::string > second = encoder.encode_data( small , 2 ) ;
+    CHECK( second.size() == 1 ) ;
+
+    ::std::list< size_t > first_counts ;
+    ::std::list< size_t > second_counts ;
+    ::psn::psn_decoder decoder( ::psn::psn_decoder::MODE_TRACKER_STORE ) ;
+    decoder.set_frame_handler( [&]( const ::psn::psn_decoder & frame_decoder )
+        {
+            first_counts.push_back( count_store_trackers( frame_decoder.get_tracker_store() , 1.0f ) ) ;
+            second_counts.push_back( count_store_trackers( frame_decoder.get_tracker_store() , 3.0f ) ) ;
+        } ) ;
+
+    ::std::list< ::std::string >::const_iterator last = --first.end() ;
+    for ( ::std::list< ::std::string >::const_iterator it = first.begin() ; it != last ; ++it )
+        CHECK( decoder.decode( it->data() , it->size() ) ) ;
+    CHECK( first_counts.empty() ) ;
+
+    CHECK( decoder.decode( second.front().data() , second.front().size() ) ) ;
+    CHECK( decoder.get_stats().data_frames == 2 ) ;
+    CHECK( decoder.get_stats().incomplete_frames == 1 ) ;
+    CHECK( first_counts.size() == 2 && second_counts.size() == 2 ) ;
+    if ( first_counts.size() != 2 || second_counts.size() != 2 )
+        return ;
+
+    CHECK( first_counts.front() > 0 && first_counts.front() < 300 ) ;
+    CHECK( second_counts.front() == 0 ) ;
+    CHECK( first_counts.back() == 0 ) ;
+    CHECK( second_counts.back() == 1 ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Trackers left out of a frame must not show up with the fields of an older one
+void test_tracker_left_out( void )
+{
+    ::psn::psn_encoder encoder( "test" ) ;
+    ::psn::psn_decoder decoder( ::psn::psn_decoder::MODE_TRACKER_STORE ) ;
+    const ::psn::tracker_store & store = decoder.get_tracker_store() ;
+
+    ::psn::tracker_map trackers ;
+    trackers[ 1 ] = ::psn::tracker( 1 ) ;
+    trackers[ 2 ] = ::psn::tracker( 2 ) ;
+    ::std::list< ::std::string > packets = encoder.encode_data( trackers , 1 ) ;
+    for ( ::std::list< ::std::string >::const_iterator it = packets.begin() ; it != packets.end() ; ++it )
+        decoder.decode( it->data() , it->size() ) ;
+    CHECK( store.updated_count() == 2 ) ;
+
+    trackers.erase( 2 ) ;
+    packets = encoder.encode_data( trackers , 2 ) ;
+    for ( ::std::list< ::std::string >::const_iterator it = packets.begin() ; it != packets.end() ; ++it )
+        decoder.decode( it->data() , it->size() ) ;
+    CHECK( store.updated_count() == 1 ) ;
+    CHECK( store.get_fields( 1 ) != 0 ) ;
+    CHECK( store.get_fields( 2 ) == 0 ) ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// A tracker with pos unset is sent without a pos chunk
+void test_tracker_without_pos( void )
+{
+    ::psn::psn_encoder encoder( "test" ) ;
+    ::psn::psn_decoder decoder( ::psn::psn_decoder::MODE_TRACKER_STORE ) ;
+    const ::psn::tracker_store & store = decoder.get_tracker_store() ;
+
+    ::psn::tracker_map trackers ;
+    trackers[ 1 ] = ::psn::tracker( 1 ) ;
+    trackers[ 1 ].unset_pos() ;
+    trackers[ 1 ].set_speed( ::psn::float3( 1 , 2 , 3 ) ) ;
+    ::std::list< ::std::string > packets = encoder.encode_data( trackers , 1 ) ;
+    for ( ::std::list< ::std::string >::const_iterator it = packets.begin() ; it != packets.end() ; ++it )
+        decoder.decode( it->data() , it->size() ) ;
+
+    CHECK( store.updated_count() == 1 ) ;
+    CHECK( !store.is_field_set( 1 , ::psn::DATA_TRACKER_POS ) ) ;
+    CHECK( store.is_field_set( 1 , ::psn::DATA_TRACKER_SPEED ) ) ;
+}
+
+} // namespace
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+int main( void )
+{
+    test_early_closed_frame() ;
+    test_two_frames_in_one_decode() ;
+    test_tracker_left_out() ;
+    test_tracker_without_pos() ;
+
+    ::std::printf( failures == 0 ? "ok\n" : "%d failed\n" , failures ) ;
+    return failures == 0 ? 0 : 1 ;
+}
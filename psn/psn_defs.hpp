@@ -102,6 +102,7 @@ struct tracker
     void set_pos( const float3 & pos ) { pos_ = pos ; set_field( DATA_TRACKER_POS ) ; }
     float3 get_pos( void ) const { return pos_ ; }
     bool is_pos_set( void ) const { return is_field_set( DATA_TRACKER_POS ) ; }
+    void unset_pos( void ) { unset_field( DATA_TRACKER_POS ) ; } // pos is set by default, a tracker may be sent without it
     
     void set_speed( const float3 & speed ) { speed_ = speed ; set_field( DATA_TRACKER_SPEED ) ; }
     float3 get_speed( void ) const { return speed_ ; }
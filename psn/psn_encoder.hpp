@@ -30,6 +30,8 @@
 #include "psn_defs.hpp"
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <list>
 #include <string>
 
@@ -45,12 +47,32 @@ public:
     ::std::list< ::std::string > encode_info( const tracker_map & trackers , uint64_t timestamp_usec ) ;
     ::std::list< ::std::string > encode_data( const tracker_map & trackers , uint64_t timestamp_usec ) ;
 
+    // Allocation free versions: each packet of the frame is written into buffer, then handed to
+    // sink( const char * data , size_t size ) before the next one is written over it.
+    // trackers is a tracker_map or any other container of trackers, buffer_size should be MAX_UDP_PACKET_SIZE.
+    // Returns the number of packets in the frame.
+    template< typename trackers_type , typename sink_type >
+    size_t encode_info( const trackers_type & trackers , uint64_t timestamp_usec , char * buffer , size_t buffer_size , sink_type && sink ) ;
+    template< typename trackers_type , typename sink_type >
+    size_t encode_data( const trackers_type & trackers , uint64_t timestamp_usec , char * buffer , size_t buffer_size , sink_type && sink ) ;
+
     uint8_t get_last_info_frame_id( void ) const { return info_frame_id ; }
     uint8_t get_last_data_frame_id( void ) const { return data_frame_id ; }
 
 private:
     typedef ::psn::packet< char > packet_t ;
 
+    template< typename trackers_type , typename sink_type >
+    size_t encode_frame( const trackers_type & trackers , bool info , uint8_t frame_id , uint64_t timestamp_usec , char * buffer , size_t buffer_size , sink_type & sink ) ;
+    template< typename iterator_type >
+    size_t fill_packet( iterator_type & tracker_it , const iterator_type & tracker_end , bool info , uint8_t frame_id , uint64_t timestamp_usec ,
+                        char * buffer , size_t buffer_size , size_t & packet_count_offset ) ;
+
+    static uint16_t get_tracker_id( const tracker_map::value_type & value ) { return value.first ; }
+    static uint16_t get_tracker_id( const tracker & value ) { return value.get_id() ; }
+    static const tracker & get_tracker( const tracker_map::value_type & value ) { return value.second ; }
+    static const tracker & get_tracker( const tracker & value ) { return value ; }
+
     chunk_header * fill_chunk_header( packet_t & packet , uint16_t id , bool has_subchunks , size_t data_len ) ;
     packet_header * fill_packet_header( packet_t & packet , uint16_t chunk_id , uint8_t frame_id , uint64_t timestamp_usec ) ;
 
@@ -0,0 +1,168 @@
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Standalone comparison of the encoder APIs, no benchmark framework needed:
+//   g++ -std=c++17 -O2 -I. psn_encoder_bench.cpp -o psn_encoder_bench && ./psn_encoder_bench
+// Times data frames through the std::list API and through the buffer API,
+// from a tracker_map and from a reused vector of trackers, after checking
+// that every API writes the same bytes. Exits with 1 if they differ.
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+#include "psn_lib.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Keeps the bytes of every packet, for checking the output
+struct copy_sink
+{
+    ::std::list< ::std::string > * packets ;
+
+    void operator()( const char * data , size_t size ) { packets->push_back( ::std::string( data , size ) ) ; }
+} ;
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Only touches the packets, as a socket send would
+struct count_sink
+{
+    size_t * bytes ;
+
+    void operator()( const char * data , size_t size ) { *bytes += size + (unsigned char)data[ 0 ] ; }
+} ;
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+void make_trackers( size_t count , ::psn::tracker_map & map , ::std::vector< ::psn::tracker > & vector )
+{
+    map.clear() ;
+    vector.clear() ;
+    for ( uint16_t id = 0 ; id < count ; ++id )
+    {
+        ::psn::tracker tracker( id ) ;
+        tracker.set_pos( ::psn::float3( (float)id , 1 , 2 ) ) ;
+        tracker.set_speed( ::psn::float3( 0 , (float)id , 0 ) ) ;
+        tracker.set_ori( ::psn::float3( 0 , 0 , (float)id ) ) ;
+        tracker.set_status( 0.5f ) ;
+        tracker.set_timestamp( id ) ;
+        map[ id ] = tracker ;
+        vector.push_back( tracker ) ;
+    }
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Every API must write the same packets for the same frame
+bool check_same_output( const ::psn::tracker_map & map , const ::std::vector< ::psn::tracker > & vector )
+{
+    char buffer[ ::psn::MAX_UDP_PACKET_SIZE ] ;
+
+    ::psn::psn_encoder list_encoder( "bench" ) ;
+    ::std::list< ::std::string > list_packets = list_encoder.encode_data( map , 1 ) ;
+
+    ::psn::psn_encoder map_encoder( "bench" ) ;
+    ::std::list< ::std::string > map_packets ;
+    copy_sink map_sink = { &map_packets } ;
+    map_encoder.encode_data( map , 1 , buffer , sizeof( buffer ) , map_sink ) ;
+
+    ::psn::psn_encoder vector_encoder( "bench" ) ;
+    ::std::list< ::std::string > vector_packets ;
+    copy_sink vector_sink = { &vector_packets } ;
+    vector_encoder.encode_data( vector , 1 , buffer , sizeof( buffer ) , vector_sink ) ;
+
+    return list_packets == map_packets && list_packets == vector_packets ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+// Best nanoseconds per frame of a few rounds, so a single preemption does not count
+template< typename encode_type >
+double time_frames( encode_type & encode , size_t frames )
+{
+    double best = 0 ;
+    for ( int round = 0 ; round < 5 ; ++round )
+    {
+        ::std::chrono::steady_clock::time_point start = ::std::chrono::steady_clock::now() ;
+        for ( size_t i = 0 ; i < frames ; ++i )
+            encode( i ) ;
+        ::std::chrono::duration< double , ::std::nano > elapsed = ::std::chrono::steady_clock::now() - start ;
+
+        double ns = elapsed.count() / (double)frames ;
+        if ( round == 0 || ns < best )
+            best = ns ;
+    }
+
+    return best ;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+struct list_encode
+{
+    ::psn::psn_encoder encoder ;
+    const ::psn::tracker_map * trackers ;
+    size_t bytes ;
+
+    void operator()( size_t timestamp )
+    {
+        ::std::list< ::std::string > packets = encoder.encode_data( *trackers , timestamp ) ;
+        for ( ::std::list< ::std::string >::const_iterator it = packets.begin() ; it != packets.end() ; ++it )
+            bytes += it->size() + (unsigned char)( *it )[ 0 ] ;
+    }
+} ;
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+template< typename trackers_type >
+struct buffer_encode
+{
+    ::psn::psn_encoder encoder ;
+    const trackers_type * trackers ;
+    size_t bytes ;
+    char buffer[ ::psn::MAX_UDP_PACKET_SIZE ] ;
+
+    void operator()( size_t timestamp )
+    {
+        count_sink sink = { &bytes } ;
+        encoder.encode_data( *trackers , timestamp , buffer , sizeof( buffer ) , sink ) ;
+    }
+} ;
+
+} // namespace
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+int main( void )
+{
+    static const size_t tracker_counts[] = { 1 , 8 , 64 , 300 } ;
+
+    bool ok = true ;
+    ::std::printf( "%9s %8s %14s %14s %14s\n" , "trackers" , "packets" , "list ns" , "buffer ns" , "vector ns" ) ;
+    for ( size_t i = 0 ; i < sizeof( tracker_counts ) / sizeof( tracker_counts[ 0 ] ) ; ++i )
+    {
+        ::psn::tracker_map map ;
+        ::std::vector< ::psn::tracker > vector ;
+        make_trackers( tracker_counts[ i ] , map , vector ) ;
+
+        if ( !check_same_output( map , vector ) )
+        {
+            ::std::printf( "%9zu output differs\n" , tracker_counts[ i ] ) ;
+            ok = false ;
+            continue ;
+        }
+
+        size_t frames = 2000000 / ( tracker_counts[ i ] + 8 ) ;
+
+        list_encode list = { ::psn::psn_encoder( "bench" ) , &map , 0 } ;
+        buffer_encode< ::psn::tracker_map > buffer = { ::psn::psn_encoder( "bench" ) , &map , 0 , {} } ;
+        buffer_encode< ::std::vector< ::psn::tracker > > buffer_vector = { ::psn::psn_encoder( "bench" ) , &vector , 0 , {} } ;
+
+        double list_ns = time_frames( list , frames ) ;
+        double buffer_ns = time_frames( buffer , frames ) ;
+        double vector_ns = time_frames( buffer_vector , frames ) ;
+
+        size_t packets = list.encoder.encode_data( map , 0 ).size() ;
+        ::std::printf( "%9zu %8zu %14.0f %14.0f %14.0f\n" , tracker_counts[ i ] , packets , list_ns , buffer_ns , vector_ns ) ;
+    }
+
+    return ok ? 0 : 1 ;
+}
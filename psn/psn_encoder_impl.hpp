@@ -48,118 +48,147 @@ psn_encoder::
 encode_info( const tracker_map & trackers , uint64_t timestamp_usec ) 
 {
     ::std::list< ::std::string > packets ;
-    auto tracker_it = trackers.begin() ;
-    size_t packet_count_offset = 0 ;
+    char buffer[ MAX_UDP_PACKET_SIZE ] ;
 
-    info_frame_id++ ;
+    encode_info( trackers , timestamp_usec , buffer , MAX_UDP_PACKET_SIZE , 
+                 [ &packets ]( const char * data , size_t size ) { packets.push_back( ::std::string( data , size ) ) ; } ) ;
 
-    while ( tracker_it != trackers.end() )
-    {
-        char buffer[ MAX_UDP_PACKET_SIZE ] ;
-        packet_t packet( buffer , MAX_UDP_PACKET_SIZE ) ;
+    return packets ;
+}
 
-        // Main chunk header
-        chunk_header * main_chunk = fill_chunk_header( packet , INFO_PACKET , true , 0 /* to be computed*/ ) ;
-        if ( !main_chunk ) break ;
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+::std::list< ::std::string >
+psn_encoder::
+encode_data( const tracker_map & trackers , uint64_t timestamp_usec ) 
+{
+    ::std::list< ::std::string > packets ;
+    char buffer[ MAX_UDP_PACKET_SIZE ] ;
 
-        // Packet header
-        packet_header * packet_header = fill_packet_header( packet , INFO_PACKET_HEADER , info_frame_id , timestamp_usec ) ;
-        if ( !packet_header ) break ;
-        packet_count_offset = (char *)&packet_header->frame_packet_count - buffer ;
+    encode_data( trackers , timestamp_usec , buffer , MAX_UDP_PACKET_SIZE , 
+                 [ &packets ]( const char * data , size_t size ) { packets.push_back( ::std::string( data , size ) ) ; } ) ;
 
-        // System name
-        if ( !fill_string( packet , INFO_SYSTEM_NAME , system_name_ ) )
-            break ;
+    return packets ;
+}
 
-        // Tracker list
-        chunk_header * tracker_list_chunk = fill_chunk_header( packet , INFO_TRACKER_LIST , true , 0 /* to be computed*/ ) ;
-        if ( !tracker_list_chunk ) break ;
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+template< typename trackers_type , typename sink_type >
+size_t
+psn_encoder::
+encode_info( const trackers_type & trackers , uint64_t timestamp_usec , char * buffer , size_t buffer_size , sink_type && sink ) 
+{
+    info_frame_id++ ;
 
-        // Trackers
-        while ( tracker_it != trackers.end() )
-        {
-            packet_t backup_packet = packet ; // Used to backtrack if there is not enough space to encode the tracker
-            const ::psn::tracker & tracker = tracker_it->second ;
+    return encode_frame( trackers , true , info_frame_id , timestamp_usec , buffer , buffer_size , sink ) ;
+}
 
-            // Tracker chunk
-            chunk_header * tracker_chunk = fill_chunk_header( packet , tracker_it->first , true , 0 /* to be computed*/ ) ;
-            
-            if ( !tracker_chunk )
-            {
-                packet = backup_packet ;
-                break ;
-            }
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+template< typename trackers_type , typename sink_type >
+size_t
+psn_encoder::
+encode_data( const trackers_type & trackers , uint64_t timestamp_usec , char * buffer , size_t buffer_size , sink_type && sink ) 
+{
+    data_frame_id++ ;
 
-            // Tracker name
-            if ( !fill_string( packet , INFO_TRACKER_NAME , tracker.get_name() ) )
-            {
-                packet = backup_packet ;
-                break ;
-            }
+    return encode_frame( trackers , false , data_frame_id , timestamp_usec , buffer , buffer_size , sink ) ;
+}
 
-            tracker_chunk->data_len = packet.buffer - ( (char *)tracker_chunk + sizeof( chunk_header ) ) ;
-            tracker_list_chunk->data_len += tracker_chunk->data_len + sizeof( chunk_header ) ;
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+template< typename trackers_type , typename sink_type >
+size_t
+psn_encoder::
+encode_frame( const trackers_type & trackers , bool info , uint8_t frame_id , uint64_t timestamp_usec , char * buffer , size_t buffer_size , sink_type & sink ) 
+{
+    // Every packet carries the number of packets in the frame. A frame that fits in one 
+    // packet is handed on as soon as it is written, a larger one is counted first and 
+    // then written again packet by packet.
+    auto tracker_it = ::std::begin( trackers ) ;
+    auto tracker_end = ::std::end( trackers ) ;
+    size_t packet_count = 0 ;
+    size_t packet_count_offset = 0 ;
+    size_t packet_size = 0 ;
 
-            ++tracker_it ;
-        }
+    while ( tracker_it != tracker_end )
+    {
+        packet_size = fill_packet( tracker_it , tracker_end , info , frame_id , timestamp_usec , buffer , buffer_size , packet_count_offset ) ;
+        if ( packet_size == 0 ) break ;
 
-        main_chunk->data_len = packet.buffer - ( buffer + sizeof( chunk_header ) ) ;
+        ++packet_count ;
+    }
 
-        packets.push_back( ::std::string( buffer , MAX_UDP_PACKET_SIZE - packet.size ) ) ;
+    if ( packet_count == 1 )
+    {
+        buffer[ packet_count_offset ] = (char)packet_count ;
+        sink( (const char *)buffer , packet_size ) ;
     }
+    else if ( packet_count > 1 )
+    {
+        tracker_it = ::std::begin( trackers ) ;
 
-    // Apply packet count
-    for ( auto it = packets.begin() ; it != packets.end() ; ++it )
-        if ( it->size() > packet_count_offset )
-            (*it)[ packet_count_offset ] = (char)packets.size() ;
+        for ( size_t i = 0 ; i < packet_count ; ++i )
+        {
+            packet_size = fill_packet( tracker_it , tracker_end , info , frame_id , timestamp_usec , buffer , buffer_size , packet_count_offset ) ;
+            buffer[ packet_count_offset ] = (char)packet_count ;
+            sink( (const char *)buffer , packet_size ) ;
+        }
+    }
 
-    return packets ;
+    return packet_count ;
 }
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
-::std::list< ::std::string >
+template< typename iterator_type >
+size_t
 psn_encoder::
-encode_data( const tracker_map & trackers , uint64_t timestamp_usec ) 
+fill_packet( iterator_type & tracker_it , const iterator_type & tracker_end , bool info , uint8_t frame_id , uint64_t timestamp_usec ,
+             char * buffer , size_t buffer_size , size_t & packet_count_offset )
 {
-    ::std::list< ::std::string > packets ;
-    auto tracker_it = trackers.begin() ;
-    size_t packet_count_offset = 0 ;
+    packet_t packet( buffer , buffer_size ) ;
 
-    data_frame_id++ ;
+    // Main chunk header
+    chunk_header * main_chunk = fill_chunk_header( packet , info ? INFO_PACKET : DATA_PACKET , true , 0 /* to be computed*/ ) ;
+    if ( !main_chunk ) return 0 ;
 
-    while ( tracker_it != trackers.end() )
-    {
-        char buffer[ MAX_UDP_PACKET_SIZE ] ;
-        packet_t packet( buffer , MAX_UDP_PACKET_SIZE ) ;
+    // Packet header
+    packet_header * packet_header = fill_packet_header( packet , info ? INFO_PACKET_HEADER : DATA_PACKET_HEADER , frame_id , timestamp_usec ) ;
+    if ( !packet_header ) return 0 ;
+    packet_count_offset = (char *)&packet_header->frame_packet_count - buffer ;
 
-        // Main chunk header
-        chunk_header * main_chunk = fill_chunk_header( packet , DATA_PACKET , true , 0 /*to be computed*/ ) ;
-        if ( !main_chunk ) break ;
+    // System name
+    if ( info && !fill_string( packet , INFO_SYSTEM_NAME , system_name_ ) )
+        return 0 ;
 
-        // Packet header
-        packet_header * packet_header = fill_packet_header( packet , DATA_PACKET_HEADER , data_frame_id , timestamp_usec ) ;
-        if ( !packet_header ) break ;
-        packet_count_offset = (char *)&packet_header->frame_packet_count - buffer ;
+    // Tracker list
+    chunk_header * tracker_list_chunk = fill_chunk_header( packet , info ? INFO_TRACKER_LIST : DATA_TRACKER_LIST , true , 0 /* to be computed*/ ) ;
+    if ( !tracker_list_chunk ) return 0 ;
 
-        // Tracker list
-        chunk_header * tracker_list_chunk = fill_chunk_header( packet , DATA_TRACKER_LIST , true , 0 /*to be computed*/ ) ;
-        if ( !tracker_list_chunk ) break ;
+    // Trackers
+    iterator_type first_tracker_it = tracker_it ;
+
+    while ( tracker_it != tracker_end )
+    {
+        packet_t backup_packet = packet ; // Used to backtrack if there is not enough space to encode the tracker
+        const ::psn::tracker & tracker = get_tracker( *tracker_it ) ;
 
-        // Trackers
-        while ( tracker_it != trackers.end() )
+        // Tracker chunk
+        chunk_header * tracker_chunk = fill_chunk_header( packet , get_tracker_id( *tracker_it ) , true , 0 /* to be computed*/ ) ;
+
+        if ( !tracker_chunk )
         {
-            packet_t backup_packet = packet ; // Used to backtrack if there is not enough space to encode the tracker
-            const ::psn::tracker & tracker = tracker_it->second ;
+            packet = backup_packet ;
+            break ;
+        }
 
-            // Tracker chunk
-            chunk_header * tracker_chunk = fill_chunk_header( packet , tracker_it->first , true , 0 /*to be computed*/ ) ;
-            
-            if ( !tracker_chunk )
+        if ( info )
+        {
+            // Tracker name
+            if ( !fill_string( packet , INFO_TRACKER_NAME , tracker.get_name() ) )
             {
                 packet = backup_packet ;
                 break ;
             }
-
+        }
+        else
+        {
             // Tracker fields
             if ( tracker.is_pos_set()        && !fill_tracker_field( packet , DATA_TRACKER_POS ,       tracker.get_pos() ) ||
                  tracker.is_speed_set()      && !fill_tracker_field( packet , DATA_TRACKER_SPEED ,     tracker.get_speed() ) ||
@@ -172,23 +201,21 @@ encode_data( const tracker_map & trackers , uint64_t timestamp_usec )
                 packet = backup_packet ;
                 break ;
             }
-
-            tracker_chunk->data_len = packet.buffer - ( (char *)tracker_chunk + sizeof( chunk_header ) ) ;
-            tracker_list_chunk->data_len += tracker_chunk->data_len + sizeof( chunk_header ) ;
-            ++tracker_it ;
         }
 
-        main_chunk->data_len = packet.buffer - ( buffer + sizeof( chunk_header ) ) ;
+        tracker_chunk->data_len = packet.buffer - ( (char *)tracker_chunk + sizeof( chunk_header ) ) ;
+        tracker_list_chunk->data_len += tracker_chunk->data_len + sizeof( chunk_header ) ;
 
-        packets.push_back( ::std::string( buffer , MAX_UDP_PACKET_SIZE - packet.size ) ) ;
+        ++tracker_it ;
     }
 
-    // Apply packet count
-    for ( auto it = packets.begin() ; it != packets.end() ; ++it )
-        if ( it->size() > packet_count_offset )
-            (*it)[ packet_count_offset ] = (char)packets.size() ;
+    // A tracker too large for an empty packet can never be sent
+    if ( tracker_it == first_tracker_it )
+        return 0 ;
 
-    return packets ;
+    main_chunk->data_len = packet.buffer - ( buffer + sizeof( chunk_header ) ) ;
+
+    return buffer_size - packet.size ;
 }
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -224,6 +251,8 @@ fill_packet_header( packet_t & packet , uint16_t chunk_id , uint8_t frame_id , u
     if ( !header )
         return nullptr ;
 
+    // The struct padding is sent too, zero it so no stale buffer bytes go out
+    ::std::memset( (void *)header , 0 , sizeof( packet_header ) ) ;
     header->frame_id = frame_id ;
     header->timestamp_usec = timestamp_usec ;
     header->version_high = HIGH_VERSION ;